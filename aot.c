@@ -0,0 +1,271 @@
+#include "aot.h"
+#include "data.h"
+#include <stdio.h>
+
+// Exit statuses of the translated program when it stops before halting, the
+// .. same as the ones of the virtual machine, see vm/vm.h
+#define AOT_STACK_OVERFLOW_STATUS 6
+#define AOT_DIVISION_ERROR_STATUS 7
+
+/**
+ * Returns 1 if the instruction can be translated, 0 otherwise.
+ * */
+int isTranslatable(Instruction ins)
+{
+    int r = ins.r, l = ins.l, m = ins.m;
+
+    // Registers used by each instruction should be in the register file
+    switch(ins.op)
+    {
+        case LIT: case LOD: case STO: case JPC:
+        case SIO_WRITE: case SIO_READ: case ODD:
+            return r >= 0 && r < REGISTER_FILE_REG_COUNT;
+
+        case NEG:
+        case JEQ: case JNE: case JLT: case JLE: case JGT: case JGE:
+            return r >= 0 && r < REGISTER_FILE_REG_COUNT &&
+                   l >= 0 && l < REGISTER_FILE_REG_COUNT;
+
+        case SHF:
+            return r >= 0 && r < REGISTER_FILE_REG_COUNT &&
+                   l >= 0 && l < REGISTER_FILE_REG_COUNT &&
+                   m >= -31 && m <= 31;
+
+        case ADD: case SUB: case MUL: case DIV: case MOD:
+        case EQL: case NEQ: case LSS: case LEQ: case GTR: case GEQ:
+            return r >= 0 && r < REGISTER_FILE_REG_COUNT &&
+                   l >= 0 && l < REGISTER_FILE_REG_COUNT &&
+                   m >= 0 && m < REGISTER_FILE_REG_COUNT;
+
+        default:
+            return 1;
+    }
+}
+
+/**
+ * Writes the C expression of the stack index of the variable at lexicographic
+ * .. level difference l and offset m.
+ * */
+void printStackIndex(FILE* out, int l, int m)
+{
+    if(l <= 0) fprintf(out, "BP + %d", m);
+    else       fprintf(out, "base(BP, %d) + %d", l, m);
+}
+
+/**
+ * Writes the C statement for a jump to the given address: a goto if the
+ * .. address is in the code, otherwise a dispatch on the PC, which fails.
+ * */
+void printJump(FILE* out, int target, int codeLength)
+{
+    if(target >= 0 && target < codeLength) fprintf(out, "goto L%d;", target);
+    else                                   fprintf(out, "{ PC = %d; goto dispatch; }", target);
+}
+
+int readCode(FILE* in, Instruction* code, int maxLength)
+{
+    int count = 0;
+
+    if(!in) return 0;
+
+    while(count < maxLength &&
+          fscanf(in, "%d %d %d %d", &code[count].op, &code[count].r, &code[count].l, &code[count].m) == 4)
+    {
+        count++;
+    }
+
+    return count;
+}
+
+int translateCodeToC(Instruction* code, int codeLength, FILE* out)
+{
+    if(!out) return -1;
+
+    for(int i = 0; i < codeLength; i++)
+    {
+        if(!isTranslatable(code[i])) return -1;
+    }
+
+    const char* relOps[] = {
+        [EQL] = "==", [NEQ] = "!=", [LSS] = "<", [LEQ] = "<=", [GTR] = ">", [GEQ] = ">=",
+        [JEQ] = "==", [JNE] = "!=", [JLT] = "<", [JLE] = "<=", [JGT] = ">", [JGE] = ">="
+    };
+
+    const char* arithOps[] = {
+        [ADD] = "+", [SUB] = "-", [MUL] = "*", [DIV] = "/", [MOD] = "%"
+    };
+
+    /* Prologue ***************************************************************/
+    fprintf(out,
+        "/* PM/0 code compiled ahead of time to C. Do not edit. */\n"
+        "#include <stdio.h>\n"
+        "#include <stdlib.h>\n"
+        "#include <limits.h>\n"
+        "\n"
+        "static int stack[%d];\n"
+        "\n"
+        "/* Base pointer of the activation record L levels down */\n"
+        "static int base(int bp, int L)\n"
+        "{\n"
+        "    while(L > 0) { bp = stack[bp + 1]; L--; }\n"
+        "    return bp;\n"
+        "}\n"
+        "\n"
+        "static void illegal(int op)\n"
+        "{\n"
+        "    fprintf(stderr, \"VM cannot execute illegal instruction with op code: %%d\\n\", op);\n"
+        "    fprintf(stderr, \"Terminating VM..\\n\");\n"
+        "    exit(-1);\n"
+        "}\n"
+        "\n"
+        "static void badReturn(int pc)\n"
+        "{\n"
+        "    fprintf(stderr, \"VM cannot return or jump to address %%d, which does not follow a CAL\\n\", pc);\n"
+        "    fprintf(stderr, \"Terminating VM..\\n\");\n"
+        "    exit(-1);\n"
+        "}\n"
+        "\n"
+        "/* Stops as the VM does when it cannot go on: with the output written so far */\n"
+        "static void stop(int status, const char* reason)\n"
+        "{\n"
+        "    fflush(stdout);\n"
+        "    fprintf(stderr, \"VM stopped: %%s\\n\", reason);\n"
+        "    exit(status);\n"
+        "}\n"
+        "\n"
+        "static void stackOverflow(void)\n"
+        "{\n"
+        "    stop(%d, \"stack overflow, more than MAX_STACK_HEIGHT(%d) slots needed\");\n"
+        "}\n"
+        "\n"
+        "static void divisionError(void)\n"
+        "{\n"
+        "    stop(%d, \"division by zero, or of INT_MIN by -1\");\n"
+        "}\n"
+        "\n"
+        "int main(void)\n"
+        "{\n"
+        "    int BP = 1, SP = 0, PC = 0;\n",
+        MAX_STACK_HEIGHT, AOT_STACK_OVERFLOW_STATUS, MAX_STACK_HEIGHT, AOT_DIVISION_ERROR_STATUS);
+
+    // Register file
+    fprintf(out, "    int");
+    for(int i = 0; i < REGISTER_FILE_REG_COUNT; i++)
+        fprintf(out, " r%d = 0%s", i, i + 1 < REGISTER_FILE_REG_COUNT ? "," : ";\n");
+
+    fprintf(out, "\n    goto L0;\n\n");
+
+    // Returns jump to addresses on the stack, so the PC is dispatched. Only
+    // .. the instructions following a CAL are returned to, and a case for
+    // .. every instruction would keep every register live across every
+    // .. label, slowing the C compiler down.
+    fprintf(out, "dispatch:\n    switch(PC)\n    {\n");
+    for(int i = 0; i + 1 < codeLength; i++)
+    {
+        if(code[i].op == CAL)
+            fprintf(out, "        case %d: goto L%d;\n", i + 1, i + 1);
+    }
+    fprintf(out, "        default: badReturn(PC);\n    }\n\n");
+
+    /* Instructions ***********************************************************/
+    for(int i = 0; i < codeLength; i++)
+    {
+        Instruction c = code[i];
+
+        fprintf(out, "L%d: ", i);
+
+        switch(c.op)
+        {
+            case LIT:
+                fprintf(out, "r%d = %d;", c.r, c.m);
+                break;
+            case RTN:
+                fprintf(out, "SP = BP - 1; BP = stack[SP + 3]; PC = stack[SP + 4]; "
+                             "if(!PC && !BP && !SP) goto halt; goto dispatch;");
+                break;
+            case LOD:
+                fprintf(out, "r%d = stack[", c.r);
+                printStackIndex(out, c.l, c.m);
+                fprintf(out, "];");
+                break;
+            case STO:
+                fprintf(out, "stack[");
+                printStackIndex(out, c.l, c.m);
+                fprintf(out, "] = r%d;", c.r);
+                break;
+            // The stack grows past MAX_STACK_HEIGHT in recursive code, which
+            // .. the VM checks for at run time as well
+            case CAL:
+                fprintf(out, "if(SP + %d >= %d) stackOverflow(); ", AR_VARIABLE_OFFSET, MAX_STACK_HEIGHT);
+                fprintf(out, "stack[SP + 1] = 0; stack[SP + 2] = ");
+                if(c.l > 0) fprintf(out, "base(BP, %d)", c.l);
+                else        fprintf(out, "BP");
+                fprintf(out, "; stack[SP + 3] = BP; stack[SP + 4] = %d; BP = SP + 1; ", i + 1);
+                printJump(out, c.m, codeLength);
+                break;
+            case INC:
+                fprintf(out, "if(SP + %d >= %d) stackOverflow(); SP += %d;", c.m, MAX_STACK_HEIGHT, c.m);
+                break;
+            case JMP:
+                printJump(out, c.m, codeLength);
+                break;
+            case JPC:
+                fprintf(out, "if(r%d == 0) ", c.r);
+                printJump(out, c.m, codeLength);
+                break;
+            case JEQ: case JNE: case JLT: case JLE: case JGT: case JGE:
+                fprintf(out, "if(r%d %s r%d) ", c.r, relOps[c.op], c.l);
+                printJump(out, c.m, codeLength);
+                break;
+            case SIO_WRITE:
+                fprintf(out, "printf(\"%%d \", r%d);", c.r);
+                break;
+            case SIO_READ:
+                fprintf(out, "scanf(\"%%d\", &r%d);", c.r);
+                break;
+            case SIO_HALT:
+                fprintf(out, "goto halt;");
+                break;
+            // Signed overflow is undefined in C, and the C compiler
+            // .. optimizes on it, so the arithmetic that can overflow is
+            // .. done on unsigned ints, wrapping around as the VM does
+            case NEG:
+                fprintf(out, "r%d = (int)(0u - (unsigned int)r%d);", c.r, c.l);
+                break;
+            case ADD: case SUB: case MUL:
+                fprintf(out, "r%d = (int)((unsigned int)r%d %s (unsigned int)r%d);", c.r, c.l, arithOps[c.op], c.m);
+                break;
+            // A division by zero, or of INT_MIN by -1, traps in C as well
+            case DIV: case MOD:
+                fprintf(out, "if(r%d == 0 || (r%d == -1 && r%d == INT_MIN)) divisionError(); ", c.m, c.m, c.l);
+                fprintf(out, "r%d = r%d %s r%d;", c.r, c.l, arithOps[c.op], c.m);
+                break;
+            case SHF:
+                if(c.m >= 0) fprintf(out, "r%d = (int)((unsigned int)r%d << %d);", c.r, c.l, c.m);
+                else         fprintf(out, "r%d = (int)(r%d / %lldLL);", c.r, c.l, 1LL << -c.m);
+                break;
+            case ODD:
+                fprintf(out, "r%d = r%d %% 2;", c.r, c.r);
+                break;
+            case EQL: case NEQ: case LSS: case LEQ: case GTR: case GEQ:
+                fprintf(out, "r%d = r%d %s r%d;", c.r, c.l, relOps[c.op], c.m);
+                break;
+            default:
+                fprintf(out, "illegal(%d);", c.op);
+                break;
+        }
+
+        fprintf(out, "\n");
+    }
+
+    // Running past the last instruction
+    fprintf(out, "    PC = %d; goto dispatch;\n\n", codeLength);
+
+    /* Epilogue ***************************************************************/
+    fprintf(out,
+        "halt:\n"
+        "    return 0;\n"
+        "}\n");
+
+    return 0;
+}
@@ -0,0 +1,37 @@
+#ifndef __AOT_H__
+#define __AOT_H__
+
+#include <stdio.h>
+#include "data.h"
+
+/**
+ * Ahead-of-time compilation of PM/0 code to C.
+ *
+ * The generated translation unit is a standalone program that behaves the
+ * .. same as running the code on the virtual machine: SIO instructions read
+ * .. from stdin and write to stdout in the same format as the VM does.
+ * Where the VM stops before the program halts, on a stack overflow or a
+ * .. division by zero, the program stops after flushing its output, with the
+ * .. VM's reason on stderr and the VM's exit status.
+ * Each instruction is translated to a labeled C statement, the registers are
+ * .. local variables, and the activation records live on an explicit stack
+ * .. array. Static jump and call targets become gotos, and the return
+ * .. addresses are dispatched through a switch on the program counter.
+ * */
+
+/**
+ * Reads the list of instructions from the given file, in the format the code
+ * .. generator prints, to code. At most maxLength instructions are read.
+ * Returns the number of instructions read.
+ * */
+int readCode(FILE*, Instruction* code, int maxLength);
+
+/**
+ * Translates the given code to a C translation unit written to out.
+ * Returns 0 on success. Returns -1 and writes nothing if the code contains
+ * .. an instruction that cannot be translated, e.g. it refers to a register
+ * .. out of the register file.
+ * */
+int translateCodeToC(Instruction* code, int codeLength, FILE* out);
+
+#endif
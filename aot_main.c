@@ -0,0 +1,77 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "data.h"
+#include "aot.h"
+
+int main(int argc, char **argv)
+{
+    FILE *inp, *outp;
+    Instruction code[MAX_CODE_LENGTH];
+
+    /**********************************/
+    /* Parse Command Line Arguments */
+    /**********************************/
+    if(argc < 3 || argc > 4)
+    {
+        fprintf(stderr, "Usage: ./aot.out (cg_output_file) (c_output_file) [executable]\n");
+
+        fprintf(stderr, "\n       cg_output_file: The path to the file containing the PM/0 code generated by the code generator.\n");
+
+        fprintf(stderr, "\n       c_output_file: The path to the file to write the C translation of the PM/0 code.\n");
+
+        fprintf(stderr, "\n       executable: If given, the C translation is compiled with the system C compiler to this path. Running it is the same as running the PM/0 code on the VM, except that only the output of the SIO instructions is printed, on stdout.\n");
+        return -1;
+    }
+
+    // open the input file for reading
+    if( !(inp = fopen(argv[1], "r")) )
+    {
+        fprintf(stderr, "Could not open \"%s\"\n", argv[1]);
+        return -1;
+    }
+
+    int codeLength = readCode(inp, code, MAX_CODE_LENGTH);
+    fclose(inp);
+
+    // Code generator errors are not code
+    if(codeLength == 0)
+    {
+        fprintf(stderr, "\"%s\" does not contain PM/0 code\n", argv[1]);
+        return -1;
+    }
+
+    // open the output file for writing
+    if( !(outp = fopen(argv[2], "w")) )
+    {
+        fprintf(stderr, "Could not open \"%s\"\n", argv[2]);
+        return -1;
+    }
+
+    /**********************************/
+    /***** Translate and compile ******/
+    /**********************************/
+    int err = translateCodeToC(code, codeLength, outp);
+    fclose(outp);
+
+    if(err)
+    {
+        fprintf(stderr, "Could not translate \"%s\": the code refers to a register out of the register file\n", argv[1]);
+        return -1;
+    }
+
+    if(argc == 4)
+    {
+        // The translation has no dependency other than the C standard library
+        char command[1024];
+        snprintf(command, sizeof(command), "cc -O2 -o \"%s\" \"%s\"", argv[3], argv[2]);
+
+        if(system(command))
+        {
+            fprintf(stderr, "Could not compile \"%s\"\n", argv[2]);
+            return -1;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,110 @@
+#include "arena.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Offset of the allocations from the start of a block, keeping them aligned
+#define ARENA_HEADER_SIZE ((sizeof(ArenaBlock) + ARENA_ALIGNMENT - 1) & ~(size_t)(ARENA_ALIGNMENT - 1))
+
+size_t alignArenaSize(size_t size)
+{
+    return (size + ARENA_ALIGNMENT - 1) & ~(size_t)(ARENA_ALIGNMENT - 1);
+}
+
+char* getArenaBlockData(ArenaBlock* block)
+{
+    return (char*)block + ARENA_HEADER_SIZE;
+}
+
+void initArena(Arena* arena)
+{
+    arena->first = NULL;
+    arena->current = NULL;
+    arena->last = NULL;
+}
+
+void deleteArena(Arena* arena)
+{
+    if(!arena) return;
+
+    ArenaBlock* block = arena->first;
+    while(block)
+    {
+        ArenaBlock* next = block->next;
+        free(block);
+        block = next;
+    }
+
+    initArena(arena);
+}
+
+void resetArena(Arena* arena)
+{
+    // The following blocks are emptied as they are reached again
+    arena->current = arena->first;
+    if(arena->current) arena->current->used = 0;
+
+    arena->last = NULL;
+}
+
+void* arenaAlloc(Arena* arena, size_t size)
+{
+    if(!arena) return malloc(size);
+
+    size = alignArenaSize(size);
+
+    // Move on to the next block until one has room, reusing the blocks
+    // .. left by resetArena() before allocating new ones
+    while(!arena->current || arena->current->used + size > arena->current->size)
+    {
+        if(arena->current && arena->current->next)
+        {
+            arena->current = arena->current->next;
+            arena->current->used = 0;
+            continue;
+        }
+
+        size_t blockSize = size > ARENA_BLOCK_SIZE ? size : ARENA_BLOCK_SIZE;
+        ArenaBlock* block = (ArenaBlock*)malloc(ARENA_HEADER_SIZE + blockSize);
+        block->next = NULL;
+        block->size = blockSize;
+        block->used = 0;
+
+        if(arena->current) arena->current->next = block;
+        else               arena->first = block;
+
+        arena->current = block;
+    }
+
+    void* ptr = getArenaBlockData(arena->current) + arena->current->used;
+    arena->current->used += size;
+    arena->last = ptr;
+
+    return ptr;
+}
+
+void* arenaRealloc(Arena* arena, void* ptr, size_t oldSize, size_t newSize)
+{
+    if(!arena) return realloc(ptr, newSize);
+
+    if(ptr && ptr == arena->last)
+    {
+        ArenaBlock* block = arena->current;
+        size_t offset = (char*)ptr - getArenaBlockData(block);
+
+        if(offset + alignArenaSize(newSize) <= block->size)
+        {
+            block->used = offset + alignArenaSize(newSize);
+            return ptr;
+        }
+    }
+
+    void* newPtr = arenaAlloc(arena, newSize);
+    if(ptr) memcpy(newPtr, ptr, oldSize < newSize ? oldSize : newSize);
+
+    return newPtr;
+}
+
+void arenaFree(Arena* arena, void* ptr)
+{
+    if(!arena) free(ptr);
+}
@@ -0,0 +1,77 @@
+#ifndef __ARENA_H__
+#define __ARENA_H__
+
+#include <stddef.h>
+
+/**
+ * The size of the blocks an arena allocates, unless an allocation needs a
+ * .. larger one.
+ * */
+#define ARENA_BLOCK_SIZE (64 * 1024)
+
+/**
+ * The alignment of the allocations in an arena.
+ * */
+#define ARENA_ALIGNMENT 16
+
+typedef struct ArenaBlock ArenaBlock;
+
+struct ArenaBlock {
+    ArenaBlock* next;
+    size_t size; // bytes for the allocations, following the header
+    size_t used;
+};
+
+/**
+ * Bump allocator owning the data of a compilation: the source code, the
+ * .. tokens and the symbols. Allocating is bumping a pointer in the current
+ * .. block, and all the allocations are released at once by resetArena(),
+ * .. which keeps the blocks for the next compilation, or by deleteArena().
+ * The allocations never move, so the pointers to them stay valid until the
+ * .. arena is reset.
+ *
+ * The functions below take NULL for the arena, in which case they allocate
+ * .. from the heap as malloc(), realloc() and free() do. So that a list can
+ * .. live either in an arena or on the heap, with the same code.
+ * */
+typedef struct {
+    ArenaBlock* first;
+    ArenaBlock* current;
+
+    // The last allocation, which arenaRealloc() grows in place if it can
+    void* last;
+} Arena;
+
+void initArena(Arena*);
+
+/**
+ * Frees the blocks of the arena.
+ * */
+void deleteArena(Arena*);
+
+/**
+ * Releases all the allocations in the arena, in constant time. The blocks
+ * .. are reused by the following allocations.
+ * */
+void resetArena(Arena*);
+
+/**
+ * Allocates size bytes, aligned to ARENA_ALIGNMENT in an arena.
+ * */
+void* arenaAlloc(Arena*, size_t size);
+
+/**
+ * Resizes the allocation at ptr, of oldSize bytes, to newSize bytes and
+ * .. returns its new address. In an arena, the last allocation is grown in
+ * .. place if the block has room for it. Otherwise, the contents are copied
+ * .. to a new allocation, and the old one is released with the arena.
+ * */
+void* arenaRealloc(Arena*, void* ptr, size_t oldSize, size_t newSize);
+
+/**
+ * Frees the allocation at ptr if it is on the heap. In an arena, it is
+ * .. released with the arena.
+ * */
+void arenaFree(Arena*, void* ptr);
+
+#endif
@@ -0,0 +1,301 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "../source_code.h"
+#include "../lexical_analyzer.h"
+#include "../token.h"
+#include "../code_generator.h"
+#include "../data.h"
+#include "../vm/vm.h"
+
+// Defined in vm/vm.c
+int readInstructions(FILE*, Instruction*);
+
+/**
+ * Phases of the compilation and the execution, timed separately
+ * */
+typedef enum {
+    LEX,
+    READ_TOKENS,
+    CODE_GENERATION,
+    READ_INSTRUCTIONS,
+    SIMULATION
+} BenchPhase;
+
+const char* benchPhaseNames[] = {
+    [LEX] = "lexicalAnalyzer",
+    [READ_TOKENS] = "readTokenList",
+    [CODE_GENERATION] = "codeGenerator",
+    [READ_INSTRUCTIONS] = "readInstructions",
+    [SIMULATION] = "simulateVM"
+};
+
+#define BENCH_PHASE_COUNT 5
+
+/**
+ * Returns the nanoseconds since an arbitrary point
+ * */
+long long getNanos()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return now.tv_sec * 1000000000LL + now.tv_nsec;
+}
+
+int compareLongLong(const void* a, const void* b)
+{
+    long long x = *(const long long*)a, y = *(const long long*)b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * Returns the p'th percentile of the sorted samples, by the nearest rank
+ * */
+long long getPercentile(long long* sorted, int count, int p)
+{
+    int rank = (p * count + 99) / 100;
+    return sorted[rank > 0 ? rank - 1 : 0];
+}
+
+/**
+ * Prints the statistics of the samples, in microseconds, as a JSON object
+ * .. to be placed after the given key. The samples are sorted.
+ * */
+void printSamples(FILE* out, const char* key, long long* samples, int count)
+{
+    qsort(samples, count, sizeof(long long), compareLongLong);
+
+    long long sum = 0;
+    for(int i = 0; i < count; i++) sum += samples[i];
+
+    fprintf(out, "        \"%s\": { \"min\": %.3f, \"median\": %.3f, \"p90\": %.3f, \"p99\": %.3f, \"max\": %.3f, \"mean\": %.3f }",
+        key,
+        samples[0] / 1e3,
+        getPercentile(samples, count, 50) / 1e3,
+        getPercentile(samples, count, 90) / 1e3,
+        getPercentile(samples, count, 99) / 1e3,
+        samples[count - 1] / 1e3,
+        (double)sum / count / 1e3);
+}
+
+/**
+ * Runs each phase on the source code at path runs times, filling samples of
+ * .. each phase with the nanoseconds of each run. The input of each phase is
+ * .. the output of the previous one, produced before the phase is timed.
+ * The metrics of the phases are added to stats, if it is not NULL.
+ * If arena is not NULL, the tokens and the symbols of each run are allocated
+ * .. in it, and released at once by resetting it after the run.
+ * Returns 0 on success, -1 if the source code does not compile.
+ * */
+int benchFile(const char* path, int runs, FILE* vmInput, long long* samples[], Stats* stats, Arena* arena)
+{
+    FILE* sourceFile = fopen(path, "r");
+
+    if(!sourceFile)
+    {
+        fprintf(stderr, "Could not open %s\n", path);
+        return -1;
+    }
+
+    char* sourceCode = readSourceCode(sourceFile);
+    fclose(sourceFile);
+
+    FILE* tokens = tmpfile();
+    FILE* code = tmpfile();
+    FILE* null = fopen("/dev/null", "w");
+    Instruction* instructions = (Instruction*)malloc(sizeof(Instruction) * MAX_CODE_LENGTH);
+    int ret = 0;
+
+    VMOptions options;
+    initVMOptions(&options);
+    options.stats = stats;
+
+    setLexerArena(arena);
+    setCGArena(arena);
+
+    for(int run = 0; run < runs && ret == 0; run++)
+    {
+        long long start = getNanos();
+        LexerOut lexerOut = lexicalAnalyzer(sourceCode);
+        samples[LEX][run] = getNanos() - start;
+
+        if(lexerOut.lexerError != NONE)
+        {
+            fprintf(stderr, "%s: lexer error on line %d\n", path, lexerOut.errorLine);
+            deleteLexerOut(&lexerOut);
+            ret = -1;
+            break;
+        }
+
+        rewind(tokens);
+        printTokenList(lexerOut.tokenList, tokens);
+        fflush(tokens);
+        deleteLexerOut(&lexerOut);
+
+        rewind(tokens);
+        start = getNanos();
+        TokenList tokenList = readTokenListInArena(tokens, arena);
+        samples[READ_TOKENS][run] = getNanos() - start;
+
+        rewind(code);
+        start = getNanos();
+        int err = codeGenerator(tokenList, code);
+        samples[CODE_GENERATION][run] = getNanos() - start;
+        fflush(code);
+        deleteTokenList(&tokenList);
+
+        if(err)
+        {
+            fprintf(stderr, "%s: code generator error %d\n", path, err);
+            ret = -1;
+            break;
+        }
+
+        rewind(code);
+        start = getNanos();
+        readInstructions(code, instructions);
+        samples[READ_INSTRUCTIONS][run] = getNanos() - start;
+
+        rewind(code);
+        if(vmInput) rewind(vmInput);
+        start = getNanos();
+        simulateVMWithOptions(code, null, vmInput, null, &options);
+        samples[SIMULATION][run] = getNanos() - start;
+
+        if(arena) resetArena(arena);
+    }
+
+    // Release the run that stopped at an error
+    if(arena) resetArena(arena);
+
+    free(instructions);
+    fclose(null);
+    fclose(code);
+    fclose(tokens);
+    deleteSourceCode(sourceCode);
+
+    return ret;
+}
+
+int main(int argc, char **argv)
+{
+    int runs = 20;
+    const char* inputPath = NULL;
+    const char* outputPath = NULL;
+    int optimizations = CG_OPT_LEVEL_2;
+
+    // Arena of the compilations, if they are allocated in one
+    Arena arena, *arenaPtr = NULL;
+    initArena(&arena);
+
+    // Metrics of the phases, written to stderr in statsFormat if requested
+    Stats stats, *statsPtr = NULL;
+    initStats(&stats, "pl0_bench_");
+    int statsFormat = -1;
+
+    int i = 1;
+    for(; i < argc && argv[i][0] == '-'; i++)
+    {
+        if(!strcmp(argv[i], "-r") && i + 1 < argc)      runs = atoi(argv[++i]);
+        else if(!strcmp(argv[i], "-i") && i + 1 < argc) inputPath = argv[++i];
+        else if(!strcmp(argv[i], "-o") && i + 1 < argc) outputPath = argv[++i];
+        else if(!strcmp(argv[i], "-O0"))                optimizations = CG_OPT_LEVEL_0;
+        else if(!strcmp(argv[i], "-O1"))                optimizations = CG_OPT_LEVEL_1;
+        else if(!strcmp(argv[i], "-O2"))                optimizations = CG_OPT_LEVEL_2;
+        else if(!strcmp(argv[i], "-a"))                 arenaPtr = &arena;
+        else if(!strcmp(argv[i], "--stats") && i + 1 < argc)
+        {
+            statsFormat = getStatsFormat(argv[++i]);
+            statsPtr = &stats;
+        }
+        else break;
+    }
+
+    if(i == argc || runs < 1 || (statsPtr && statsFormat < 0))
+    {
+        fprintf(stderr, "Usage: bench.out [-r runs] [-i vm_input] [-o out_json] [-O0|-O1|-O2] [-a] [--stats json|prometheus] (pl0_files...)\n");
+
+        fprintf(stderr, "\n       Compiles and runs each PL/0 program runs times, 20 by default, timing each\n");
+        fprintf(stderr, "       phase separately: %s", benchPhaseNames[0]);
+        for(int p = 1; p < BENCH_PHASE_COUNT; p++) fprintf(stderr, ", %s", benchPhaseNames[p]);
+        fprintf(stderr, ".\n");
+        fprintf(stderr, "\n       Reports the min, median, 90th and 99th percentile, max and mean time of\n");
+        fprintf(stderr, "       each phase, in microseconds, as JSON to out_json or to stdout.\n");
+        fprintf(stderr, "\n       -i: The input of the programs, empty by default.\n");
+        fprintf(stderr, "\n       -O0|-O1|-O2: The optimization level of the code generator, see\n");
+        fprintf(stderr, "       code_generator.out. -O2 by default.\n");
+        fprintf(stderr, "\n       -a: Allocate the tokens and the symbols of each run in an arena, released\n");
+        fprintf(stderr, "       at once after the run, instead of on the heap.\n");
+        fprintf(stderr, "\n       --stats: Write the metrics of the phases over all the runs to stderr, see\n");
+        fprintf(stderr, "       stats.h. Counting the instructions slows the simulation down.\n");
+        return -1;
+    }
+
+    FILE* vmInput = inputPath ? fopen(inputPath, "r") : NULL;
+    if(inputPath && !vmInput)
+    {
+        fprintf(stderr, "Could not open %s\n", inputPath);
+        return -1;
+    }
+
+    FILE* out = outputPath ? fopen(outputPath, "w") : stdout;
+    if(!out)
+    {
+        fprintf(stderr, "Could not open %s\n", outputPath);
+        return -1;
+    }
+
+    long long* samples[BENCH_PHASE_COUNT];
+    for(int p = 0; p < BENCH_PHASE_COUNT; p++)
+        samples[p] = (long long*)malloc(sizeof(long long) * runs);
+
+    int ret = 0;
+    int first = 1;
+
+    setLexerStats(statsPtr);
+    setCGOptimizations(optimizations);
+    setCGStats(statsPtr);
+
+    fprintf(out, "{\n  \"runs\": %d,\n  \"unit\": \"us\",\n  \"programs\": [", runs);
+
+    for(; i < argc; i++)
+    {
+        if(benchFile(argv[i], runs, vmInput, samples, statsPtr, arenaPtr))
+        {
+            ret = -1;
+            continue;
+        }
+
+        fprintf(out, "%s\n    {\n      \"program\": \"%s\",\n      \"phases\": {\n", first ? "" : ",", argv[i]);
+        first = 0;
+
+        for(int p = 0; p < BENCH_PHASE_COUNT; p++)
+        {
+            printSamples(out, benchPhaseNames[p], samples[p], runs);
+            fprintf(out, p + 1 < BENCH_PHASE_COUNT ? ",\n" : "\n");
+        }
+
+        fprintf(out, "      }\n    }");
+    }
+
+    fprintf(out, "\n  ]\n}\n");
+
+    setLexerStats(NULL);
+    setCGStats(NULL);
+    setLexerArena(NULL);
+    setCGArena(NULL);
+    deleteArena(&arena);
+
+    if(statsPtr) printStats(statsPtr, statsFormat, stderr);
+    deleteStats(&stats);
+
+    for(int p = 0; p < BENCH_PHASE_COUNT; p++) free(samples[p]);
+    if(vmInput) fclose(vmInput);
+    if(out != stdout) fclose(out);
+
+    return ret;
+}
@@ -0,0 +1,223 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * Generator of synthetic PL/0 programs for the benchmarks. Each kind of
+ * .. program stresses a different part of the compiler or the VM, scaled by
+ * .. the size argument. The sizes are capped so that the programs stay in
+ * .. the limits of the compiler and the VM: MAX_CODE_LENGTH instructions,
+ * .. MAX_STACK_HEIGHT stack slots, numbers of 5 digits and identifiers of
+ * .. 11 characters.
+ * */
+
+/**
+ * Kinds of programs
+ * */
+typedef enum {
+    NESTING,      // size nested procedures, each calling the next one
+    EXPRESSIONS,  // an expression chain of size terms, evaluated in a loop
+    DECLARATIONS, // size constants and variables
+    LOOPS,        // tight while loops of size iterations in total
+    OUTPUT        // a loop writing size numbers
+} ProgramKind;
+
+const char* programKindNames[] = {
+    [NESTING] = "nesting",
+    [EXPRESSIONS] = "expressions",
+    [DECLARATIONS] = "declarations",
+    [LOOPS] = "loops",
+    [OUTPUT] = "output"
+};
+
+#define PROGRAM_KIND_COUNT 5
+
+/**
+ * Number of times the main loop runs in the programs whose size is the
+ * .. size of the code
+ * */
+#define REPEAT_COUNT 1000
+
+// Caps of the sizes, keeping the code under MAX_CODE_LENGTH (500)
+// .. instructions and the stack under MAX_STACK_HEIGHT (2000) slots
+#define MAX_NESTING      30
+#define MAX_TERMS        150
+#define MAX_DECLARATIONS 1500
+#define MAX_NUMBER       99999
+
+int min(int a, int b)
+{
+    return a < b ? a : b;
+}
+
+/**
+ * Prints the indentation of the given depth
+ * */
+void indent(FILE* out, int depth)
+{
+    for(int i = 0; i < depth; i++) fprintf(out, "  ");
+}
+
+/**
+ * Procedures p1 .. pN, each nested in the previous one. Each procedure
+ * .. updates its own variable from the global one, increments the global
+ * .. one through its own, then calls the next one. The main block calls p1 in a loop.
+ * */
+void generateNesting(FILE* out, int size)
+{
+    int n = min(size, MAX_NESTING);
+
+    fprintf(out, "var i, x;\n");
+
+    for(int d = 1; d <= n; d++)
+    {
+        indent(out, d - 1);
+        fprintf(out, "procedure p%d;\n", d);
+        indent(out, d);
+        fprintf(out, "var v%d;\n", d);
+    }
+
+    // Bodies, from the innermost procedure out
+    for(int d = n; d >= 1; d--)
+    {
+        indent(out, d);
+        fprintf(out, "begin\n");
+        indent(out, d + 1);
+        fprintf(out, "v%d := x + %d;\n", d, d);
+        indent(out, d + 1);
+        fprintf(out, "x := v%d - %d + 1", d, d);
+
+        if(d < n)
+        {
+            fprintf(out, ";\n");
+            indent(out, d + 1);
+            fprintf(out, "call p%d", d + 1);
+        }
+
+        fprintf(out, "\n");
+        indent(out, d);
+        fprintf(out, "end;\n");
+    }
+
+    fprintf(out, "begin\n  i := 0;\n  while i < %d do\n  begin\n    x := 0;\n", REPEAT_COUNT);
+    fprintf(out, "    call p1;\n    i := i + 1\n  end;\n  write x\nend.\n");
+}
+
+/**
+ * A single assignment of an expression of size terms, mixing all the
+ * .. arithmetic operators and parentheses, evaluated in a loop.
+ * */
+void generateExpressions(FILE* out, int size)
+{
+    int n = min(size, MAX_TERMS);
+    const char* ops[] = { "+", "-", "*", "+", "-" };
+
+    fprintf(out, "const c = 7;\nvar i, a, b, x;\nbegin\n  a := 3; b := 5; i := 0;\n");
+    fprintf(out, "  while i < %d do\n  begin\n    x := a", REPEAT_COUNT);
+
+    for(int t = 1; t < n; t++)
+    {
+        const char* operand = t % 3 == 0 ? "b" : t % 3 == 1 ? "c" : "a";
+
+        if(t % 7 == 0) fprintf(out, "\n      %s (%s / c)", ops[t % 5], operand);
+        else           fprintf(out, " %s %s", ops[t % 5], operand);
+    }
+
+    fprintf(out, ";\n    i := i + 1\n  end;\n  write x\nend.\n");
+}
+
+/**
+ * size constants and variables in the main block and a procedure, which
+ * .. fill the symbol table and are looked up by the statements.
+ * */
+void generateDeclarations(FILE* out, int size)
+{
+    int n = min(size, MAX_DECLARATIONS);
+
+    fprintf(out, "const");
+    for(int i = 0; i < n; i++)
+        fprintf(out, "%s\n  k%d = %d", i ? "," : "", i, i % MAX_NUMBER);
+    fprintf(out, ";\n");
+
+    fprintf(out, "var");
+    for(int i = 0; i < n; i++)
+        fprintf(out, "%s\n  v%d", i ? "," : "", i);
+    fprintf(out, ";\n");
+
+    fprintf(out, "procedure p;\n  var w;\n  begin\n    w := k%d + v%d;\n    v0 := w\n  end;\n", n - 1, n / 2);
+
+    // Statements looking the symbols up, as many as the code allows
+    fprintf(out, "begin\n  call p");
+    for(int i = 0; i < min(n, 100); i++)
+        fprintf(out, ";\n  v%d := k%d + v%d", (i * 7) % n, (i * 13) % n, (i * 11) % n);
+    fprintf(out, ";\n  write v0\nend.\n");
+}
+
+/**
+ * Nested while loops running the innermost body size times in total.
+ * */
+void generateLoops(FILE* out, int size)
+{
+    int inner = min(size, 1000);
+    int outer = size / inner;
+    if(outer > MAX_NUMBER) outer = MAX_NUMBER;
+    if(outer < 1) outer = 1;
+
+    fprintf(out, "var i, j, s;\nbegin\n  s := 0; i := 0;\n");
+    fprintf(out, "  while i < %d do\n  begin\n    j := 0;\n", outer);
+    fprintf(out, "    while j < %d do\n    begin\n      s := s + j;\n", inner);
+    fprintf(out, "      if s > 10000 then s := s - 10000;\n      j := j + 1\n    end;\n");
+    fprintf(out, "    i := i + 1\n  end;\n  write s\nend.\n");
+}
+
+/**
+ * A loop writing size numbers.
+ * */
+void generateOutput(FILE* out, int size)
+{
+    int inner = min(size, 1000);
+    int outer = size / inner;
+    if(outer > MAX_NUMBER) outer = MAX_NUMBER;
+    if(outer < 1) outer = 1;
+
+    fprintf(out, "var i, j;\nbegin\n  i := 0;\n");
+    fprintf(out, "  while i < %d do\n  begin\n    j := 0;\n", outer);
+    fprintf(out, "    while j < %d do\n    begin\n      write j;\n      j := j + 1\n    end;\n", inner);
+    fprintf(out, "    i := i + 1\n  end\nend.\n");
+}
+
+int main(int argc, char **argv)
+{
+    int kind = -1;
+
+    for(int i = 0; argc == 3 && i < PROGRAM_KIND_COUNT; i++)
+    {
+        if(!strcmp(argv[1], programKindNames[i])) kind = i;
+    }
+
+    if(kind < 0 || atoi(argv[2]) < 1)
+    {
+        fprintf(stderr, "Usage: pl0_gen.out (kind) (size)\n");
+
+        fprintf(stderr, "\n       Writes a synthetic PL/0 program to stdout. Kinds:\n");
+        fprintf(stderr, "\n       nesting: size nested procedures, each calling the next one. At most %d.\n", MAX_NESTING);
+        fprintf(stderr, "\n       expressions: an expression of size terms, evaluated in a loop. At most %d.\n", MAX_TERMS);
+        fprintf(stderr, "\n       declarations: size constants and size variables. At most %d.\n", MAX_DECLARATIONS);
+        fprintf(stderr, "\n       loops: nested while loops, running size iterations in total.\n");
+        fprintf(stderr, "\n       output: a loop writing size numbers.\n");
+        return -1;
+    }
+
+    int size = atoi(argv[2]);
+
+    switch(kind)
+    {
+        case NESTING:      generateNesting(stdout, size);      break;
+        case EXPRESSIONS:  generateExpressions(stdout, size);  break;
+        case DECLARATIONS: generateDeclarations(stdout, size); break;
+        case LOOPS:        generateLoops(stdout, size);        break;
+        case OUTPUT:       generateOutput(stdout, size);       break;
+    }
+
+    return 0;
+}
@@ -0,0 +1,339 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "cache.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <utime.h>
+
+#define CG_CACHE_PATH_LENGTH 4096
+
+/**
+ * A cache entry file seen while scanning the cache directory for eviction.
+ * */
+typedef struct {
+    char name[32];
+    time_t lastUsed;
+} CGCacheEntry;
+
+/**
+ * Writes the path of the file with the given name in the cache directory.
+ * */
+void getCGCachePath(CGCache* cache, const char* name, char* path)
+{
+    snprintf(path, CG_CACHE_PATH_LENGTH, "%s/%s", cache->dir, name);
+}
+
+/**
+ * Writes the path of the entry with the given key.
+ * */
+void getCGCacheEntryPath(CGCache* cache, unsigned long long key, char* path)
+{
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx.cg", key);
+    getCGCachePath(cache, name, path);
+}
+
+/**
+ * Copies the remaining content of the src to dst.
+ * */
+void copyFileContent(FILE* src, FILE* dst)
+{
+    char buffer[4096];
+    size_t n;
+
+    while( (n = fread(buffer, 1, sizeof(buffer), src)) > 0 )
+        fwrite(buffer, 1, n, dst);
+}
+
+/**
+ * Orders cache entries from the least recently used to the most.
+ * */
+int compareCGCacheEntries(const void* a, const void* b)
+{
+    time_t ta = ((const CGCacheEntry*)a)->lastUsed;
+    time_t tb = ((const CGCacheEntry*)b)->lastUsed;
+
+    return (ta > tb) - (ta < tb);
+}
+
+/**
+ * Removes the least recently used entries until at most maxEntries are left.
+ * The entry with the given key, which is the one just stored, is kept.
+ * */
+void evictCGCache(CGCache* cache, unsigned long long keptKey)
+{
+    char keptName[32];
+    snprintf(keptName, sizeof(keptName), "%016llx.cg", keptKey);
+
+    DIR* dir = opendir(cache->dir);
+    if(!dir) return;
+
+    CGCacheEntry* entries = NULL;
+    int numberOfEntries = 0;
+
+    char path[CG_CACHE_PATH_LENGTH];
+    struct dirent* d;
+
+    while( (d = readdir(dir)) )
+    {
+        size_t len = strlen(d->d_name);
+        if(len < 3 || len >= sizeof(entries->name) || strcmp(d->d_name + len - 3, ".cg"))
+            continue;
+
+        if(!strcmp(d->d_name, keptName)) continue;
+
+        struct stat st;
+        getCGCachePath(cache, d->d_name, path);
+        if(stat(path, &st)) continue;
+
+        numberOfEntries++;
+        entries = (CGCacheEntry*)realloc(entries, numberOfEntries * sizeof(CGCacheEntry));
+        strcpy(entries[numberOfEntries - 1].name, d->d_name);
+        entries[numberOfEntries - 1].lastUsed = st.st_mtime;
+    }
+    closedir(dir);
+
+    // The kept entry is not in the list, but counts against the limit
+    if(numberOfEntries + 1 > cache->maxEntries)
+    {
+        qsort(entries, numberOfEntries, sizeof(CGCacheEntry), compareCGCacheEntries);
+
+        for(int i = 0; i < numberOfEntries + 1 - cache->maxEntries; i++)
+        {
+            getCGCachePath(cache, entries[i].name, path);
+            if(!remove(path)) cache->stats.evictions++;
+        }
+    }
+
+    if(entries) free(entries);
+}
+
+/**
+ * Opens the stats file of the cache and locks it, for reading if type is
+ * .. F_RDLCK and for writing if it is F_WRLCK. The lock is released by
+ * .. closing the file.
+ * Returns NULL if the file cannot be opened or locked.
+ * */
+FILE* openCGCacheStats(CGCache* cache, int type)
+{
+    char path[CG_CACHE_PATH_LENGTH];
+    getCGCachePath(cache, "stats", path);
+
+    int fd = type == F_WRLCK ? open(path, O_RDWR | O_CREAT, 0644) : open(path, O_RDONLY);
+    if(fd < 0) return NULL;
+
+    struct flock lock;
+    memset(&lock, 0, sizeof(lock));
+    lock.l_type = type;
+    lock.l_whence = SEEK_SET;
+
+    FILE* fp = NULL;
+    if(fcntl(fd, F_SETLKW, &lock) || !(fp = fdopen(fd, type == F_WRLCK ? "r+" : "r")))
+        close(fd);
+
+    return fp;
+}
+
+/**
+ * Reads the statistics in the stats file to stats, which are zero if the
+ * .. file is empty or not in the format deleteCGCache() writes.
+ * */
+void readCGCacheStats(FILE* fp, CGCacheStats* stats)
+{
+    if(fscanf(fp, "hits %d misses %d stores %d evictions %d",
+        &stats->hits, &stats->misses, &stats->stores, &stats->evictions) != 4)
+    {
+        memset(stats, 0, sizeof(CGCacheStats));
+    }
+}
+
+void initCGCache(CGCache* cache, const char* dir, int maxEntries)
+{
+    cache->dir = dir;
+    cache->maxEntries = maxEntries > 0 ? maxEntries : CG_CACHE_DEFAULT_MAX_ENTRIES;
+    memset(&cache->stats, 0, sizeof(CGCacheStats));
+    memset(&cache->previousStats, 0, sizeof(CGCacheStats));
+
+    // Create the cache directory - if it does not exist
+    mkdir(dir, 0755);
+
+    // Load the statistics of the previous runs
+    FILE* fp = openCGCacheStats(cache, F_RDLCK);
+    if(fp)
+    {
+        readCGCacheStats(fp, &cache->previousStats);
+        fclose(fp);
+    }
+}
+
+void deleteCGCache(CGCache* cache)
+{
+    if(!cache || !cache->dir) return;
+
+    // The runs that ended since this one started have changed the saved
+    // .. statistics, so they are read again and added to under the lock
+    FILE* fp = openCGCacheStats(cache, F_WRLCK);
+    if(fp)
+    {
+        CGCacheStats saved;
+        readCGCacheStats(fp, &saved);
+
+        rewind(fp);
+        fprintf(fp, "hits %d\nmisses %d\nstores %d\nevictions %d\n",
+            saved.hits + cache->stats.hits, saved.misses + cache->stats.misses,
+            saved.stores + cache->stats.stores, saved.evictions + cache->stats.evictions);
+
+        // Cut what the file held after the counts, if it was not in the format
+        fflush(fp);
+        if(ftruncate(fileno(fp), ftell(fp)))
+            fprintf(stderr, "Could not save the statistics of the cache %s\n", cache->dir);
+
+        fclose(fp);
+    }
+
+    cache->dir = NULL;
+}
+
+unsigned long long hashCGInput(FILE* in, const char* salt)
+{
+    // 64-bit FNV-1a
+    unsigned long long hash = 14695981039346656037ULL;
+    const unsigned long long prime = 1099511628211ULL;
+
+    for(const char* c = salt; c && *c; c++)
+    {
+        hash ^= (unsigned char)*c;
+        hash *= prime;
+    }
+
+    unsigned char buffer[4096];
+    size_t n;
+
+    while( (n = fread(buffer, 1, sizeof(buffer), in)) > 0 )
+    {
+        for(size_t i = 0; i < n; i++)
+        {
+            hash ^= buffer[i];
+            hash *= prime;
+        }
+    }
+
+    rewind(in);
+
+    return hash;
+}
+
+int lookupCGCache(CGCache* cache, unsigned long long key, FILE* out, int* err)
+{
+    char path[CG_CACHE_PATH_LENGTH];
+    getCGCacheEntryPath(cache, key, path);
+
+    FILE* fp = fopen(path, "rb");
+
+    if(!fp || fscanf(fp, "%d", err) != 1 || fgetc(fp) != '\n')
+    {
+        if(fp) fclose(fp);
+        cache->stats.misses++;
+        return 0;
+    }
+
+    copyFileContent(fp, out);
+    fclose(fp);
+
+    // Mark the entry as recently used
+    utime(path, NULL);
+
+    cache->stats.hits++;
+    return 1;
+}
+
+/**
+ * Replaces the file at path with header followed by the content of src, read
+ * .. from its beginning. The content is written to a temporary file first,
+ * .. which is then renamed to path, so that a concurrent reader never sees a
+ * .. partially written file. The temporary file has a unique name in the
+ * .. cache directory, so that concurrent writers do not share it.
+ * Returns 0 on success, -1 otherwise.
+ * */
+int replaceCGCacheFile(CGCache* cache, const char* path, const char* header, FILE* src)
+{
+    char tmpPath[CG_CACHE_PATH_LENGTH];
+    getCGCachePath(cache, ".tmp-XXXXXX", tmpPath);
+
+    int fd = mkstemp(tmpPath);
+    if(fd < 0) return -1;
+
+    // As the files created by fopen(), not only for the owner
+    fchmod(fd, 0644);
+
+    FILE* fp = fdopen(fd, "wb");
+    if(!fp)
+    {
+        close(fd);
+        remove(tmpPath);
+        return -1;
+    }
+
+    fputs(header, fp);
+
+    rewind(src);
+    copyFileContent(src, fp);
+    fclose(fp);
+
+    if(rename(tmpPath, path))
+    {
+        remove(tmpPath);
+        return -1;
+    }
+
+    return 0;
+}
+
+void storeCGCache(CGCache* cache, unsigned long long key, FILE* genOut, int err)
+{
+    char path[CG_CACHE_PATH_LENGTH], header[16];
+    getCGCacheEntryPath(cache, key, path);
+    snprintf(header, sizeof(header), "%d\n", err);
+
+    if(replaceCGCacheFile(cache, path, header, genOut)) return;
+
+    cache->stats.stores++;
+
+    evictCGCache(cache, key);
+}
+
+void storeCGCacheFile(CGCache* cache, const char* name, FILE* content)
+{
+    char path[CG_CACHE_PATH_LENGTH];
+    getCGCachePath(cache, name, path);
+
+    replaceCGCacheFile(cache, path, "", content);
+}
+
+FILE* openCGCacheFile(CGCache* cache, const char* name, const char* mode)
+{
+    char path[CG_CACHE_PATH_LENGTH];
+    getCGCachePath(cache, name, path);
+
+    return fopen(path, mode);
+}
+
+void printCGCacheStats(CGCache* cache, FILE* out)
+{
+    if(!cache || !out) return;
+
+    CGCacheStats* s = &cache->stats;
+    CGCacheStats* p = &cache->previousStats;
+
+    int hits = s->hits + p->hits, misses = s->misses + p->misses;
+    int lookups = hits + misses;
+
+    fprintf(out, "Cache %s: %d hits, %d misses (%.1f%% hit rate), %d stores, %d evictions\n",
+        cache->dir, hits, misses, lookups ? 100.0 * hits / lookups : 0.0,
+        s->stores + p->stores, s->evictions + p->evictions);
+}
@@ -0,0 +1,91 @@
+#ifndef __CACHE_H__
+#define __CACHE_H__
+
+#include <stdio.h>
+
+/**
+ * The number of entries kept in the cache directory if not specified otherwise.
+ * */
+#define CG_CACHE_DEFAULT_MAX_ENTRIES 256
+
+/**
+ * On-disk cache of code generator results.
+ *
+ * Each entry is a file in the cache directory, named after the hash of the
+ * .. code generator input and the options that affect the output, holding the
+ * .. error code and the exact output of the code generator.
+ * When the number of entries exceeds maxEntries, the least recently used
+ * .. entries are evicted.
+ * The statistics are cumulative over runs, and kept in the "stats" file of
+ * .. the cache directory. Each run adds its own counts to the file under a
+ * .. lock, so that the runs sharing the directory do not lose each other's.
+ * */
+typedef struct {
+    int hits;
+    int misses;
+    int stores;
+    int evictions;
+} CGCacheStats;
+
+typedef struct {
+    const char* dir;
+    int maxEntries;
+
+    // Statistics of this run, and of the previous runs as loaded at the start
+    CGCacheStats stats;
+    CGCacheStats previousStats;
+} CGCache;
+
+/**
+ * Initializes the cache on the given directory, creating the directory if
+ * .. required, and loads the statistics of the previous runs.
+ * */
+void initCGCache(CGCache*, const char* dir, int maxEntries);
+
+/**
+ * Adds the statistics of this run to the ones saved in the cache directory.
+ * */
+void deleteCGCache(CGCache*);
+
+/**
+ * Computes the cache key of the content of the given file, which is read until
+ * .. EOF and rewound. salt should identify the code generator version and the
+ * .. options affecting the output, so that they are also part of the key.
+ * */
+unsigned long long hashCGInput(FILE*, const char* salt);
+
+/**
+ * Looks up the entry with the given key. On hit, writes the cached output to
+ * .. out, sets err to the cached error code and returns 1. Returns 0 on miss.
+ * */
+int lookupCGCache(CGCache*, unsigned long long key, FILE* out, int* err);
+
+/**
+ * Stores the content of genOut, which is read from its beginning, and the
+ * .. error code as the entry with the given key. Evicts the least recently
+ * .. used entries if the cache is full.
+ * */
+void storeCGCache(CGCache*, unsigned long long key, FILE* genOut, int err);
+
+/**
+ * Stores the content of the file, which is read from its beginning, as the
+ * .. file with the given name in the cache directory. As the entries, it is
+ * .. replaced at once, so that it can be read by openCGCacheFile() while it
+ * .. is being stored.
+ * */
+void storeCGCacheFile(CGCache*, const char* name, FILE* content);
+
+/**
+ * Opens the file with the given name in the cache directory, which can be
+ * .. used to keep other data along with the cache entries.
+ * Returns NULL if the file cannot be opened.
+ * */
+FILE* openCGCacheFile(CGCache*, const char* name, const char* mode);
+
+/**
+ * Prints the statistics of the cache, including the previous runs, to the
+ * .. given file.
+ * */
+void printCGCacheStats(CGCache*, FILE*);
+
+#endif
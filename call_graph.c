@@ -0,0 +1,250 @@
+#include <stdlib.h>
+#include <string.h>
+#include "call_graph.h"
+
+void initCallGraph(CallGraph* graph)
+{
+    graph->procs = NULL;
+    graph->numberOfProcs = 0;
+    graph->roots = NULL;
+    graph->numberOfRoots = 0;
+}
+
+void deleteCallGraph(CallGraph* graph)
+{
+    if(!graph) return;
+
+    for(int i = 0; i < graph->numberOfProcs; i++)
+        free(graph->procs[i].callees);
+
+    free(graph->procs);
+    free(graph->roots);
+
+    graph->procs = NULL;
+    graph->numberOfProcs = 0;
+    graph->roots = NULL;
+    graph->numberOfRoots = 0;
+}
+
+int addCallGraphProc(CallGraph* graph, int start, int end)
+{
+    graph->numberOfProcs++;
+    graph->procs = (CallGraphProc*)realloc(graph->procs, graph->numberOfProcs * sizeof(CallGraphProc));
+
+    CallGraphProc* proc = &graph->procs[graph->numberOfProcs - 1];
+    proc->start = start;
+    proc->end = end;
+    proc->callees = NULL;
+    proc->numberOfCallees = 0;
+    proc->reachable = 0;
+
+    return graph->numberOfProcs - 1;
+}
+
+/**
+ * Returns the end of the code of the block at start, which is before end,
+ * .. adding the procedures nested in it to the call graph. Returns -1 if the
+ * .. code is not laid out as a block.
+ * */
+int addBlockProcs(CallGraph* graph, Instruction* code, int start, int end)
+{
+    int i = start;
+    while(i < end && code[i].op == INC) i++;
+
+    if(i == start || i >= end || code[i].op != JMP || code[i].m <= i || code[i].m >= end)
+        return -1;
+
+    // The nested procedures, one after the other up to the jump target
+    int statement = code[i].m;
+    for(int p = i + 1; p < statement; )
+    {
+        int procEnd = addBlockProcs(graph, code, p, statement);
+        if(procEnd < 0) return -1;
+
+        addCallGraphProc(graph, p, procEnd);
+        p = procEnd;
+    }
+
+    // The statement does not contain a RTN
+    for(i = statement; i < end; i++)
+    {
+        if(code[i].op == RTN) return i + 1;
+    }
+
+    return -1;
+}
+
+void addNestedCallGraphProcs(CallGraph* graph, Instruction* code, int start, int end)
+{
+    int numberOfProcs = graph->numberOfProcs;
+
+    // Drop what is added, if the code is not laid out as expected
+    if(addBlockProcs(graph, code, start, end) != end)
+    {
+        for(int i = numberOfProcs; i < graph->numberOfProcs; i++)
+            free(graph->procs[i].callees);
+
+        graph->numberOfProcs = numberOfProcs;
+    }
+}
+
+int findCallGraphProc(CallGraph* graph, int address)
+{
+    // The ranges are either nested or disjoint, so the innermost one is the
+    // .. one starting last
+    int innermost = -1;
+
+    for(int i = 0; i < graph->numberOfProcs; i++)
+    {
+        CallGraphProc* proc = &graph->procs[i];
+
+        if(proc->start <= address && address < proc->end && (innermost < 0 || proc->start > graph->procs[innermost].start))
+            innermost = i;
+    }
+
+    return innermost;
+}
+
+/**
+ * Appends callee to the list, unless it is already in it
+ * */
+void addCallee(int** list, int* count, int callee)
+{
+    for(int i = 0; i < *count; i++)
+    {
+        if((*list)[i] == callee) return;
+    }
+
+    (*count)++;
+    *list = (int*)realloc(*list, *count * sizeof(int));
+    (*list)[*count - 1] = callee;
+}
+
+void buildCallGraph(CallGraph* graph, Instruction* code, int numOfIns)
+{
+    for(int i = 0; i < numOfIns; i++)
+    {
+        if(code[i].op != CAL) continue;
+
+        int callee = -1;
+        for(int p = 0; p < graph->numberOfProcs && callee < 0; p++)
+        {
+            if(graph->procs[p].start == code[i].m) callee = p;
+        }
+
+        if(callee < 0) continue;
+
+        int caller = findCallGraphProc(graph, i);
+
+        if(caller < 0) addCallee(&graph->roots, &graph->numberOfRoots, callee);
+        else           addCallee(&graph->procs[caller].callees, &graph->procs[caller].numberOfCallees, callee);
+    }
+}
+
+int markReachableProcs(CallGraph* graph)
+{
+    for(int i = 0; i < graph->numberOfProcs; i++)
+        graph->procs[i].reachable = 0;
+
+    // Depth-first, from the procedures called by the main block
+    int* stack = (int*)malloc((graph->numberOfProcs + 1) * sizeof(int));
+    int top = 0;
+
+    for(int i = 0; i < graph->numberOfRoots; i++)
+    {
+        if(graph->procs[graph->roots[i]].reachable) continue;
+
+        graph->procs[graph->roots[i]].reachable = 1;
+        stack[top++] = graph->roots[i];
+
+        while(top)
+        {
+            CallGraphProc* proc = &graph->procs[stack[--top]];
+
+            for(int c = 0; c < proc->numberOfCallees; c++)
+            {
+                if(graph->procs[proc->callees[c]].reachable) continue;
+
+                graph->procs[proc->callees[c]].reachable = 1;
+                stack[top++] = proc->callees[c];
+            }
+        }
+    }
+
+    free(stack);
+
+    int unreachable = 0;
+    for(int i = 0; i < graph->numberOfProcs; i++)
+        unreachable += !graph->procs[i].reachable;
+
+    return unreachable;
+}
+
+int eliminateDeadProcs(CallGraph* graph, Instruction* code, int* lines, int numOfIns)
+{
+    char* dead = (char*)calloc(numOfIns + 1, 1);
+    int* newIndex = (int*)malloc((numOfIns + 1) * sizeof(int));
+
+    for(int p = 0; p < graph->numberOfProcs; p++)
+    {
+        CallGraphProc* proc = &graph->procs[p];
+
+        for(int i = proc->start; !proc->reachable && i < proc->end; i++)
+            dead[i] = 1;
+    }
+
+    // The jumps over the declarations of the procedures removed above would
+    // .. jump to the next instruction
+    for(int i = 0; i < numOfIns; i++)
+    {
+        if(dead[i] || code[i].op != JMP || code[i].m <= i + 1 || code[i].m > numOfIns) continue;
+
+        int overDeadOnly = 1;
+        for(int j = i + 1; j < code[i].m && overDeadOnly; j++)
+            overDeadOnly = dead[j];
+
+        dead[i] = overDeadOnly;
+    }
+
+    // A removed instruction maps to the next one kept, which is where the
+    // .. control would reach after it
+    int count = 0;
+    for(int i = 0; i <= numOfIns; i++)
+    {
+        newIndex[i] = count;
+        if(i < numOfIns && !dead[i]) count++;
+    }
+
+    for(int i = 0; i < numOfIns; i++)
+    {
+        if(dead[i]) continue;
+
+        Instruction ins = code[i];
+
+        if((isJumpOp(ins.op) || ins.op == CAL) && ins.m >= 0 && ins.m <= numOfIns)
+            ins.m = newIndex[ins.m];
+
+        code[newIndex[i]] = ins;
+        if(lines) lines[newIndex[i]] = lines[i];
+    }
+
+    for(int p = 0; p < graph->numberOfProcs; p++)
+    {
+        CallGraphProc* proc = &graph->procs[p];
+
+        if(proc->reachable)
+        {
+            proc->start = newIndex[proc->start];
+            proc->end = newIndex[proc->end];
+        }
+        else
+        {
+            proc->start = proc->end = -1;
+        }
+    }
+
+    free(newIndex);
+    free(dead);
+
+    return count;
+}
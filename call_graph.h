@@ -0,0 +1,97 @@
+#ifndef __CALL_GRAPH_H__
+#define __CALL_GRAPH_H__
+
+#include "data.h"
+
+/**
+ * A procedure in the generated code: the range [start, end) of its code,
+ * .. which includes the code of its nested procedures, and the indices of
+ * .. the procedures it calls.
+ * */
+typedef struct {
+    int start;
+    int end;
+
+    int* callees;
+    int numberOfCallees;
+
+    /**
+     * Nonzero if the procedure is reachable from the main block through
+     * .. calls, set by markReachableProcs().
+     * */
+    int reachable;
+} CallGraphProc;
+
+/**
+ * Call graph of the generated code. The main block is the code outside of
+ * .. all the procedures.
+ * */
+typedef struct {
+    CallGraphProc* procs;
+    int numberOfProcs;
+
+    /**
+     * The indices of the procedures called by the main block.
+     * */
+    int* roots;
+    int numberOfRoots;
+} CallGraph;
+
+/**
+ * Initializes the given call graph to an empty one.
+ * */
+void initCallGraph(CallGraph*);
+
+/**
+ * Makes the necessary deallocations on the call graph.
+ * */
+void deleteCallGraph(CallGraph*);
+
+/**
+ * Adds the procedure whose code is in [start, end) to the call graph.
+ * Returns the index of the procedure.
+ * */
+int addCallGraphProc(CallGraph*, int start, int end);
+
+/**
+ * Adds the procedures nested in the procedure whose code is at [start, end)
+ * .. to the call graph, for code that was not generated procedure by
+ * .. procedure, such as the fragments reused from the cache. The procedures
+ * .. are found from the layout of the code of a block: the INC instructions,
+ * .. a JMP over the nested procedures, and the statement ending with the
+ * .. only RTN of the block.
+ * */
+void addNestedCallGraphProcs(CallGraph*, Instruction* code, int start, int end);
+
+/**
+ * Returns the index of the innermost procedure containing the instruction at
+ * .. address, -1 if the instruction belongs to the main block.
+ * */
+int findCallGraphProc(CallGraph*, int address);
+
+/**
+ * Adds an edge for each CAL instruction in the code, from the innermost
+ * .. procedure containing it to the procedure it calls. Calls to addresses
+ * .. that are not the start of a procedure of the graph are ignored, which
+ * .. leaves the callee a part of the procedure containing it.
+ * */
+void buildCallGraph(CallGraph*, Instruction* code, int numOfIns);
+
+/**
+ * Marks the procedures reachable from the main block. Returns the number of
+ * .. the unreachable ones.
+ * */
+int markReachableProcs(CallGraph*);
+
+/**
+ * Removes the code of the unreachable procedures from code and lines, and
+ * .. the jumps left jumping over only removed code. The addresses in the
+ * .. jumps, see isJumpOp(), and the CAL instructions, and the ranges of the
+ * .. procedures, are renumbered; the ranges of the removed procedures are
+ * .. set to -1.
+ * lines can be NULL. markReachableProcs() should be called before.
+ * Returns the new number of instructions.
+ * */
+int eliminateDeadProcs(CallGraph*, Instruction* code, int* lines, int numOfIns);
+
+#endif
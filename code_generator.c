@@ -1,8 +1,14 @@
 #include "token.h"
+#include "code_generator.h"
 #include "data.h"
 #include "symbol.h"
+#include "object_writer.h"
+#include "call_graph.h"
+#include "inliner.h"
+#include "loop_optimizer.h"
 #include <string.h>
 #include <stdlib.h>
+#include <limits.h>
 
 /**
  * This pointer is set when by codeGenerator() func and used by printEmittedCode() func.
@@ -42,16 +48,81 @@ SymbolTable symbolTable;
  * */
 Instruction vmCode[MAX_CODE_LENGTH];
 
+/**
+ * The source line of each instruction in vmCode, 0 if not known.
+ * */
+int vmLines[MAX_CODE_LENGTH];
+
 /**
  * The next index in the array of instructions (vmCode) to be filled.
  * */
 int nextCodeIndex;
 
+/**
+ * Format of the printed code, set by setCGOutputFormat().
+ * */
+int _output_format = CG_OUTPUT_TEXT;
+
+/**
+ * Optimizations set by setCGOptimizations().
+ * */
+int _optimizations = CG_OPT_DEFAULT;
+
+/**
+ * The procedures generated in the current run, with the range of their code,
+ * .. for the optimizations working on the call graph.
+ * */
+CallGraph _call_graph;
+
+/**
+ * Address of the procedures removed by optimizeCode()
+ * */
+#define REMOVED_PROC_ADDRESS ((unsigned int)-1)
+
+/**
+ * Stats set by setCGStats(), NULL if not set.
+ * */
+Stats* _stats;
+
+/**
+ * Arena set by setCGArena(), NULL if not set.
+ * */
+Arena* _arena;
+
+/**
+ * The number of the arithmetic operations simplified by emitConstantOp() in
+ * .. the current run.
+ * */
+int _arithmetic_simplified;
+
 /**
  * The id of the register currently being used.
  * */
 int currentReg;
 
+/**
+ * The list of errors collected while parsing. It will be reset once entered to
+ * codeGenerator() and deleted before exiting codeGenerator().
+ * */
+CGErrList _err_list;
+
+/**
+ * The maximum number of errors to be collected before the parsing is stopped.
+ * Non-positive value means there is no limit.
+ * */
+int _max_errs;
+
+/**
+ * Cache of procedure fragments set by setCGProcFragmentCache(), NULL if not set.
+ * */
+ProcFragmentCache* _fragment_cache;
+
+/**
+ * The fragments of the procedures generated in the current run. Moved to
+ * _fragment_cache if the code generation is successful.
+ * */
+ProcFragmentCache _new_fragments;
+
 /**
  * Emits the instruction whose fields are given as parameters.
  * Internally, writes the instruction to vmCode[nextCodeIndex] and returns the
@@ -61,13 +132,111 @@ int currentReg;
 int emit(int OP, int R, int L, int M);
 
 /**
- * Prints the emitted code array (vmCode) to output file.
+ * Emits the jump taken when the condition just generated into reg does not
+ * .. hold, and returns its index. The target is to be patched by the caller.
+ * With CG_OPT_BRANCHES, the relational instruction ending the condition is
+ * .. replaced with a compare-and-branch instruction, rather than followed by
+ * .. a JPC.
+ * */
+int emitFalseJump(int reg);
+
+/**
+ * Emits the arithmetic instruction op computing reg from reg and reg + 1,
+ * .. whose right operand is the code from rightStart.
+ * With CG_OPT_ALGEBRA, the operations with a constant operand are emitted
+ * .. by emitConstantOp() instead, with the constant left operands of the
+ * .. additions and the multiplications moved to the right.
+ * */
+void emitArithmetic(int op, int reg, int rightStart);
+
+/**
+ * Emits the code computing reg op c into reg, for ADD, SUB, MUL and DIV,
+ * .. simplified: the constants are folded into the constant left operand or
+ * .. the constant operation ending it, the identity operations are removed,
+ * .. and the multiplications and divisions by powers of two are replaced
+ * .. with SHF. The operations that would overflow or divide by zero are
+ * .. emitted as they are, to keep their behavior in the virtual machine.
+ * */
+void emitConstantOp(int op, int reg, int c);
+
+/**
+ * Returns the start of the operation of reg with a constant that a
+ * .. following op with a constant could be folded into, or -1 if there is
+ * .. none: LIT reg+1 c; op2 reg reg reg+1 or SHF reg reg k. Its size is set
+ * .. to the number of its instructions.
+ * The additions and the subtractions, and the multiplications are looked
+ * .. for over the chain of their operations, skipping the other operands.
+ * */
+int findConstantOp(int reg, int op, int* size);
+
+/**
+ * Removes count instructions of the emitted code starting at start, moving
+ * .. the ones after them back. Only used on the code of the expression being
+ * .. generated, which is not a jump target.
+ * */
+void removeCode(int start, int count);
+
+/**
+ * Adds shift to the registers used by the code of an expression, from start
+ * .. to the end of the emitted code.
+ * */
+void shiftExpressionRegs(int start, int shift);
+
+/**
+ * Prints the emitted code array (vmCode) to output file, in the format set by
+ * .. setCGOutputFormat().
  * 
  * This func is called in the given codeGenerator() function. You are not required
  * to have another call to this function in your code.
  * */
 void printEmittedCodes();
 
+/**
+ * Applies the optimizations set by setCGOptimizations() to the emitted code,
+ * .. running the passes of _passes in order, each timed in the stats.
+ * Updates the addresses of the procedure symbols.
+ * */
+void optimizeCode();
+
+/**
+ * Inlines the calls to small leaf procedures, see inliner.h
+ * */
+void inlinePass();
+
+/**
+ * Removes the procedures that are not reachable from the main block through
+ * .. calls, see call_graph.h
+ * */
+void deadProcsPass();
+
+/**
+ * A pass over the whole emitted code: the optimization enabling it, and the
+ * .. name and the help of its timer in the stats.
+ * The other optimizations are applied while the code is emitted, and timed
+ * .. as a part of the code generation.
+ * */
+typedef struct {
+    int optimization;
+    const char* timer;
+    const char* help;
+    void (*run)();
+} CGPass;
+
+/**
+ * The passes of optimizeCode(). Inlining comes first, as it might leave
+ * .. procedures that are no longer called.
+ * */
+const CGPass _passes[] = {
+    { CG_OPT_INLINE,     "cg_pass_inline",     "Time spent inlining calls",                   inlinePass },
+    { CG_OPT_DEAD_PROCS, "cg_pass_dead_procs", "Time spent removing unreachable procedures", deadProcsPass }
+};
+
+/**
+ * Prints the emitted code array (vmCode) to output file in the binary object
+ * .. format, together with the procedures and the source lines of the code.
+ * */
+void printEmittedObject();
+
 /**
  * Returns the current token using the token list iterator.
  * If it is the end of tokens, returns token with id nulsym.
@@ -85,6 +254,72 @@ int getCurrentTokenType();
  * */
 void nextToken();
 
+/**
+ * Returns 1 if the given token type is one of the synchronizing tokens that
+ * panic mode error recovery skips to: semicolonsym, endsym, periodsym or the
+ * end of tokens. Returns 0 otherwise.
+ * */
+int isSynchronizingToken(int tokenType);
+
+/**
+ * Records the error on the error list and recovers from it in panic mode:
+ * skips the tokens until a synchronizing token is reached. The synchronizing
+ * token itself is not consumed.
+ * An error on a token that an error was already reported on is not recorded
+ * again, which suppresses the cascading errors caused by the previous one.
+ * Returns 0 if parsing can continue. Returns the given error code if the
+ * error limit is reached, in which case parsing should stop.
+ * */
+int recoverFromError(int err);
+
+/**
+ * Same as recoverFromError(), but also consumes the synchronizing token if it
+ * is a semicolonsym, which terminates the declaration the error was in.
+ * */
+int recoverFromDeclarationError(int err);
+
+/**
+ * Returns the path of the procedure with the given name that is declared in
+ * the current scope, i.e. the names of the enclosing procedures and the given
+ * name separated by '.'. The returned string should be freed by the caller.
+ * */
+char* getProcPath(const char* name);
+
+/**
+ * Returns the hash of the interface of a procedure declared in the current
+ * scope: the current level and the symbols visible from the current scope.
+ * The optimizations are hashed too, as the loops are optimized while the
+ * code is generated.
+ * The addresses of the procedures are not a part of the interface since the
+ * calls are relocated.
+ * */
+unsigned long long hashProcInterface();
+
+/**
+ * If the fragment cache contains an up-to-date fragment for the procedure
+ * whose declaration starts at the token with index procTokenInd, relocates
+ * the code of the fragment to nextCodeIndex, adds the symbol of the procedure
+ * and the symbols declared in it to the symbol table, skips the tokens of the
+ * declaration and returns 1. Otherwise, returns 0 without consuming tokens.
+ * */
+int reuseProcFragment(const char* path, Symbol proc, int procTokenInd, unsigned long long interfaceHash);
+
+/**
+ * Records the code generated for the procedure whose declaration starts at the
+ * token with index procTokenInd and whose code starts at codeStart, as a new
+ * fragment, together with the symbols declared in it, which follow the symbol
+ * of the procedure at index procSymbolInd in the symbol table. The declaration
+ * should have just been consumed.
+ * Takes the ownership of the path.
+ * */
+void recordProcFragment(char* path, int procTokenInd, int procSymbolInd, int codeStart, unsigned long long interfaceHash);
+
+/**
+ * Returns the line of the token with index tokenInd, 0 if the positions of
+ * the tokens are not known.
+ * */
+int getTokenLine(int tokenInd);
+
 /**
  * Functions used for non-terminals of the grammar
  * 
@@ -102,6 +337,12 @@ int expression(int reg);
 int term(int reg);
 int factor(int reg);
 
+/**
+ * Parses a statement and generates code for it. statement() wraps this func
+ * to recover from the errors encountered while parsing the statement.
+ * */
+int statement_body(int reg);
+
 /******************************************************************************/
 /* Definitions of helper functions starts *************************************/
 /******************************************************************************/
@@ -121,15 +362,338 @@ void nextToken()
     _token_list_it.currentTokenInd++;
 }
 
+int isSynchronizingToken(int tokenType)
+{
+    return tokenType == semicolonsym || tokenType == endsym ||
+           tokenType == periodsym    || tokenType == nulsym || tokenType == 0;
+}
+
+int recoverFromError(int err)
+{
+    int tokenInd = _token_list_it.currentTokenInd;
+
+    // Record the error unless the previous error was on the same token
+    if(!_err_list.numberOfErrs || _err_list.errs[_err_list.numberOfErrs - 1].tokenInd != tokenInd)
+    {
+        _err_list.numberOfErrs++;
+        _err_list.errs = (CGErr*)realloc(_err_list.errs, _err_list.numberOfErrs * sizeof(CGErr));
+        _err_list.errs[_err_list.numberOfErrs - 1] = (CGErr){
+            .errCode = err, .tokenInd = tokenInd, .pos = getCurrentTokenPosFromIterator(_token_list_it)
+        };
+    }
+
+    // Stop parsing if the error limit is reached
+    if(_max_errs > 0 && _err_list.numberOfErrs >= _max_errs)
+        return err;
+
+    // Skip tokens until a synchronizing token
+    while(!isSynchronizingToken(getCurrentTokenType()))
+        nextToken();
+
+    return 0;
+}
+
+int recoverFromDeclarationError(int err)
+{
+    err = recoverFromError(err);
+
+    if(!err && getCurrentTokenType() == semicolonsym)
+        nextToken();
+
+    return err;
+}
+
+void setCGOutputFormat(int format)
+{
+    _output_format = format;
+}
+
+void setCGOptimizations(int optimizations)
+{
+    _optimizations = optimizations;
+}
+
+void setCGStats(Stats* stats)
+{
+    _stats = stats;
+}
+
+void setCGArena(Arena* arena)
+{
+    _arena = arena;
+}
+
+void setCGProcFragmentCache(ProcFragmentCache* cache)
+{
+    _fragment_cache = cache;
+}
+
+char* getProcPath(const char* name)
+{
+    // Compute the length of the path
+    int length = strlen(name);
+    for(Symbol* scope = currentScope; scope; scope = scope->scope)
+        length += strlen(scope->name) + 1;
+
+    // Fill the path from its end
+    char* path = (char*)malloc(length + 1);
+    path[length] = '\0';
+
+    int end = length - strlen(name);
+    memcpy(path + end, name, strlen(name));
+
+    for(Symbol* scope = currentScope; scope; scope = scope->scope)
+    {
+        path[--end] = '.';
+        end -= strlen(scope->name);
+        memcpy(path + end, scope->name, strlen(scope->name));
+    }
+
+    return path;
+}
+
+unsigned long long hashProcInterface()
+{
+    // 64-bit FNV-1a over the fields of the visible symbols
+    unsigned long long hash = 14695981039346656037ULL;
+    const unsigned long long prime = 1099511628211ULL;
+
+    int fields[4] = { currentLevel, _optimizations, 0, 0 };
+    for(int i = 0; i < 4; i++)
+    {
+        hash ^= (unsigned int)fields[i];
+        hash *= prime;
+    }
+
+    for(int i = 0; i < symbolTable.numberOfSymbols; i++)
+    {
+        Symbol* sym = symbolTable.symbols[i];
+
+        // Is the symbol declared in the current scope or one of its ancestors?
+        Symbol* scope = currentScope;
+        while(scope && scope != sym->scope)
+            scope = scope->scope;
+
+        if(scope != sym->scope)
+            continue;
+
+        fields[0] = sym->type;
+        fields[1] = sym->level;
+        fields[2] = sym->type == CONST ? sym->value : 0;
+        fields[3] = sym->type == VAR ? (int)sym->address : 0;
+
+        for(int j = 0; j < 4; j++)
+        {
+            hash ^= (unsigned int)fields[j];
+            hash *= prime;
+        }
+
+        for(const char* c = sym->name; ; c++)
+        {
+            hash ^= (unsigned char)*c;
+            hash *= prime;
+
+            if(!*c) break;
+        }
+    }
+
+    return hash;
+}
+
+int reuseProcFragment(const char* path, Symbol proc, int procTokenInd, unsigned long long interfaceHash)
+{
+    ProcFragment* f = findProcFragment(_fragment_cache, path);
+
+    if(!f || f->interfaceHash != interfaceHash)
+        return 0;
+
+    TokenList* tokenList = _token_list_it.tokenList;
+
+    if(procTokenInd + f->numberOfTokens > tokenList->numberOfTokens ||
+       hashTokens(tokenList, procTokenInd, f->numberOfTokens) != f->tokenHash)
+        return 0;
+
+    // Relocate the code of the fragment to its new place, and its lines to
+    // .. the ones the procedure is moved to
+    int base = nextCodeIndex;
+    int procLine = getTokenLine(procTokenInd);
+
+    for(int i = 0; i < f->codeLength; i++)
+    {
+        Instruction c = f->code[i];
+
+        if(f->relocs[i].type == RELOC_INTERNAL)
+        {
+            c.m += base;
+        }
+        else if(f->relocs[i].type == RELOC_EXTERNAL)
+        {
+            Symbol* target = findSymbol(&symbolTable, currentScope, f->relocs[i].target);
+
+            if(!target || target->type != PROC)
+            {
+                // Cannot be linked, generate the procedure again instead
+                nextCodeIndex = base;
+                return 0;
+            }
+
+            c.m = target->address;
+        }
+
+        int instr = emit(c.op, c.r, c.l, c.m);
+        vmLines[instr] = procLine ? procLine + f->lines[i] : 0;
+    }
+
+    // Add the symbols as block() would, the procedures at their new places
+    Symbol** added = (Symbol**)malloc((f->numberOfSymbols + 1) * sizeof(Symbol*));
+    Symbol* procSymbol = addSymbol(&symbolTable, proc);
+
+    for(int i = 0; i < f->numberOfSymbols; i++)
+    {
+        FragmentSymbol* s = &f->symbols[i];
+        Symbol sym;
+
+        sym.type = (SymbolType)s->type;
+        strcpy(sym.name, s->name);
+        sym.value = s->value;
+        sym.level = s->level;
+        sym.address = s->type == PROC ? base + s->address : s->address;
+        sym.scope = s->scope < 0 ? procSymbol : added[s->scope];
+
+        added[i] = addSymbol(&symbolTable, sym);
+    }
+
+    free(added);
+
+    // Skip the tokens of the procedure declaration
+    _token_list_it.currentTokenInd = procTokenInd + f->numberOfTokens;
+
+    return 1;
+}
+
+int getTokenLine(int tokenInd)
+{
+    TokenListIterator it = _token_list_it;
+    it.currentTokenInd = tokenInd;
+
+    return getCurrentTokenPosFromIterator(it).line;
+}
+
+void recordProcFragment(char* path, int procTokenInd, int procSymbolInd, int codeStart, unsigned long long interfaceHash)
+{
+    ProcFragment f;
+
+    f.path = path;
+    f.numberOfTokens = _token_list_it.currentTokenInd - procTokenInd;
+    f.tokenHash = hashTokens(_token_list_it.tokenList, procTokenInd, f.numberOfTokens);
+    f.interfaceHash = interfaceHash;
+    f.codeLength = nextCodeIndex - codeStart;
+    f.code = (Instruction*)malloc((f.codeLength + 1) * sizeof(Instruction));
+    f.relocs = (Relocation*)malloc((f.codeLength + 1) * sizeof(Relocation));
+    f.lines = (int*)malloc((f.codeLength + 1) * sizeof(int));
+
+    int procLine = getTokenLine(procTokenInd);
+
+    for(int i = 0; i < f.codeLength; i++)
+    {
+        Instruction c = vmCode[codeStart + i];
+        Relocation r = { .type = RELOC_NONE, .target = "" };
+
+        if(isJumpOp(c.op) || (c.op == CAL && c.m >= codeStart && c.m < nextCodeIndex))
+        {
+            // Jumps never leave the procedure, so only calls can be external
+            r.type = RELOC_INTERNAL;
+            c.m -= codeStart;
+        }
+        else if(c.op == CAL)
+        {
+            r.type = RELOC_EXTERNAL;
+
+            // Find the name of the procedure starting at the called address
+            for(int j = 0; j < symbolTable.numberOfSymbols; j++)
+            {
+                Symbol* sym = symbolTable.symbols[j];
+                if(sym->type == PROC && (int)sym->address == c.m)
+                    strcpy(r.target, sym->name);
+            }
+
+            c.m = 0;
+        }
+
+        f.code[i] = c;
+        f.relocs[i] = r;
+        f.lines[i] = vmLines[codeStart + i] ? vmLines[codeStart + i] - procLine : 0;
+    }
+
+    f.numberOfSymbols = symbolTable.numberOfSymbols - procSymbolInd - 1;
+    f.symbols = (FragmentSymbol*)malloc((f.numberOfSymbols + 1) * sizeof(FragmentSymbol));
+
+    for(int i = 0; i < f.numberOfSymbols; i++)
+    {
+        Symbol* sym = symbolTable.symbols[procSymbolInd + 1 + i];
+        FragmentSymbol* s = &f.symbols[i];
+
+        s->type = sym->type;
+        strcpy(s->name, sym->name);
+        s->value = sym->value;
+        s->level = sym->level;
+        s->address = sym->type == PROC ? (int)sym->address - codeStart : (int)sym->address;
+
+        // The scopes are the procedure or the procedures nested in it
+        s->scope = -1;
+        for(int j = 0; j < i; j++)
+        {
+            if(symbolTable.symbols[procSymbolInd + 1 + j] == sym->scope) s->scope = j;
+        }
+    }
+
+    putProcFragment(&_new_fragments, f);
+}
+
+void initCGErrList(CGErrList* errList)
+{
+    errList->errs = NULL;
+    errList->numberOfErrs = 0;
+}
+
+void deleteCGErrList(CGErrList* errList)
+{
+    if(!errList) return;
+
+    if(errList->errs)
+        free(errList->errs);
+
+    errList->errs = NULL;
+    errList->numberOfErrs = 0;
+}
+
 /**
- * Given the code generator error code, prints error message on file by applying
+ * Given the code generator error, prints error message on file by applying
  * required formatting.
  * */
-void printCGErr(int errCode, FILE* fp)
+void printCGErr(CGErr e, FILE* fp)
 {
-    if(!fp || !errCode) return;
+    if(!fp || !e.errCode) return;
 
-    fprintf(fp, "CODE GENERATOR ERROR[%d]: %s.\n", errCode, codeGeneratorErrMsg[errCode]);
+    if(e.pos.line)
+        fprintf(fp, "CODE GENERATOR ERROR[%d] at line %d, column %d: %s.\n", e.errCode, e.pos.line, e.pos.column, codeGeneratorErrMsg[e.errCode]);
+    else
+        fprintf(fp, "CODE GENERATOR ERROR[%d]: %s.\n", e.errCode, codeGeneratorErrMsg[e.errCode]);
+}
+
+void printCGErrList(CGErrList errList, FILE* fp)
+{
+    if(!fp) return;
+
+    for(int i = 0; i < errList.numberOfErrs; i++)
+    {
+        CGErr e = errList.errs[i];
+
+        if(e.pos.line)
+            printCGErr(e, fp);
+        else
+            fprintf(fp, "CODE GENERATOR ERROR[%d] at token %d: %s.\n", e.errCode, e.tokenInd, codeGeneratorErrMsg[e.errCode]);
+    }
 }
 
 int emit(int OP, int R, int L, int M)
@@ -141,12 +705,291 @@ int emit(int OP, int R, int L, int M)
     }
     
     vmCode[nextCodeIndex] = (Instruction){ .op = OP, .r = R, .l = L, .m = M};    
+    vmLines[nextCodeIndex] = getCurrentTokenPosFromIterator(_token_list_it).line;
 
     return nextCodeIndex++;
 }
 
+int emitFalseJump(int reg)
+{
+    Instruction last = vmCode[nextCodeIndex - 1];
+
+    if((_optimizations & CG_OPT_BRANCHES) && getBranchOp(last.op) && last.r == reg && last.l == reg && last.m == reg + 1)
+    {
+        int line = vmLines[--nextCodeIndex];
+        int instr = emit(invertCompareOp(getBranchOp(last.op)), reg, reg + 1, 0);
+
+        vmLines[instr] = line;
+        return instr;
+    }
+
+    return emit(JPC, reg, 0, 0);
+}
+
+void emitArithmetic(int op, int reg, int rightStart)
+{
+    Instruction right = vmCode[nextCodeIndex - 1], left = vmCode[rightStart - 1];
+
+    if(!(_optimizations & CG_OPT_ALGEBRA))
+    {
+        emit(op, reg, reg, reg + 1);
+    }
+    else if(right.op == LIT && rightStart == nextCodeIndex - 1)
+    {
+        nextCodeIndex--;
+        emitConstantOp(op, reg, right.m);
+    }
+    else if((op == ADD || op == MUL) && left.op == LIT && left.r == reg)
+    {
+        // c + x as x + c, computing the right operand into reg instead
+        shiftExpressionRegs(rightStart, -1);
+        removeCode(rightStart - 1, 1);
+        emitConstantOp(op, reg, left.m);
+    }
+    else
+    {
+        emit(op, reg, reg, reg + 1);
+    }
+}
+
+int findConstantOp(int reg, int op, int* size)
+{
+    int i = nextCodeIndex - 1;
+
+    while(i >= 1)
+    {
+        Instruction ins = vmCode[i], prev = vmCode[i - 1];
+
+        if(ins.op == SHF && ins.r == reg && ins.l == reg)
+        {
+            *size = 1;
+            return (ins.m > 0 ? op == MUL : op == DIV && i == nextCodeIndex - 1) ? i : -1;
+        }
+
+        if(ins.r != reg || ins.l != reg || ins.m != reg + 1) return -1;
+
+        // Only the additions and the subtractions, or the multiplications
+        // are reassociated, the divisions should be right after each other
+        int sameChain = (op == ADD || op == SUB) ? ins.op == ADD || ins.op == SUB : ins.op == op;
+        if(!sameChain || (op == DIV && i != nextCodeIndex - 1)) return -1;
+
+        if(prev.op == LIT && prev.r == reg + 1)
+        {
+            *size = 2;
+            return i - 1;
+        }
+
+        // Skip the right operand, which uses the registers above reg only
+        for(i--; i >= 0; i--)
+        {
+            Instruction operand = vmCode[i];
+            int minReg = operand.r;
+
+            if(operand.op != LIT && operand.op != LOD && operand.l < minReg) minReg = operand.l;
+            if(operand.op >= ADD && operand.op <= MOD && operand.m < minReg) minReg = operand.m;
+
+            if(minReg <= reg) break;
+        }
+    }
+
+    return -1;
+}
+
+void emitConstantOp(int op, int reg, int c)
+{
+    Instruction last = vmCode[nextCodeIndex - 1];
+    long long value = 0;
+
+    if(last.op == LIT && last.r == reg)
+    {
+        // Both of the operands are constants
+        if(op == ADD)      value = (long long)last.m + c;
+        else if(op == SUB) value = (long long)last.m - c;
+        else if(op == MUL) value = (long long)last.m * c;
+        else if(c)         value = (long long)last.m / c;
+
+        if((op != DIV || c) && value >= INT_MIN && value <= INT_MAX)
+        {
+            vmCode[nextCodeIndex - 1].m = (int)value;
+            _arithmetic_simplified++;
+            return;
+        }
+
+        emit(LIT, reg + 1, 0, c);
+        emit(op, reg, reg, reg + 1);
+        return;
+    }
+
+    // The constant operation of reg the constant is folded into: x + 1 + 2 as
+    // .. x + 3, x * 2 * y * 3 as x * y * 6, and x / 2 / 3 as x / 6
+    int size = 0;
+    int start = findConstantOp(reg, op, &size);
+
+    if(start >= 0)
+    {
+        Instruction prev = vmCode[start + size - 1];
+        int c2 = size == 2 ? vmCode[start].m : 1 << (prev.m > 0 ? prev.m : -prev.m);
+
+        if(op == ADD || op == SUB)
+            value = (prev.op == ADD ? (long long)c2 : -(long long)c2) + (op == ADD ? (long long)c : -(long long)c);
+        else
+            value = (long long)c2 * c;
+
+        if(value >= INT_MIN && value <= INT_MAX && (op != DIV || (c > 0 && c2 > 0)))
+        {
+            removeCode(start, size);
+            _arithmetic_simplified++;
+            emitConstantOp(op == SUB ? ADD : op, reg, (int)value);
+            return;
+        }
+    }
+
+    // The identity operations, x * -1 as -x and the powers of two as shifts
+    int shift = 0;
+    while(shift < 30 && (1 << shift) < c) shift++;
+
+    if(((op == ADD || op == SUB) && c == 0) || ((op == MUL || op == DIV) && c == 1))
+    {
+        _arithmetic_simplified++;
+    }
+    else if(op == MUL && c == -1)
+    {
+        _arithmetic_simplified++;
+        emit(NEG, reg, reg, 0);
+    }
+    else if((op == MUL || op == DIV) && c > 1 && (1 << shift) == c)
+    {
+        _arithmetic_simplified++;
+        emit(SHF, reg, reg, op == MUL ? shift : -shift);
+    }
+    else
+    {
+        // x + -c as x - c
+        if(op == ADD && c < 0 && c != INT_MIN)
+        {
+            op = SUB;
+            c = -c;
+        }
+
+        emit(LIT, reg + 1, 0, c);
+        emit(op, reg, reg, reg + 1);
+    }
+}
+
+void removeCode(int start, int count)
+{
+    memmove(&vmCode[start], &vmCode[start + count], (nextCodeIndex - start - count) * sizeof(Instruction));
+    memmove(&vmLines[start], &vmLines[start + count], (nextCodeIndex - start - count) * sizeof(int));
+
+    nextCodeIndex -= count;
+}
+
+void shiftExpressionRegs(int start, int shift)
+{
+    for(int i = start; i < nextCodeIndex; i++)
+    {
+        Instruction* ins = &vmCode[i];
+
+        ins->r += shift;
+
+        if(ins->op != LIT && ins->op != LOD) ins->l += shift;
+        if(ins->op != LIT && ins->op != LOD && ins->op != NEG && ins->op != SHF) ins->m += shift;
+    }
+}
+
+void optimizeCode()
+{
+    // The procedure of each symbol, found by the address before it changes
+    int* procOfSymbol = (int*)malloc((symbolTable.numberOfSymbols + 1) * sizeof(int));
+
+    for(int i = 0; i < symbolTable.numberOfSymbols; i++)
+    {
+        procOfSymbol[i] = -1;
+
+        for(int p = 0; symbolTable.symbols[i]->type == PROC && p < _call_graph.numberOfProcs; p++)
+        {
+            if(_call_graph.procs[p].start == (int)symbolTable.symbols[i]->address) procOfSymbol[i] = p;
+        }
+    }
+
+    for(int i = 0; i < (int)(sizeof(_passes) / sizeof(_passes[0])); i++)
+    {
+        if(!(_optimizations & _passes[i].optimization)) continue;
+
+        startStatTimer(_stats, _passes[i].timer, _passes[i].help);
+        _passes[i].run();
+        stopStatTimer(_stats, _passes[i].timer);
+    }
+
+    for(int i = 0; i < symbolTable.numberOfSymbols; i++)
+    {
+        if(procOfSymbol[i] < 0) continue;
+
+        CallGraphProc* proc = &_call_graph.procs[procOfSymbol[i]];
+        symbolTable.symbols[i]->address = proc->start >= 0 ? (unsigned int)proc->start : REMOVED_PROC_ADDRESS;
+    }
+
+    free(procOfSymbol);
+}
+
+void inlinePass()
+{
+    int inlinedCalls;
+    int numOfIns = inlineLeafProcs(&_call_graph, vmCode, vmLines, nextCodeIndex, MAX_CODE_LENGTH, &inlinedCalls);
+
+    addStatCount(_stats, "cg_calls_inlined_total", "Calls replaced with the body of the procedure", inlinedCalls);
+
+    nextCodeIndex = numOfIns;
+}
+
+void deadProcsPass()
+{
+    buildCallGraph(&_call_graph, vmCode, nextCodeIndex);
+
+    int unreachable = markReachableProcs(&_call_graph);
+    int numOfIns = unreachable ? eliminateDeadProcs(&_call_graph, vmCode, vmLines, nextCodeIndex) : nextCodeIndex;
+
+    addStatCount(_stats, "cg_procs_eliminated_total", "Unreachable procedures removed", unreachable);
+    addStatCount(_stats, "cg_instructions_eliminated_total", "Instructions removed with the unreachable procedures", nextCodeIndex - numOfIns);
+
+    nextCodeIndex = numOfIns;
+}
+
+void printEmittedObject()
+{
+    // The procedures, for the symbol section
+    PM0Symbol* procs = NULL;
+    int numberOfProcs = 0;
+
+    for(int i = 0; i < symbolTable.numberOfSymbols; i++)
+    {
+        Symbol* sym = symbolTable.symbols[i];
+        if(sym->type != PROC || sym->address == REMOVED_PROC_ADDRESS) continue;
+
+        numberOfProcs++;
+        procs = (PM0Symbol*)realloc(procs, numberOfProcs * sizeof(PM0Symbol));
+
+        PM0Symbol* p = &procs[numberOfProcs - 1];
+        memset(p->name, 0, sizeof(p->name));
+        strncpy(p->name, sym->name, sizeof(p->name) - 1);
+        p->level = sym->level;
+        p->address = sym->address;
+    }
+
+    if(writeObject(_out, vmCode, nextCodeIndex, procs, numberOfProcs, vmLines))
+        fprintf(stderr, "The code cannot be encoded in the object format.\n");
+
+    free(procs);
+}
+
 void printEmittedCodes()
 {
+    if(_output_format == CG_OUTPUT_OBJECT)
+    {
+        printEmittedObject();
+        return;
+    }
+
     for(int i = 0; i < nextCodeIndex; i++)
     {
         Instruction c = vmCode[i];
@@ -168,6 +1011,14 @@ void printEmittedCodes()
  * */
 int codeGenerator(TokenList tokenList, FILE* out)
 {
+    // Stop at the first error
+    return codeGeneratorWithRecovery(tokenList, out, 1, NULL);
+}
+
+int codeGeneratorWithRecovery(TokenList tokenList, FILE* out, int maxErrs, CGErrList* errList)
+{
+    startStatTimer(_stats, "cg", "Time spent generating code");
+
     // Set output file pointer
     _out = out;
 
@@ -189,13 +1040,32 @@ int codeGenerator(TokenList tokenList, FILE* out)
     // The id of the register currently being used
     currentReg = 0;
 
+    _arithmetic_simplified = 0;
+
     // Initialize symbol table
-    initSymbolTable(&symbolTable);
+    initSymbolTableInArena(&symbolTable, _arena);
+
+    // Initialize the call graph, to which the procedures are added as they
+    // .. are generated
+    initCallGraph(&_call_graph);
+
+    // Initialize error list and the error limit
+    initCGErrList(&_err_list);
+    _max_errs = maxErrs;
+
+    // Initialize the list of the fragments generated in this run
+    initProcFragmentCache(&_new_fragments);
 
     // Start parsing by parsing program as the grammar suggests.
-    int err = program();
+    program();
+
+    // The first error collected, if any, is the result of the code generation
+    int err = _err_list.numberOfErrs ? _err_list.errs[0].errCode : 0;
+
+    // Optimize and print the code - if no error occured
+    if(!err && _optimizations)
+        optimizeCode();
 
-    // Print symbol table - if no error occured
     if(!err)
     {
         // Print the emitted codes to the file
@@ -205,12 +1075,46 @@ int codeGenerator(TokenList tokenList, FILE* out)
     // Reset output file pointer
     _out = NULL;
 
+    // Add the metrics of the run
+    addStatCount(_stats, "cg_tokens_total", "Tokens parsed by the code generator", _token_list_it.currentTokenInd);
+    addStatCount(_stats, "cg_symbols_added_total", "Symbols added to the symbol table", symbolTable.numberOfSymbols);
+    addStatCount(_stats, "cg_symbol_lookups_total", "findSymbol() calls", symbolTable.numberOfLookups);
+    addStatCount(_stats, "cg_symbol_probes_total", "Symbols compared by findSymbol()", symbolTable.numberOfProbes);
+    addStatCount(_stats, "cg_instructions_emitted_total", "Instructions emitted", nextCodeIndex);
+    addStatCount(_stats, "cg_arithmetic_simplified_total", "Arithmetic operations folded, removed or replaced with shifts", _arithmetic_simplified);
+
     // Reset the global TokenListIterator
     _token_list_it.currentTokenInd = 0;
     _token_list_it.tokenList = NULL;
 
-    // Delete symbol table
+    // Delete symbol table and the call graph
     deleteSymbolTable(&symbolTable);
+    deleteCallGraph(&_call_graph);
+
+    // Pass the collected errors to the caller - if requested
+    for(int i = 0; errList && i < _err_list.numberOfErrs; i++)
+    {
+        errList->numberOfErrs++;
+        errList->errs = (CGErr*)realloc(errList->errs, errList->numberOfErrs * sizeof(CGErr));
+        errList->errs[errList->numberOfErrs - 1] = _err_list.errs[i];
+    }
+
+    // Delete error list
+    deleteCGErrList(&_err_list);
+
+    // Update the fragment cache with the new fragments - if successful
+    for(int i = 0; !err && _fragment_cache && i < _new_fragments.numberOfFragments; i++)
+    {
+        putProcFragment(_fragment_cache, _new_fragments.fragments[i]);
+        _new_fragments.fragments[i].path = NULL;
+        _new_fragments.fragments[i].code = NULL;
+        _new_fragments.fragments[i].relocs = NULL;
+        _new_fragments.fragments[i].lines = NULL;
+        _new_fragments.fragments[i].symbols = NULL;
+    }
+    deleteProcFragmentCache(&_new_fragments);
+
+    stopStatTimer(_stats, "cg");
 
     // Return err code - which is 0 if parsing was successful
     return err;
@@ -237,7 +1141,7 @@ int program()
     else
     {
         // Periodsym was expected. Return error code 6.
-        return 6;
+        return recoverFromError(6);
     }
 }
 
@@ -248,10 +1152,14 @@ int block()
     emit(INC, 0, 0, 4);
     
     int err = const_declaration();
+    if (err)
+        err = recoverFromDeclarationError(err);
     if (err)
         return err;
 
     err = var_declaration();
+    if (err)
+        err = recoverFromDeclarationError(err);
     if (err)
         return err;
     
@@ -405,42 +1313,101 @@ int proc_declaration()
     {
         Symbol sym;
         sym.type = PROC;
+
+        // Index of procsym, where the declaration of the procedure starts
+        int procTokenInd = _token_list_it.currentTokenInd;
         
         nextToken();
         if (getCurrentTokenType() != identsym)
         {
-            return 3;
+            int err = recoverFromDeclarationError(3);
+            if (err)
+                return err;
+            continue;
         }
         
         strcpy(sym.name, getCurrentToken().lexeme);
         sym.level = currentLevel;
         sym.scope = currentScope;
         sym.address = nextCodeIndex;
+
+        // Reuse the code generated before for the procedure - if unchanged
+        char* path = NULL;
+        unsigned long long interfaceHash = 0;
+        if (_fragment_cache)
+        {
+            path = getProcPath(sym.name);
+            interfaceHash = hashProcInterface();
+
+            if (reuseProcFragment(path, sym, procTokenInd, interfaceHash))
+            {
+                free(path);
+                addCallGraphProc(&_call_graph, sym.address, nextCodeIndex);
+                addNestedCallGraphProcs(&_call_graph, vmCode, sym.address, nextCodeIndex);
+                continue;
+            }
+        }
+
         Symbol *tmpScope = currentScope;
+        int procSymbolInd = symbolTable.numberOfSymbols;
         currentScope = addSymbol(&symbolTable, sym);
         nextToken();
         if (getCurrentTokenType() != semicolonsym)
         {
-            return 5;
+            currentScope = tmpScope;
+            free(path);
+
+            int err = recoverFromDeclarationError(5);
+            if (err)
+                return err;
+            continue;
         }
         
         nextToken();
         
         int err = block();
+
+        // Back to the scope the procedure is declared in
+        currentScope = tmpScope;
         
         if (err)
+        {
+            free(path);
             return err;
+        }
 
         if (getCurrentTokenType() != semicolonsym)
         {
-            return 5;
+            free(path);
+
+            err = recoverFromDeclarationError(5);
+            if (err)
+                return err;
+            continue;
         }
         nextToken();
+
+        addCallGraphProc(&_call_graph, sym.address, nextCodeIndex);
+
+        if (path)
+            recordProcFragment(path, procTokenInd, procSymbolInd, sym.address, interfaceHash);
     }
     return 0;
 }
 
 int statement(int reg)
+{
+    int err = statement_body(reg);
+
+    // Skip the rest of the statement on error, so that the enclosing
+    // .. statement can continue parsing from the following one.
+    if(err)
+        return recoverFromError(err);
+
+    return 0;
+}
+
+int statement_body(int reg)
 {
     if(getCurrentTokenType() == identsym)
     {
@@ -554,11 +1521,8 @@ int statement(int reg)
             return 9;
         }
         
-        // Hold onto the next index used in the VMCode array
-        int instr = nextCodeIndex;
-
         // Jump conditionally when you skip to end of the "then" part of an if-then statement
-        emit(JPC, reg, 0, 0);
+        int instr = emitFalseJump(reg);
 
         // Consume the token and move forward
         nextToken();
@@ -596,8 +1560,7 @@ int statement(int reg)
         if(err)
           return err;
         
-        int instr2 = nextCodeIndex;
-        emit(JPC, reg, 0, 0);
+        int instr2 = emitFalseJump(reg);
 
         if(getCurrentTokenType() != dosym)
         {
@@ -610,7 +1573,48 @@ int statement(int reg)
         if(err)
           return err;
         
-        emit(JMP, 0, 0, instr1);
+        // The code of the condition, without its jump. With a JPC, the
+        // condition should end with a relational instruction to be inverted.
+        int condLength = instr2 - instr1;
+        int rotatable = vmCode[instr2].op != JPC || invertCompareOp(vmCode[instr2 - 1].op);
+
+        if((_optimizations & CG_OPT_LOOPS) && rotatable && nextCodeIndex + condLength < MAX_CODE_LENGTH)
+        {
+            // Rotate the loop: test the condition again at the bottom, and
+            // jump back to the body while it holds
+            for(int i = instr1; i < instr2; i++)
+            {
+                vmCode[nextCodeIndex] = vmCode[i];
+                vmLines[nextCodeIndex] = vmLines[i];
+                nextCodeIndex++;
+            }
+
+            Instruction jump = vmCode[instr2];
+
+            if(jump.op == JPC)
+            {
+                vmCode[nextCodeIndex - 1].op = invertCompareOp(vmCode[nextCodeIndex - 1].op);
+                emit(JPC, reg, 0, instr2 + 1);
+            }
+            else
+            {
+                emit(invertCompareOp(jump.op), jump.r, jump.l, instr2 + 1);
+            }
+
+            int hoisted, reduced;
+
+            startStatTimer(_stats, "cg_pass_loops", "Time spent optimizing loops");
+            nextCodeIndex = optimizeLoop(vmCode, vmLines, instr2 + 1, nextCodeIndex, MAX_CODE_LENGTH, &hoisted, &reduced);
+            stopStatTimer(_stats, "cg_pass_loops");
+
+            addStatCount(_stats, "cg_loops_rotated_total", "Loops with the condition tested at the bottom", 1);
+            addStatCount(_stats, "cg_loop_invariants_hoisted_total", "Loop-invariant expressions moved out of the loops", hoisted);
+            addStatCount(_stats, "cg_muls_reduced_total", "Multiplications by loop counters replaced with additions", reduced);
+        }
+        else
+        {
+            emit(JMP, 0, 0, instr1);
+        }
         vmCode[instr2].m = nextCodeIndex;
 
         return 0;
@@ -629,6 +1633,10 @@ int statement(int reg)
 
         // Grab the symbol you are on right now
         Symbol *sym = findSymbol(&symbolTable, currentScope, getCurrentToken().lexeme);
+
+        // If error found then return undeclared identifier error
+        if(!sym)
+            return 15;
         
         if(sym->type != VAR)
         {
@@ -659,6 +1667,10 @@ int statement(int reg)
 
         Symbol *sym = findSymbol(&symbolTable, currentScope, getCurrentToken().lexeme);
 
+        // If error found then return undeclared identifier error
+        if(!sym)
+            return 15;
+
         // Check the symbol type to see if its a VAR. If so emit a LOD operation
         if(sym->type == VAR)
         {
@@ -769,7 +1781,15 @@ int expression(int reg)
     int err = term(reg);
     
     if (op == minussym)
-        emit(NEG, reg, reg, 0);
+    {
+        Instruction* last = &vmCode[nextCodeIndex - 1];
+
+        // -c as a constant
+        if (!err && (_optimizations & CG_OPT_ALGEBRA) && last->op == LIT && last->r == reg && last->m != INT_MIN)
+            last->m = -last->m;
+        else
+            emit(NEG, reg, reg, 0);
+    }
 
     if(err)
         return err;
@@ -779,11 +1799,13 @@ int expression(int reg)
         op = getCurrentTokenType();
         nextToken();
         
+        int rightStart = nextCodeIndex;
+
         err = term(reg + 1);
         if(err)
             return err;
         
-        emit(op == plussym ? ADD : SUB, reg, reg, reg + 1);
+        emitArithmetic(op == plussym ? ADD : SUB, reg, rightStart);
     }
     
     return 0;
@@ -806,6 +1828,8 @@ int term(int reg)
         if(getCurrentToken().id == nulsym)
             return 6; // Error: Period expected
 
+        int rightStart = nextCodeIndex;
+
         // Call the factor function
         int fact = factor(reg + 1);
 
@@ -814,7 +1838,7 @@ int term(int reg)
             return fact;
         
         // Emit either mult op or div op (reg = reg + (reg + 1))
-        emit(tok == multsym ? MUL : DIV, reg, reg, reg + 1);
+        emitArithmetic(tok == multsym ? MUL : DIV, reg, rightStart);
     }
     
     // Successful parsing
@@ -2,9 +2,151 @@
 #define __CODE_GENERATOR_H__
 
 #include "token.h"
+#include "fragment.h"
+#include "stats.h"
+
+/**
+ * Version of the code generator. Should be bumped whenever the generated code
+ * .. changes for the same input, since it is a part of the cache keys.
+ * */
+#define CODE_GENERATOR_VERSION "pl0cg-1.6"
+
+/**
+ * Output formats of the generated code: the PM/0 assembly text, one
+ * .. instruction per line, or the binary object format of
+ * .. vm/object_format.h.
+ * */
+enum {
+    CG_OUTPUT_TEXT   = 0,
+    CG_OUTPUT_OBJECT = 1
+};
+
+/**
+ * Optimizations of the generated code, as bit flags for
+ * .. setCGOptimizations().
+ * */
+enum {
+    CG_OPT_DEAD_PROCS = 1, // remove the procedures unreachable from the main block
+    CG_OPT_INLINE     = 2, // inline the calls to small leaf procedures
+    CG_OPT_LOOPS      = 4, // rotate the while loops, move the loop-invariant expressions
+                           // out of them and reduce the multiplications by loop counters
+    CG_OPT_BRANCHES   = 8, // fuse the relational instructions of the if and while
+                           // conditions with their jumps
+    CG_OPT_ALGEBRA    = 16 // fold the constant operands, remove the identity operations
+                           // and replace the multiplications and divisions by powers
+                           // of two with shifts
+};
+
+#define CG_OPT_DEFAULT (CG_OPT_DEAD_PROCS | CG_OPT_INLINE | CG_OPT_LOOPS | CG_OPT_BRANCHES | CG_OPT_ALGEBRA)
+
+/**
+ * The optimizations of each optimization level of code_generator.out -O:
+ * .. none, which generates the code as the original code generator does, the
+ * .. peephole optimizations of the code of single statements, and all of
+ * .. them, which is the default.
+ * The one difference from the original code generator at level 0 is the
+ * .. scope of the identifiers after a procedure declaration, which it
+ * .. resolved from inside the procedure, emitting an L of -1 for the
+ * .. variables that the procedure declares again.
+ * */
+#define CG_OPT_LEVEL_0 0
+#define CG_OPT_LEVEL_1 (CG_OPT_BRANCHES | CG_OPT_ALGEBRA)
+#define CG_OPT_LEVEL_2 CG_OPT_DEFAULT
+
+/**
+ * A single code generator diagnostic: the error code, the index of the token,
+ * .. in the token list given to the code generator, that the error was
+ * .. encountered on, and the source code position of that token - if known.
+ * */
+typedef struct {
+    int errCode;
+    int tokenInd;
+    TokenPos pos;
+} CGErr;
+
+/**
+ * The list of diagnostics collected by the code generator in a single run.
+ * */
+typedef struct {
+    CGErr* errs;
+    int numberOfErrs;
+} CGErrList;
 
 int codeGenerator(TokenList, FILE*);
 
-void printCGErr(int errCode, FILE*);
+/**
+ * Same as codeGenerator(), but does not stop at the first error. Instead,
+ * .. recovers in panic mode by skipping tokens until a synchronizing token
+ * .. (semicolonsym, endsym or periodsym), and keeps parsing until maxErrs
+ * .. errors are collected. maxErrs <= 0 means no cap on the number of errors.
+ * The collected errors are appended to errList, if errList is not NULL.
+ * Returns the code of the first error encountered, or 0 on success. No code
+ * .. is printed unless the code generation is successful.
+ * */
+int codeGeneratorWithRecovery(TokenList, FILE*, int maxErrs, CGErrList* errList);
+
+/**
+ * Prints the error message of the given error. If the source code position of
+ * .. the error is known, the message points to its line and column.
+ * */
+void printCGErr(CGErr, FILE*);
+
+/**
+ * Sets the cache of procedure fragments used by the following code generator
+ * .. runs. NULL, which is the default, disables the cache.
+ * The code of a procedure whose tokens and the symbols visible to it are the
+ * .. same as one in the cache is not generated again, but the cached code is
+ * .. relocated to its place. After a successful run, the cache is updated with
+ * .. the fragments of all the procedures that are generated.
+ * */
+void setCGProcFragmentCache(ProcFragmentCache*);
+
+/**
+ * Sets the format the generated code is printed in by the following code
+ * .. generator runs. CG_OUTPUT_TEXT is the default. Error messages are always
+ * .. printed as text.
+ * */
+void setCGOutputFormat(int format);
+
+/**
+ * Sets the optimizations the following code generator runs apply to the
+ * .. generated code, as a combination of the CG_OPT_ flags. CG_OPT_DEFAULT
+ * .. is the default, and 0 disables all of them.
+ * */
+void setCGOptimizations(int optimizations);
+
+/**
+ * Sets the stats the following code generator runs add their metrics to, see
+ * .. stats.h: the time spent, the number of tokens parsed, symbols added,
+ * .. findSymbol() calls and the symbols compared by them, instructions
+ * .. emitted, the calls inlined, the procedures and instructions removed
+ * .. as unreachable, and the arithmetic operations simplified. NULL, which
+ * .. is the default, disables them.
+ * */
+void setCGStats(Stats*);
+
+/**
+ * Sets the arena the following code generator runs allocate their symbol
+ * .. tables in, see arena.h. NULL, which is the default, allocates them on
+ * .. the heap. The generated code is in the fixed vmCode array either way.
+ * */
+void setCGArena(Arena*);
+
+/**
+ * Prints each of the errors in the given list on its own line, together with
+ * .. its source code position, or the index of the token the error was
+ * .. encountered on if the position is not known.
+ * */
+void printCGErrList(CGErrList, FILE*);
+
+/**
+ * Initializes the given CGErrList to an empty list.
+ * */
+void initCGErrList(CGErrList*);
+
+/**
+ * Makes the necessary deallocations on the CGErrList.
+ * */
+void deleteCGErrList(CGErrList*);
 
-#endif
\ No newline at end of file
+#endif
@@ -20,6 +20,23 @@ const char* tokenNames[] = {
     [writesym] = "writesym", [readsym] = "readsym", [elsesym] =      "elsesym"
 };
 
+const char* tokenLexemes[] = {
+    [nulsym] = "", [identsym] = "", [numbersym] = "",
+
+    // Special symbols (+ odd)
+    [plussym]    = "+",  [minussym] = "-",   [multsym]      = "*", [slashsym]  = "/",
+    [oddsym]     = "odd", [eqsym]   = "=",   [neqsym]       = "<>", [lessym]   = "<",
+    [leqsym]     = "<=", [gtrsym]   = ">",   [geqsym]       = ">=", [lparentsym] = "(",
+    [rparentsym] = ")",  [commasym] = ",",   [semicolonsym] = ";", [periodsym] = ".",
+    [becomessym] = ":=",
+
+    // Reserved words
+    [beginsym] = "begin", [endsym]  = "end",  [ifsym]   = "if",   [thensym] = "then",
+    [whilesym] = "while", [dosym]   = "do",   [callsym] = "call",
+    [constsym] = "const", [varsym]  = "var",  [procsym] = "procedure",
+    [writesym] = "write", [readsym] = "read", [elsesym] = "else"
+};
+
 const char* codeGeneratorErrMsg[] =
 {
     [0] = "SUCCESS",
@@ -67,5 +84,41 @@ const char* opcodeNames[] = {
     
     [NEG] = "NEG", [ADD] = "ADD", [SUB] = "SUB", [MUL] = "MUL", [DIV] = "DIV",
     [ODD] = "ODD", [MOD] = "MOD", [EQL] = "EQL", [NEQ] = "NEQ", [LSS] = "LSS",
-    [LEQ] = "LEQ", [GTR] = "GTR", [GEQ] = "GEQ"
-};
\ No newline at end of file
+    [LEQ] = "LEQ", [GTR] = "GTR", [GEQ] = "GEQ",
+
+    [JEQ] = "JEQ", [JNE] = "JNE", [JLT] = "JLT", [JLE] = "JLE", [JGT] = "JGT", [JGE] = "JGE",
+
+    [SHF] = "SHF"
+};
+
+int isJumpOp(int op)
+{
+    return op == JMP || op == JPC || (op >= JEQ && op <= JGE);
+}
+
+int invertCompareOp(int op)
+{
+    switch(op)
+    {
+        case EQL: return NEQ;
+        case NEQ: return EQL;
+        case LSS: return GEQ;
+        case GEQ: return LSS;
+        case LEQ: return GTR;
+        case GTR: return LEQ;
+
+        case JEQ: return JNE;
+        case JNE: return JEQ;
+        case JLT: return JGE;
+        case JGE: return JLT;
+        case JLE: return JGT;
+        case JGT: return JLE;
+
+        default:  return 0;
+    }
+}
+
+int getBranchOp(int op)
+{
+    return op >= EQL && op <= GEQ ? op - EQL + JEQ : 0;
+}
\ No newline at end of file
@@ -4,6 +4,10 @@
 #define MAX_CODE_LENGTH 500
 #define AR_VARIABLE_OFFSET 4
 
+// Limits of the virtual machine, see vm/data.h
+#define MAX_STACK_HEIGHT 2000
+#define REGISTER_FILE_REG_COUNT 16
+
 // Instruction
 typedef struct {
     int op;  // opcode
@@ -19,7 +23,13 @@ enum {
     SIO_WRITE = 9, SIO_READ = 10, SIO_HALT = 11,
     
     NEG = 12, ADD = 13, SUB = 14, MUL = 15, DIV = 16, ODD = 17, MOD = 18,
-    EQL = 19, NEQ = 20, LSS = 21, LEQ = 22, GTR = 23, GEQ = 24
+    EQL = 19, NEQ = 20, LSS = 21, LEQ = 22, GTR = 23, GEQ = 24,
+
+    // Compare-and-branch: jump to M if RF[R] compares to RF[L], in the order of EQL - GEQ
+    JEQ = 25, JNE = 26, JLT = 27, JLE = 28, JGT = 29, JGE = 30,
+
+    // Shift: RF[R] = RF[L] * 2^M, or RF[L] / 2^-M rounding toward zero as DIV if M is negative
+    SHF = 31
 };
 
 // Numerical values assigned to each token
@@ -47,10 +57,32 @@ typedef enum {
 // The string representation of each token, if applicable (identsym and numbersym excluded)
 extern const char* tokenNames[];
 
+// The lexeme of each token in the source code (identsym and numbersym excluded)
+extern const char* tokenLexemes[];
+
 extern const char* codeGeneratorErrMsg[];
 
 extern const char* nonTerminalNames[];
 
 extern const char* opcodeNames[];
 
+/**
+ * Returns 1 if op jumps to the address in M: JMP, JPC and the
+ * .. compare-and-branch opcodes. Returns 0 otherwise.
+ * */
+int isJumpOp(int op);
+
+/**
+ * Returns the opcode testing the negation of the relational or
+ * .. compare-and-branch opcode op, e.g. GEQ for LSS and JGE for JLT, or 0 if
+ * .. op is neither.
+ * */
+int invertCompareOp(int op);
+
+/**
+ * Returns the compare-and-branch opcode of the relational opcode op, e.g.
+ * .. JLT for LSS, or 0 if op is not relational.
+ * */
+int getBranchOp(int op);
+
 #endif
\ No newline at end of file
@@ -0,0 +1,156 @@
+#include "fragment.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+void initProcFragmentCache(ProcFragmentCache* cache)
+{
+    cache->fragments = NULL;
+    cache->numberOfFragments = 0;
+}
+
+void deleteProcFragment(ProcFragment* fragment)
+{
+    if(!fragment) return;
+
+    if(fragment->path)   free(fragment->path);
+    if(fragment->code)   free(fragment->code);
+    if(fragment->relocs) free(fragment->relocs);
+    if(fragment->lines)  free(fragment->lines);
+    if(fragment->symbols) free(fragment->symbols);
+
+    fragment->path = NULL;
+    fragment->code = NULL;
+    fragment->relocs = NULL;
+    fragment->lines = NULL;
+    fragment->symbols = NULL;
+    fragment->codeLength = 0;
+    fragment->numberOfSymbols = 0;
+}
+
+void deleteProcFragmentCache(ProcFragmentCache* cache)
+{
+    if(!cache) return;
+
+    for(int i = 0; i < cache->numberOfFragments; i++)
+        deleteProcFragment(&cache->fragments[i]);
+
+    if(cache->fragments)
+        free(cache->fragments);
+
+    cache->fragments = NULL;
+    cache->numberOfFragments = 0;
+}
+
+ProcFragment* findProcFragment(ProcFragmentCache* cache, const char* path)
+{
+    if(!cache || !path) return NULL;
+
+    for(int i = 0; i < cache->numberOfFragments; i++)
+    {
+        if(!strcmp(cache->fragments[i].path, path))
+            return &cache->fragments[i];
+    }
+
+    return NULL;
+}
+
+void putProcFragment(ProcFragmentCache* cache, ProcFragment fragment)
+{
+    ProcFragment* old = findProcFragment(cache, fragment.path);
+
+    if(old)
+    {
+        deleteProcFragment(old);
+        *old = fragment;
+        return;
+    }
+
+    cache->numberOfFragments++;
+    cache->fragments = (ProcFragment*)realloc(cache->fragments, cache->numberOfFragments * sizeof(ProcFragment));
+    cache->fragments[cache->numberOfFragments - 1] = fragment;
+}
+
+void printProcFragmentCache(ProcFragmentCache* cache, FILE* out)
+{
+    if(!cache || !out) return;
+
+    fprintf(out, "%d %d\n", PROC_FRAGMENT_FORMAT_VERSION, cache->numberOfFragments);
+
+    for(int i = 0; i < cache->numberOfFragments; i++)
+    {
+        ProcFragment* f = &cache->fragments[i];
+
+        fprintf(out, "%s %d %llx %llx %d %d\n", f->path, f->numberOfTokens, f->tokenHash, f->interfaceHash, f->codeLength, f->numberOfSymbols);
+
+        for(int j = 0; j < f->codeLength; j++)
+        {
+            Instruction c = f->code[j];
+            Relocation r = f->relocs[j];
+
+            fprintf(out, "%d %d %d %d %d %s %d\n", c.op, c.r, c.l, c.m, r.type, r.type == RELOC_EXTERNAL ? r.target : "-", f->lines[j]);
+        }
+
+        for(int j = 0; j < f->numberOfSymbols; j++)
+        {
+            FragmentSymbol* sym = &f->symbols[j];
+
+            fprintf(out, "%d %s %d %d %d %d\n", sym->type, sym->name, sym->value, sym->level, sym->address, sym->scope);
+        }
+    }
+}
+
+int readProcFragmentCache(ProcFragmentCache* cache, FILE* in)
+{
+    int version, numberOfFragments, numberRead = 0;
+
+    if(!cache || !in || fscanf(in, "%d %d", &version, &numberOfFragments) != 2 || version != PROC_FRAGMENT_FORMAT_VERSION)
+        return 0;
+
+    for(int i = 0; i < numberOfFragments; i++)
+    {
+        // Paths are made of at most a few identifiers of 11 characters
+        char path[256];
+        ProcFragment f;
+
+        if(fscanf(in, "%255s %d %llx %llx %d %d", path, &f.numberOfTokens, &f.tokenHash, &f.interfaceHash, &f.codeLength, &f.numberOfSymbols) != 6 ||
+           f.codeLength < 0 || f.numberOfSymbols < 0)
+            break;
+
+        f.path = (char*)malloc(strlen(path) + 1);
+        strcpy(f.path, path);
+        f.code = (Instruction*)malloc((f.codeLength + 1) * sizeof(Instruction));
+        f.relocs = (Relocation*)malloc((f.codeLength + 1) * sizeof(Relocation));
+        f.lines = (int*)malloc((f.codeLength + 1) * sizeof(int));
+        f.symbols = (FragmentSymbol*)malloc((f.numberOfSymbols + 1) * sizeof(FragmentSymbol));
+
+        int ok = 1;
+        for(int j = 0; j < f.codeLength && ok; j++)
+        {
+            Instruction* c = &f.code[j];
+            int type;
+
+            ok = fscanf(in, "%d %d %d %d %d %11s %d", &c->op, &c->r, &c->l, &c->m, &type, f.relocs[j].target, &f.lines[j]) == 7;
+            f.relocs[j].type = (RelocType)type;
+        }
+
+        for(int j = 0; j < f.numberOfSymbols && ok; j++)
+        {
+            FragmentSymbol* sym = &f.symbols[j];
+
+            ok = fscanf(in, "%d %11s %d %d %d %d", &sym->type, sym->name, &sym->value, &sym->level, &sym->address, &sym->scope) == 6 &&
+                 sym->scope >= -1 && sym->scope < j;
+        }
+
+        if(!ok)
+        {
+            deleteProcFragment(&f);
+            break;
+        }
+
+        putProcFragment(cache, f);
+        numberRead++;
+    }
+
+    return numberRead;
+}
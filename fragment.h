@@ -0,0 +1,139 @@
+#ifndef __FRAGMENT_H__
+#define __FRAGMENT_H__
+
+#include <stdio.h>
+#include "data.h"
+
+/**
+ * Version of the format printProcFragmentCache() prints, so that the files
+ * .. printed in an older format are not read.
+ * */
+#define PROC_FRAGMENT_FORMAT_VERSION 3
+
+/**
+ * The ways the M field of an instruction of a fragment is relocated when the
+ * .. fragment is placed in the code.
+ * */
+typedef enum {
+    RELOC_NONE,     // M is not an address
+    RELOC_INTERNAL, // M is an address relative to the start of the fragment
+    RELOC_EXTERNAL  // M is the address of a procedure declared outside of the fragment
+} RelocType;
+
+/**
+ * Relocation of a single instruction of a fragment. target is the name of
+ * .. the called procedure for RELOC_EXTERNAL, and empty otherwise.
+ * */
+typedef struct {
+    RelocType type;
+    char target[12];
+} Relocation;
+
+/**
+ * A symbol declared in the procedure of a fragment, in a nested procedure or
+ * .. the procedure itself. type is a SymbolType, and the address of a PROC is
+ * .. relative to the start of the fragment. scope is the index of the symbol
+ * .. of the procedure the symbol is declared in, -1 for the procedure of the
+ * .. fragment.
+ * */
+typedef struct {
+    int type;
+    char name[12];
+    int value;
+    int level;
+    int address;
+    int scope;
+} FragmentSymbol;
+
+/**
+ * Relocatable code of a procedure, including its nested procedures, together
+ * .. with what it was generated from: the tokens of the procedure declaration,
+ * .. and the interface of the procedure, i.e. the symbols visible to it.
+ * The fragment can be reused as long as both of them are unchanged.
+ * */
+typedef struct {
+    /**
+     * The names of the enclosing procedures and the procedure, separated by
+     * .. '.', e.g. "g.gx". Identifies the procedure in a program.
+     * */
+    char* path;
+
+    /**
+     * Number of the tokens from the procsym to the semicolon terminating the
+     * .. declaration, and the hash of them.
+     * */
+    int numberOfTokens;
+    unsigned long long tokenHash;
+
+    /**
+     * Hash of the symbols visible to the procedure at its declaration.
+     * */
+    unsigned long long interfaceHash;
+
+    /**
+     * The code, the relocation of each instruction in the code, and the
+     * .. source line of each instruction relative to the line of the procsym,
+     * .. so that the lines are right wherever the procedure is moved to.
+     * The lines are zero if the positions of the tokens are not known.
+     * */
+    Instruction* code;
+    Relocation* relocs;
+    int* lines;
+    int codeLength;
+
+    /**
+     * The symbols declared in the procedure, in the order they are added to
+     * .. the symbol table, which are added again when the fragment is reused.
+     * */
+    FragmentSymbol* symbols;
+    int numberOfSymbols;
+} ProcFragment;
+
+/**
+ * Set of fragments, at most one per procedure path.
+ * */
+typedef struct {
+    ProcFragment* fragments;
+    int numberOfFragments;
+} ProcFragmentCache;
+
+/**
+ * Initializes the given cache to an empty cache.
+ * */
+void initProcFragmentCache(ProcFragmentCache*);
+
+/**
+ * Makes the necessary deallocations on the cache and its fragments.
+ * */
+void deleteProcFragmentCache(ProcFragmentCache*);
+
+/**
+ * Makes the necessary deallocations on the members of the fragment.
+ * */
+void deleteProcFragment(ProcFragment*);
+
+/**
+ * Returns the fragment of the procedure with the given path, NULL if there
+ * .. is no such fragment in the cache.
+ * */
+ProcFragment* findProcFragment(ProcFragmentCache*, const char* path);
+
+/**
+ * Adds the fragment to the cache, replacing the fragment with the same path
+ * .. - if exists. The cache takes the ownership of the members of the fragment.
+ * */
+void putProcFragment(ProcFragmentCache*, ProcFragment);
+
+/**
+ * Writes the fragments in the cache to the given file.
+ * */
+void printProcFragmentCache(ProcFragmentCache*, FILE*);
+
+/**
+ * Reads the fragments from the given file, in the format printProcFragmentCache()
+ * .. prints, and adds them to the cache. Returns the number of fragments read,
+ * .. which is zero if the file is in another version of the format.
+ * */
+int readProcFragmentCache(ProcFragmentCache*, FILE*);
+
+#endif
@@ -0,0 +1,984 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include "../token.h"
+#include "../code_generator.h"
+#include "../data.h"
+#include "../aot.h"
+#include "../vm/vm.h"
+#include "fuzz_runner.h"
+
+/**
+ * Differential fuzzing harness of the code generator and the virtual machine.
+ * Each input is turned into a well-formed PL/0 token list, which is compiled
+ * .. at every optimization level and run in every engine of the virtual
+ * .. machine, in the runner and compiled ahead of time. The error codes of
+ * .. the code generator, and the SIO output and the status of the runs should
+ * .. be the same as the ones of -O0 in the interpreter; any divergence is
+ * .. reported to stderr with the program, and aborts.
+ * The harness defines LLVMFuzzerTestOneInput(), so it can be linked with
+ * .. libFuzzer: clang -fsanitize=fuzzer -DFUZZ_LIBFUZZER. Otherwise, main()
+ * .. runs the inputs from the given files or stdin, as AFL expects, or the
+ * .. inputs generated from a range of seeds.
+ * */
+
+/**
+ * Limits of the generated programs. The tokens are capped so that the code
+ * .. stays under MAX_CODE_LENGTH instructions at every level, and the
+ * .. nesting so that the expressions fit in the registers.
+ * */
+#define FUZZ_MAX_TOKENS      300
+#define FUZZ_MAX_NAMES       32
+#define FUZZ_MAX_LEVEL       2
+#define FUZZ_MAX_DEPTH       3
+#define FUZZ_LOOP_COUNTERS   2
+#define FUZZ_MAX_RECURSION   4
+#define FUZZ_INPUT_NUMBERS   8
+
+/**
+ * Number of times the input numbers are repeated in the input of the VM. A
+ * .. read past the end of the input leaves a register as it was, which
+ * .. depends on the optimizations, so the programs reading more than the
+ * .. input are skipped.
+ * */
+#define FUZZ_INPUT_REPEAT 8
+
+/**
+ * Instruction budget of the -O0 run. The inputs that do not halt in it are
+ * .. skipped. The optimized code is allowed twice the budget, to tolerate
+ * .. the instructions added before the loops that run zero times.
+ * */
+#define FUZZ_MAX_INSTRUCTIONS 1000000LL
+
+/**
+ * Size of the inputs generated from a seed
+ * */
+#define FUZZ_SEED_INPUT_SIZE 512
+
+/**
+ * The bytes of a fuzzer input, consumed by the generator to make its choices
+ * */
+typedef struct {
+    const uint8_t* data;
+    size_t size;
+    size_t pos;
+} FuzzInput;
+
+/**
+ * The names visible in a block of the generated program. Only vars can be
+ * .. assigned and read to; the loop counters and the recursion counters are
+ * .. read only, so that every loop and recursion terminates. divisors are the
+ * .. constants, which are all positive.
+ * */
+typedef struct {
+    char vars[FUZZ_MAX_NAMES][MAX_LEXEME_LENGTH + 1];
+    int numberOfVars;
+
+    char values[FUZZ_MAX_NAMES][MAX_LEXEME_LENGTH + 1];
+    int numberOfValues;
+
+    char divisors[FUZZ_MAX_NAMES][MAX_LEXEME_LENGTH + 1];
+    int numberOfDivisors;
+
+    char procs[FUZZ_MAX_NAMES][MAX_LEXEME_LENGTH + 1];
+    int numberOfProcs;
+
+    // Loop counters of the block, not visible to the nested procedures
+    char counters[FUZZ_LOOP_COUNTERS][MAX_LEXEME_LENGTH + 1];
+} FuzzScope;
+
+/**
+ * State of the program generator
+ * */
+typedef struct {
+    FuzzInput* in;
+    TokenList* tokens;
+
+    // Number of the names generated, making each of them unique
+    int names;
+} ProgramGen;
+
+/**
+ * The optimization levels the programs are compiled at. The first one is
+ * .. the reference.
+ * */
+typedef struct {
+    const char* name;
+    int optimizations;
+} FuzzLevel;
+
+const FuzzLevel fuzzLevels[] = {
+    { "-O0", CG_OPT_LEVEL_0 },
+    { "-O1", CG_OPT_LEVEL_1 },
+    { "-O2", CG_OPT_LEVEL_2 }
+};
+
+#define FUZZ_LEVEL_COUNT 3
+
+/**
+ * How an engine runs the code: simulateVMWithOptions(), runVMProgram(), see
+ * .. runner.h, or the executable translated by translateCodeToC(), see aot.h
+ * */
+enum { FUZZ_VM, FUZZ_RUNNER, FUZZ_AOT };
+
+/**
+ * The engines the programs are run in. The first one is the reference. The
+ * .. budgets disable the JIT, and the runner and the AOT executables have
+ * .. none, so these engines run only the code that halted in the reference
+ * .. engine.
+ * */
+typedef struct {
+    const char* name;
+    int kind;
+    int format;
+    int jit;
+    int packCode;
+    int profile;
+} FuzzEngine;
+
+const FuzzEngine fuzzEngines[] = {
+    { "interpreter", FUZZ_VM,     CG_OUTPUT_TEXT,   0, 1, 0 },
+    { "unpacked",    FUZZ_VM,     CG_OUTPUT_TEXT,   0, 0, 0 },
+    { "profiled",    FUZZ_VM,     CG_OUTPUT_TEXT,   0, 1, 1 },
+    { "object",      FUZZ_VM,     CG_OUTPUT_OBJECT, 0, 1, 0 },
+    { "jit",         FUZZ_VM,     CG_OUTPUT_TEXT,   1, 1, 0 },
+    { "runner",      FUZZ_RUNNER, CG_OUTPUT_OBJECT, 0, 1, 0 },
+    { "runner jit",  FUZZ_RUNNER, CG_OUTPUT_TEXT,   1, 1, 0 },
+    { "aot",         FUZZ_AOT,    CG_OUTPUT_TEXT,   0, 0, 0 }
+};
+
+#define FUZZ_ENGINE_COUNT 8
+
+/**
+ * The outcome of a run: its status, see vm.h, the SIO output, and the
+ * .. number of SIO reads, -1 if not counted as in the jit engine
+ * */
+typedef struct {
+    int status;
+    char* output;
+    long long reads;
+} FuzzRun;
+
+/**
+ * Numbers of the inputs by how they are handled, reported by main()
+ * */
+typedef struct {
+    int inputs;
+    int rejected; // not compiled, with the same error code at every level
+    int skipped;  // not halted in the instruction budget or the input at -O0
+    int compared; // run and compared in every engine
+} FuzzCounts;
+
+FuzzCounts fuzzCounts;
+
+/**
+ * Returns the next choice among n options, consuming a byte of the input.
+ * Returns 0 once the input is exhausted, so the option 0 should always be
+ * .. the one that ends the program the soonest.
+ * */
+int nextChoice(FuzzInput* in, int n)
+{
+    if(n <= 1 || in->pos >= in->size) return 0;
+
+    return in->data[in->pos++] % n;
+}
+
+/**
+ * Returns 1 if the program has reached FUZZ_MAX_TOKENS, after which only the
+ * .. tokens closing it are generated.
+ * */
+int isProgramFull(ProgramGen* gen)
+{
+    return gen->tokens->numberOfTokens >= FUZZ_MAX_TOKENS;
+}
+
+void addGenToken(ProgramGen* gen, int id, const char* lexeme)
+{
+    Token token;
+    token.id = id;
+
+    if(!lexeme) lexeme = tokenLexemes[id];
+    strncpy(token.lexeme, lexeme, MAX_LEXEME_LENGTH);
+    token.lexeme[MAX_LEXEME_LENGTH] = '\0';
+
+    addToken(gen->tokens, token);
+}
+
+void addNumberToken(ProgramGen* gen, int number)
+{
+    char lexeme[MAX_LEXEME_LENGTH + 1];
+    sprintf(lexeme, "%d", number);
+
+    addGenToken(gen, numbersym, lexeme);
+}
+
+/**
+ * Writes a new unique name with the given prefix to name
+ * */
+void makeName(ProgramGen* gen, char prefix, char* name)
+{
+    sprintf(name, "%c%d", prefix, ++gen->names);
+}
+
+/**
+ * Returns a number, mostly a small one, in the range of the lexer
+ * */
+int nextNumber(ProgramGen* gen)
+{
+    if(nextChoice(gen->in, 4) == 3)
+        return nextChoice(gen->in, 256) * nextChoice(gen->in, 256) + nextChoice(gen->in, 256);
+
+    return nextChoice(gen->in, 16);
+}
+
+void genExpression(ProgramGen* gen, FuzzScope* scope, int depth);
+
+void genFactor(ProgramGen* gen, FuzzScope* scope, int depth)
+{
+    int kind = isProgramFull(gen) || depth >= FUZZ_MAX_DEPTH ? nextChoice(gen->in, 2) : nextChoice(gen->in, 3);
+
+    if(kind == 1 && scope->numberOfValues)
+    {
+        addGenToken(gen, identsym, scope->values[nextChoice(gen->in, scope->numberOfValues)]);
+    }
+    else if(kind == 2)
+    {
+        addGenToken(gen, lparentsym, NULL);
+        genExpression(gen, scope, depth + 1);
+        addGenToken(gen, rparentsym, NULL);
+    }
+    else
+    {
+        addNumberToken(gen, nextNumber(gen));
+    }
+}
+
+/**
+ * Generates a divisor: a positive number or constant, so that the programs
+ * .. never divide by zero
+ * */
+void genDivisor(ProgramGen* gen, FuzzScope* scope)
+{
+    if(nextChoice(gen->in, 3) == 2 && scope->numberOfDivisors)
+        addGenToken(gen, identsym, scope->divisors[nextChoice(gen->in, scope->numberOfDivisors)]);
+    else
+        addNumberToken(gen, 1 + nextChoice(gen->in, 16));
+}
+
+void genTerm(ProgramGen* gen, FuzzScope* scope, int depth)
+{
+    genFactor(gen, scope, depth);
+
+    while(!isProgramFull(gen) && nextChoice(gen->in, 3) == 2)
+    {
+        if(nextChoice(gen->in, 3) == 2)
+        {
+            addGenToken(gen, slashsym, NULL);
+            genDivisor(gen, scope);
+        }
+        else
+        {
+            addGenToken(gen, multsym, NULL);
+            genFactor(gen, scope, depth);
+        }
+    }
+}
+
+void genExpression(ProgramGen* gen, FuzzScope* scope, int depth)
+{
+    if(nextChoice(gen->in, 6) == 5) addGenToken(gen, minussym, NULL);
+
+    genTerm(gen, scope, depth);
+
+    while(!isProgramFull(gen) && nextChoice(gen->in, 3) == 2)
+    {
+        addGenToken(gen, nextChoice(gen->in, 2) ? minussym : plussym, NULL);
+        genTerm(gen, scope, depth);
+    }
+}
+
+void genCondition(ProgramGen* gen, FuzzScope* scope)
+{
+    int relOp = nextChoice(gen->in, 7);
+
+    if(relOp == 6)
+    {
+        addGenToken(gen, oddsym, NULL);
+        genExpression(gen, scope, 0);
+        return;
+    }
+
+    genExpression(gen, scope, 0);
+    addGenToken(gen, eqsym + relOp, NULL);
+    genExpression(gen, scope, 0);
+}
+
+void genStatement(ProgramGen* gen, FuzzScope* scope, int depth, int freeCounter);
+
+/**
+ * Generates a loop on the free counter of the block, counting up or down a
+ * .. few times. Only the loop changes the counter.
+ * */
+void genLoop(ProgramGen* gen, FuzzScope* scope, int depth, int freeCounter)
+{
+    const char* counter = scope->counters[freeCounter];
+    int times = nextChoice(gen->in, 6);
+    int down = nextChoice(gen->in, 2);
+
+    addGenToken(gen, beginsym, NULL);
+    addGenToken(gen, identsym, counter);
+    addGenToken(gen, becomessym, NULL);
+    addNumberToken(gen, down ? times : 0);
+    addGenToken(gen, semicolonsym, NULL);
+
+    addGenToken(gen, whilesym, NULL);
+    if(down)
+    {
+        addGenToken(gen, identsym, counter);
+        addGenToken(gen, gtrsym, NULL);
+        addNumberToken(gen, 0);
+    }
+    else if(nextChoice(gen->in, 2))
+    {
+        addNumberToken(gen, times);
+        addGenToken(gen, gtrsym, NULL);
+        addGenToken(gen, identsym, counter);
+    }
+    else
+    {
+        addGenToken(gen, identsym, counter);
+        addGenToken(gen, lessym, NULL);
+        addNumberToken(gen, times);
+    }
+    addGenToken(gen, dosym, NULL);
+
+    addGenToken(gen, beginsym, NULL);
+    genStatement(gen, scope, depth + 1, freeCounter + 1);
+    addGenToken(gen, semicolonsym, NULL);
+    addGenToken(gen, identsym, counter);
+    addGenToken(gen, becomessym, NULL);
+    addGenToken(gen, identsym, counter);
+    addGenToken(gen, down ? minussym : plussym, NULL);
+    addNumberToken(gen, 1);
+    addGenToken(gen, endsym, NULL);
+
+    addGenToken(gen, endsym, NULL);
+}
+
+/**
+ * Generates a statement. freeCounter is the first loop counter of the block
+ * .. not used by the enclosing loops.
+ * */
+void genStatement(ProgramGen* gen, FuzzScope* scope, int depth, int freeCounter)
+{
+    int kind = isProgramFull(gen) || depth >= FUZZ_MAX_DEPTH ? 0 : nextChoice(gen->in, 8);
+
+    if(kind == 1)
+    {
+        addGenToken(gen, writesym, NULL);
+        addGenToken(gen, identsym, scope->values[nextChoice(gen->in, scope->numberOfValues)]);
+    }
+    else if((kind == 2 || kind == 7) && scope->numberOfProcs)
+    {
+        addGenToken(gen, callsym, NULL);
+        addGenToken(gen, identsym, scope->procs[nextChoice(gen->in, scope->numberOfProcs)]);
+    }
+    else if(kind == 3)
+    {
+        addGenToken(gen, ifsym, NULL);
+        genCondition(gen, scope);
+        addGenToken(gen, thensym, NULL);
+        genStatement(gen, scope, depth + 1, freeCounter);
+
+        if(nextChoice(gen->in, 2))
+        {
+            addGenToken(gen, elsesym, NULL);
+            genStatement(gen, scope, depth + 1, freeCounter);
+        }
+    }
+    else if(kind == 4 && freeCounter < FUZZ_LOOP_COUNTERS)
+    {
+        genLoop(gen, scope, depth, freeCounter);
+    }
+    else if(kind == 5)
+    {
+        addGenToken(gen, beginsym, NULL);
+        genStatement(gen, scope, depth + 1, freeCounter);
+
+        while(!isProgramFull(gen) && nextChoice(gen->in, 3))
+        {
+            addGenToken(gen, semicolonsym, NULL);
+            genStatement(gen, scope, depth + 1, freeCounter);
+        }
+
+        addGenToken(gen, endsym, NULL);
+    }
+    else if(kind == 6)
+    {
+        addGenToken(gen, readsym, NULL);
+        addGenToken(gen, identsym, scope->vars[nextChoice(gen->in, scope->numberOfVars)]);
+    }
+    else
+    {
+        addGenToken(gen, identsym, scope->vars[nextChoice(gen->in, scope->numberOfVars)]);
+        addGenToken(gen, becomessym, NULL);
+        genExpression(gen, scope, 0);
+    }
+}
+
+/**
+ * Generates a block at the given nesting level, seeing the names of the
+ * .. given scope. The procedures declared in it can call the procedures
+ * .. declared before them, and the recursive ones themselves as well.
+ * The statements of a recursive procedure run only while guard, the
+ * .. recursion counter of the enclosing block, is positive, and decrement it
+ * .. first, so that they run at most FUZZ_MAX_RECURSION times for each
+ * .. activation of the enclosing block, which bounds the depth of the
+ * .. recursion. guard is NULL for the other blocks.
+ * Every variable is initialized at the start of the block, as the values
+ * .. left on the stack depend on the optimizations.
+ * */
+void genBlock(ProgramGen* gen, FuzzScope scope, int level, const char* guard)
+{
+    int numberOfConsts = isProgramFull(gen) ? 0 : nextChoice(gen->in, 3);
+
+    if(numberOfConsts)
+    {
+        addGenToken(gen, constsym, NULL);
+
+        for(int i = 0; i < numberOfConsts; i++)
+        {
+            char* name = scope.divisors[scope.numberOfDivisors++];
+            makeName(gen, 'k', name);
+            strcpy(scope.values[scope.numberOfValues++], name);
+
+            if(i) addGenToken(gen, commasym, NULL);
+            addGenToken(gen, identsym, name);
+            addGenToken(gen, eqsym, NULL);
+            addNumberToken(gen, 1 + nextNumber(gen));
+        }
+
+        addGenToken(gen, semicolonsym, NULL);
+    }
+
+    // The variables of the block, followed by its loop counters, and its
+    // .. recursion counter if it can declare procedures
+    int firstVar = scope.numberOfVars;
+    int numberOfVars = 1 + (isProgramFull(gen) ? 0 : nextChoice(gen->in, 2));
+    char recursion[MAX_LEXEME_LENGTH + 1] = "";
+
+    addGenToken(gen, varsym, NULL);
+
+    for(int i = 0; i < numberOfVars + FUZZ_LOOP_COUNTERS; i++)
+    {
+        char* name = i < numberOfVars ? scope.vars[scope.numberOfVars++] : scope.counters[i - numberOfVars];
+        makeName(gen, i < numberOfVars ? 'v' : 'c', name);
+        strcpy(scope.values[scope.numberOfValues++], name);
+
+        if(i) addGenToken(gen, commasym, NULL);
+        addGenToken(gen, identsym, name);
+    }
+
+    if(level < FUZZ_MAX_LEVEL)
+    {
+        makeName(gen, 'd', recursion);
+        strcpy(scope.values[scope.numberOfValues++], recursion);
+
+        addGenToken(gen, commasym, NULL);
+        addGenToken(gen, identsym, recursion);
+    }
+
+    addGenToken(gen, semicolonsym, NULL);
+
+    int numberOfProcs = level < FUZZ_MAX_LEVEL && !isProgramFull(gen) ? nextChoice(gen->in, 3) : 0;
+
+    for(int i = 0; i < numberOfProcs; i++)
+    {
+        char name[MAX_LEXEME_LENGTH + 1];
+        makeName(gen, 'p', name);
+        int recursive = nextChoice(gen->in, 2);
+
+        // A recursive procedure sees itself
+        if(recursive) strcpy(scope.procs[scope.numberOfProcs++], name);
+
+        addGenToken(gen, procsym, NULL);
+        addGenToken(gen, identsym, name);
+        addGenToken(gen, semicolonsym, NULL);
+        genBlock(gen, scope, level + 1, recursive ? recursion : NULL);
+        addGenToken(gen, semicolonsym, NULL);
+
+        if(!recursive) strcpy(scope.procs[scope.numberOfProcs++], name);
+    }
+
+    addGenToken(gen, beginsym, NULL);
+
+    for(int i = 0; i < numberOfVars + FUZZ_LOOP_COUNTERS; i++)
+    {
+        addGenToken(gen, identsym, i < numberOfVars ? scope.vars[firstVar + i] : scope.counters[i - numberOfVars]);
+        addGenToken(gen, becomessym, NULL);
+        addNumberToken(gen, nextNumber(gen));
+        addGenToken(gen, semicolonsym, NULL);
+    }
+
+    if(recursion[0])
+    {
+        addGenToken(gen, identsym, recursion);
+        addGenToken(gen, becomessym, NULL);
+        addNumberToken(gen, nextChoice(gen->in, FUZZ_MAX_RECURSION + 1));
+        addGenToken(gen, semicolonsym, NULL);
+    }
+
+    // if guard > 0 then begin guard := guard - 1; statements end
+    if(guard)
+    {
+        addGenToken(gen, ifsym, NULL);
+        addGenToken(gen, identsym, guard);
+        addGenToken(gen, gtrsym, NULL);
+        addNumberToken(gen, 0);
+        addGenToken(gen, thensym, NULL);
+        addGenToken(gen, beginsym, NULL);
+        addGenToken(gen, identsym, guard);
+        addGenToken(gen, becomessym, NULL);
+        addGenToken(gen, identsym, guard);
+        addGenToken(gen, minussym, NULL);
+        addNumberToken(gen, 1);
+        addGenToken(gen, semicolonsym, NULL);
+    }
+
+    genStatement(gen, &scope, 0, 0);
+
+    while(!isProgramFull(gen) && nextChoice(gen->in, 4))
+    {
+        addGenToken(gen, semicolonsym, NULL);
+        genStatement(gen, &scope, 0, 0);
+    }
+
+    if(guard) addGenToken(gen, endsym, NULL);
+
+    // The main block writes the variables, so that their values are compared
+    for(int i = 0; level == 0 && i < scope.numberOfVars; i++)
+    {
+        addGenToken(gen, semicolonsym, NULL);
+        addGenToken(gen, writesym, NULL);
+        addGenToken(gen, identsym, scope.vars[i]);
+    }
+
+    addGenToken(gen, endsym, NULL);
+}
+
+/**
+ * Generates the program of the input to tokens.
+ * Returns 1 if a token of the program is replaced with a random one, to
+ * .. compare the error codes of the code generator, 0 otherwise.
+ * */
+int genProgram(FuzzInput* in, TokenList* tokens)
+{
+    ProgramGen gen = { in, tokens, 0 };
+
+    FuzzScope scope;
+    memset(&scope, 0, sizeof(scope));
+
+    genBlock(&gen, scope, 0, NULL);
+    addGenToken(&gen, periodsym, NULL);
+
+    if(nextChoice(in, 4) != 3) return 0;
+
+    Token* token = &tokens->tokens[nextChoice(in, tokens->numberOfTokens)];
+    token->id = nulsym + nextChoice(in, elsesym);
+
+    if(token->id == identsym)       strcpy(token->lexeme, "v1");
+    else if(token->id == numbersym) strcpy(token->lexeme, "7");
+    else                            strcpy(token->lexeme, tokenLexemes[token->id]);
+
+    return 1;
+}
+
+/**
+ * Prints the program in the tokens as PL/0 source code
+ * */
+void printProgram(TokenList* tokens, FILE* out)
+{
+    for(int i = 0; i < tokens->numberOfTokens; i++)
+    {
+        Token token = tokens->tokens[i];
+        fprintf(out, "%s%s", token.lexeme, token.id == semicolonsym ? "\n" : " ");
+    }
+
+    fprintf(out, "\n");
+}
+
+/**
+ * Reads the contents of the file from its start to a null terminated string
+ * */
+char* readWholeFile(FILE* file)
+{
+    fflush(file);
+    long size = ftell(file);
+    char* contents = (char*)malloc(size + 1);
+
+    rewind(file);
+    contents[fread(contents, 1, size, file)] = '\0';
+
+    return contents;
+}
+
+/**
+ * Compiles the tokens at the level to the given format in a temporary file.
+ * Returns the file, and sets err to the error code of the code generator.
+ * */
+FILE* compileProgram(TokenList tokens, const FuzzLevel* level, int format, int* err)
+{
+    FILE* code = tmpfile();
+
+    setCGOptimizations(level->optimizations);
+    setCGOutputFormat(format);
+    *err = codeGenerator(tokens, code);
+    setCGOutputFormat(CG_OUTPUT_TEXT);
+
+    fflush(code);
+    return code;
+}
+
+/**
+ * Runs the code in the runner, see fuzz_runner.h
+ * */
+FuzzRun runRunnerProgram(FILE* code, const FuzzEngine* engine, FILE* vmInput)
+{
+    FILE* vmOutput = tmpfile();
+
+    rewind(code);
+    rewind(vmInput);
+
+    FuzzRun run;
+    run.status = runFuzzRunner(code, engine->jit, vmInput, vmOutput);
+    run.reads = -1;
+    run.output = readWholeFile(vmOutput);
+    fclose(vmOutput);
+
+    return run;
+}
+
+/**
+ * Translates the code to C, compiles it as aot.out does, and runs the
+ * .. executable on the input in a temporary directory. A code that cannot be
+ * .. translated, compiled or run gets the status VM_INVALID_CODE.
+ * */
+FuzzRun runAOTProgram(FILE* code, const char* input)
+{
+    Instruction instructions[MAX_CODE_LENGTH];
+
+    rewind(code);
+    int codeLength = readCode(code, instructions, MAX_CODE_LENGTH);
+
+    FuzzRun run;
+    run.status = VM_INVALID_CODE;
+    run.output = NULL;
+    run.reads = -1;
+
+    char dir[] = "/tmp/fuzz_aot_XXXXXX";
+    if(!mkdtemp(dir))
+    {
+        run.output = strdup("");
+        return run;
+    }
+
+    char cPath[64], exePath[64], inputPath[64], outputPath[64];
+    snprintf(cPath, sizeof(cPath), "%s/aot.c", dir);
+    snprintf(exePath, sizeof(exePath), "%s/aot.exe", dir);
+    snprintf(inputPath, sizeof(inputPath), "%s/input.txt", dir);
+    snprintf(outputPath, sizeof(outputPath), "%s/output.txt", dir);
+
+    FILE* c = fopen(cPath, "w");
+    FILE* in = fopen(inputPath, "w");
+    int translated = c && in && !translateCodeToC(instructions, codeLength, c);
+
+    for(int i = 0; in && i < FUZZ_INPUT_REPEAT; i++) fputs(input, in);
+
+    if(c) fclose(c);
+    if(in) fclose(in);
+
+    char command[512];
+    snprintf(command, sizeof(command), "cc -O2 -o \"%s\" \"%s\" && \"%s\" < \"%s\" > \"%s\"",
+        exePath, cPath, exePath, inputPath, outputPath);
+
+    if(translated && !system(command)) run.status = VM_HALTED;
+
+    FILE* out = fopen(outputPath, "r");
+    if(out)
+    {
+        fseek(out, 0, SEEK_END);
+        run.output = readWholeFile(out);
+        fclose(out);
+    }
+    else
+    {
+        run.output = strdup("");
+    }
+
+    remove(cPath);
+    remove(exePath);
+    remove(inputPath);
+    remove(outputPath);
+    rmdir(dir);
+
+    return run;
+}
+
+/**
+ * Runs the code in the engine, with the given input and instruction budget
+ * */
+FuzzRun runProgram(FILE* code, const FuzzEngine* engine, FILE* vmInput, const char* input, long long maxInstructions)
+{
+    if(engine->kind == FUZZ_RUNNER) return runRunnerProgram(code, engine, vmInput);
+    if(engine->kind == FUZZ_AOT)    return runAOTProgram(code, input);
+
+    FILE* null = fopen("/dev/null", "w");
+    FILE* vmOutput = tmpfile();
+
+    VMOptions options;
+    initVMOptions(&options);
+    options.jit = engine->jit;
+    options.packCode = engine->packCode;
+    options.profileReport = engine->profile ? null : NULL;
+    options.maxInstructions = engine->jit ? 0 : maxInstructions;
+
+    // The SIO reads are counted by the interpreter only
+    Stats stats;
+    initStats(&stats, "");
+    options.stats = engine->jit ? NULL : &stats;
+
+    rewind(code);
+    rewind(vmInput);
+
+    FuzzRun run;
+    run.status = simulateVMWithOptions(code, null, vmInput, vmOutput, &options);
+    run.output = readWholeFile(vmOutput);
+    run.reads = -1;
+
+    for(int i = 0; options.stats && i < stats.numberOfStats; i++)
+        if(!strcmp(stats.stats[i].name, "vm_sio_reads_total")) run.reads = stats.stats[i].value;
+
+    deleteStats(&stats);
+
+    fclose(vmOutput);
+    fclose(null);
+
+    return run;
+}
+
+/**
+ * Reports a divergence from the reference with the program and its input,
+ * .. and aborts
+ * */
+void reportDivergence(TokenList* tokens, const char* input, const char* what, const char* expected, const char* actual)
+{
+    fprintf(stderr, "Divergence in %s: expected %s, got %s\nInput, repeated %d times: %s\nProgram:\n", what, expected, actual, FUZZ_INPUT_REPEAT, input);
+    printProgram(tokens, stderr);
+    fflush(stderr);
+
+    abort();
+}
+
+/**
+ * Checks the run of the code of level in engine against the reference run
+ */
+void checkRun(TokenList* tokens, const char* input, const FuzzLevel* level, const FuzzEngine* engine, FuzzRun* reference, FuzzRun* run)
+{
+    if(run->status == reference->status && !strcmp(run->output, reference->output)) return;
+
+    char what[64], expected[512], actual[512];
+    snprintf(what, sizeof(what), "%s %s", level->name, engine->name);
+    snprintf(expected, sizeof(expected), "status %d, output \"%.400s\"", reference->status, reference->output);
+    snprintf(actual, sizeof(actual), "status %d, output \"%.400s\"", run->status, run->output);
+
+    reportDivergence(tokens, input, what, expected, actual);
+}
+
+int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size)
+{
+    FuzzInput in = { data, size, 0 };
+
+    TokenList tokens;
+    initTokenList(&tokens);
+    int mutated = genProgram(&in, &tokens);
+
+    char input[FUZZ_INPUT_NUMBERS * 5 + 1] = "";
+    for(int i = 0; i < FUZZ_INPUT_NUMBERS; i++)
+        sprintf(input + strlen(input), "%d ", nextChoice(&in, 256) - 128);
+
+    FILE* vmInput = tmpfile();
+    for(int i = 0; i < FUZZ_INPUT_REPEAT; i++) fputs(input, vmInput);
+    fflush(vmInput);
+
+    fuzzCounts.inputs++;
+
+    // The code of each level in each format
+    FILE* code[FUZZ_LEVEL_COUNT][2];
+    int err[FUZZ_LEVEL_COUNT][2];
+
+    for(int l = 0; l < FUZZ_LEVEL_COUNT; l++)
+    {
+        for(int format = CG_OUTPUT_TEXT; format <= CG_OUTPUT_OBJECT; format++)
+        {
+            code[l][format] = compileProgram(tokens, &fuzzLevels[l], format, &err[l][format]);
+
+            if(err[l][format] != err[0][CG_OUTPUT_TEXT])
+            {
+                char what[64], expected[32], actual[32];
+                snprintf(what, sizeof(what), "the error code at %s%s", fuzzLevels[l].name, format == CG_OUTPUT_OBJECT ? " to an object" : "");
+                snprintf(expected, sizeof(expected), "%d", err[0][CG_OUTPUT_TEXT]);
+                snprintf(actual, sizeof(actual), "%d", err[l][format]);
+
+                reportDivergence(&tokens, input, what, expected, actual);
+            }
+        }
+    }
+
+    // The programs with a random token may not terminate, or divide by zero
+    if(err[0][CG_OUTPUT_TEXT] || mutated)
+    {
+        if(err[0][CG_OUTPUT_TEXT]) fuzzCounts.rejected++;
+    }
+    else
+    {
+        FuzzRun reference = runProgram(code[0][CG_OUTPUT_TEXT], &fuzzEngines[0], vmInput, input, FUZZ_MAX_INSTRUCTIONS);
+
+        if(reference.status != VM_HALTED || reference.reads > FUZZ_INPUT_NUMBERS * FUZZ_INPUT_REPEAT)
+        {
+            fuzzCounts.skipped++;
+        }
+        else
+        {
+            fuzzCounts.compared++;
+
+            for(int l = 0; l < FUZZ_LEVEL_COUNT; l++)
+            {
+                for(int e = 0; e < FUZZ_ENGINE_COUNT; e++)
+                {
+                    if(l == 0 && e == 0) continue;
+
+                    const FuzzEngine* engine = &fuzzEngines[e];
+                    FuzzRun run = runProgram(code[l][engine->format], engine, vmInput, input, 2 * FUZZ_MAX_INSTRUCTIONS);
+
+                    checkRun(&tokens, input, &fuzzLevels[l], engine, &reference, &run);
+                    free(run.output);
+                }
+            }
+        }
+
+        free(reference.output);
+    }
+
+    for(int l = 0; l < FUZZ_LEVEL_COUNT; l++)
+    {
+        fclose(code[l][CG_OUTPUT_TEXT]);
+        fclose(code[l][CG_OUTPUT_OBJECT]);
+    }
+
+    fclose(vmInput);
+    deleteTokenList(&tokens);
+
+    return 0;
+}
+
+#ifndef FUZZ_LIBFUZZER
+
+/**
+ * Runs the input in the file at path, or in stdin if path is NULL.
+ * Returns 0 on success, -1 if the file cannot be read.
+ * */
+int fuzzFile(const char* path)
+{
+    FILE* file = path ? fopen(path, "rb") : stdin;
+
+    if(!file)
+    {
+        fprintf(stderr, "Could not open %s\n", path);
+        return -1;
+    }
+
+    size_t size = 0, capacity = 4096;
+    uint8_t* data = (uint8_t*)malloc(capacity);
+
+    for(size_t n; (n = fread(data + size, 1, capacity - size, file)) > 0; )
+    {
+        size += n;
+
+        if(size == capacity)
+        {
+            capacity *= 2;
+            data = (uint8_t*)realloc(data, capacity);
+        }
+    }
+
+    if(path) fclose(file);
+
+    LLVMFuzzerTestOneInput(data, size);
+    free(data);
+
+    return 0;
+}
+
+/**
+ * Runs the input generated from the seed, by xorshift
+ * */
+void fuzzSeed(unsigned long long seed)
+{
+    uint8_t data[FUZZ_SEED_INPUT_SIZE];
+    unsigned long long x = seed * 0x9E3779B97F4A7C15ULL + 1;
+
+    for(int i = 0; i < FUZZ_SEED_INPUT_SIZE; i++)
+    {
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        data[i] = (uint8_t)(x >> 32);
+    }
+
+    LLVMFuzzerTestOneInput(data, FUZZ_SEED_INPUT_SIZE);
+}
+
+int main(int argc, char **argv)
+{
+    int ret = 0;
+
+    if(argc == 4 && !strcmp(argv[1], "-s"))
+    {
+        unsigned long long first = strtoull(argv[2], NULL, 10), last = strtoull(argv[3], NULL, 10);
+        for(unsigned long long seed = first; seed <= last; seed++) fuzzSeed(seed);
+    }
+    else if(argc > 1 && argv[1][0] == '-')
+    {
+        fprintf(stderr, "Usage: fuzz.out [-s first_seed last_seed | input_files...]\n");
+
+        fprintf(stderr, "\n       Generates a PL/0 program from each input, compiles it at -O0, -O1 and -O2,\n");
+        fprintf(stderr, "       and runs it in the interpreter, unpacked, profiled, from an object file, with\n");
+        fprintf(stderr, "       the JIT, in the runner with and without the JIT, and compiled ahead of time\n");
+        fprintf(stderr, "       to C. Reports the first divergence from -O0 in the interpreter, in\n");
+        fprintf(stderr, "       the error codes of the code generator or in the SIO output and the status of\n");
+        fprintf(stderr, "       the runs, to stderr and aborts.\n");
+        fprintf(stderr, "\n       -s: Generate the inputs from the seeds from first_seed to last_seed.\n");
+        fprintf(stderr, "\n       input_files: The inputs, stdin if none is given, as AFL runs it.\n");
+        return -1;
+    }
+    else if(argc == 1)
+    {
+        ret = fuzzFile(NULL);
+    }
+    else
+    {
+        for(int i = 1; i < argc; i++)
+            if(fuzzFile(argv[i])) ret = -1;
+    }
+
+    fprintf(stderr, "%d inputs: %d compared, %d rejected by the code generator, %d over the instruction budget or the input\n",
+        fuzzCounts.inputs, fuzzCounts.compared, fuzzCounts.rejected, fuzzCounts.skipped);
+
+    return ret;
+}
+
+#endif
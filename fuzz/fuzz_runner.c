@@ -0,0 +1,20 @@
+#include <stdlib.h>
+#include "fuzz_runner.h"
+#include "../vm/runner.h"
+#include "../vm/vm.h"
+
+int runFuzzRunner(FILE* code, int jit, FILE* vm_inp, FILE* vm_outp)
+{
+    // Too large for the stack
+    VMProgram* program = (VMProgram*)malloc(sizeof(VMProgram));
+    int status = VM_INVALID_OBJECT;
+
+    long long executed;
+    if(!loadVMProgram(program, code, jit))
+        status = runVMProgram(program, vm_inp, vm_outp, 1, 0, 0, &executed);
+
+    deleteVMProgram(program);
+    free(program);
+
+    return status;
+}
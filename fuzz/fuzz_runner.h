@@ -0,0 +1,14 @@
+#ifndef __FUZZ_RUNNER_H__
+#define __FUZZ_RUNNER_H__
+
+#include <stdio.h>
+
+/**
+ * Runs the code with runVMProgram(), see vm/runner.h, which is kept out of
+ * .. fuzz_main.c, as it needs the data.h of the virtual machine.
+ * Returns the status of the run, see vm/vm.h, and VM_INVALID_OBJECT if the
+ * .. code cannot be loaded.
+ * */
+int runFuzzRunner(FILE* code, int jit, FILE* vm_inp, FILE* vm_outp);
+
+#endif
@@ -0,0 +1,230 @@
+#include <stdlib.h>
+#include <string.h>
+#include "inliner.h"
+
+/**
+ * A procedure as seen by the inliner: the number of its variables, and its
+ * .. body [bodyStart, bodyEnd), where bodyEnd is the address of its RTN.
+ * bodyStart is -1 if the procedure cannot be inlined.
+ * */
+typedef struct {
+    int numberOfVars;
+    int bodyStart;
+    int bodyEnd;
+} InlineCandidate;
+
+/**
+ * Returns the size of the frame of the block starting at start: the sum of
+ * .. the INC instructions it starts with. Returns the address after them to
+ * .. end, if it is not NULL.
+ * */
+int getFrameSize(Instruction* code, int numOfIns, int start, int* end)
+{
+    int size = 0, i = start;
+
+    for(; i < numOfIns && code[i].op == INC; i++)
+        size += code[i].m;
+
+    if(end) *end = i;
+    return size;
+}
+
+/**
+ * Fills the candidate for the given procedure
+ * */
+void findInlineCandidate(InlineCandidate* candidate, CallGraphProc* proc, Instruction* code, int numOfIns)
+{
+    candidate->bodyStart = -1;
+
+    if(proc->start < 0 || proc->end > numOfIns || proc->end - proc->start < 3) return;
+
+    int jmp;
+    int frameSize = getFrameSize(code, numOfIns, proc->start, &jmp);
+
+    int bodyStart = code[jmp].m, bodyEnd = proc->end - 1;
+
+    if(frameSize < AR_VARIABLE_OFFSET || jmp >= bodyEnd || code[jmp].op != JMP || code[bodyEnd].op != RTN) return;
+    if(bodyStart <= jmp || bodyStart > bodyEnd || bodyEnd - bodyStart > INLINE_MAX_BODY_LENGTH) return;
+
+    // A leaf whose jumps stay in the body
+    for(int i = bodyStart; i < bodyEnd; i++)
+    {
+        Instruction ins = code[i];
+
+        if(ins.op == CAL || ins.op == RTN) return;
+
+        if(isJumpOp(ins.op) && (ins.m < bodyStart || ins.m > bodyEnd)) return;
+    }
+
+    candidate->numberOfVars = frameSize - AR_VARIABLE_OFFSET;
+    candidate->bodyStart = bodyStart;
+    candidate->bodyEnd = bodyEnd;
+}
+
+/**
+ * Returns the length of the code replacing a call to the candidate
+ * */
+int getInlinedLength(InlineCandidate* candidate)
+{
+    return candidate->bodyEnd - candidate->bodyStart + (candidate->numberOfVars ? 2 : 0);
+}
+
+/**
+ * Runs a single round of inlining, writing the new code to newCode and
+ * .. newLines. Returns the new number of instructions, or -1 if nothing is
+ * .. inlined.
+ * */
+int inlineRound(CallGraph* graph, Instruction* code, int* lines, int numOfIns, int maxNumOfIns,
+    Instruction* newCode, int* newLines, int* inlinedCalls)
+{
+    InlineCandidate* candidates = (InlineCandidate*)malloc((graph->numberOfProcs + 1) * sizeof(InlineCandidate));
+    for(int p = 0; p < graph->numberOfProcs; p++)
+        findInlineCandidate(&candidates[p], &graph->procs[p], code, numOfIns);
+
+    // The procedure called by each instruction to be inlined, -1 for the
+    // .. others. Calls are inlined in order, as long as the code fits.
+    int* inlined = (int*)malloc(numOfIns * sizeof(int));
+    int length = numOfIns, count = 0;
+
+    for(int i = 0; i < numOfIns; i++)
+    {
+        inlined[i] = -1;
+        if(code[i].op != CAL) continue;
+
+        for(int p = 0; p < graph->numberOfProcs; p++)
+        {
+            InlineCandidate* candidate = &candidates[p];
+
+            if(graph->procs[p].start != code[i].m || candidate->bodyStart < 0) continue;
+
+            // Not inlined into itself
+            if(graph->procs[p].start <= i && i < graph->procs[p].end) break;
+
+            if(length - 1 + getInlinedLength(candidate) <= maxNumOfIns)
+            {
+                length += getInlinedLength(candidate) - 1;
+                inlined[i] = p;
+                count++;
+            }
+            break;
+        }
+    }
+
+    if(!count)
+    {
+        free(inlined);
+        free(candidates);
+        return -1;
+    }
+
+    // The new address of each instruction, where the code replacing it
+    // .. starts for the inlined calls
+    int* newIndex = (int*)malloc((numOfIns + 1) * sizeof(int));
+    for(int i = 0, n = 0; i <= numOfIns; i++)
+    {
+        newIndex[i] = n;
+        if(i < numOfIns) n += inlined[i] < 0 ? 1 : getInlinedLength(&candidates[inlined[i]]);
+    }
+
+    for(int i = 0; i < numOfIns; i++)
+    {
+        int n = newIndex[i];
+
+        if(inlined[i] < 0)
+        {
+            Instruction ins = code[i];
+
+            if((isJumpOp(ins.op) || ins.op == CAL) && ins.m >= 0 && ins.m <= numOfIns)
+                ins.m = newIndex[ins.m];
+
+            newCode[n] = ins;
+            if(lines) newLines[n] = lines[i];
+            continue;
+        }
+
+        // The body runs in the frame of the caller, with the variables of the
+        // .. procedure placed above the variables of the caller
+        InlineCandidate* candidate = &candidates[inlined[i]];
+        int caller = findCallGraphProc(graph, i);
+        int callerFrameSize = getFrameSize(code, numOfIns, caller < 0 ? 0 : graph->procs[caller].start, NULL);
+        int levels = code[i].l;
+
+        if(candidate->numberOfVars)
+        {
+            newCode[n] = (Instruction){ .op = INC, .r = 0, .l = 0, .m = candidate->numberOfVars };
+            if(lines) newLines[n] = lines[i];
+            n++;
+        }
+
+        int bodyAddress = n;
+
+        for(int j = candidate->bodyStart; j < candidate->bodyEnd; j++, n++)
+        {
+            Instruction ins = code[j];
+
+            if(ins.op == LOD || ins.op == STO)
+            {
+                // The frame of the procedure is now the one of the caller, and
+                // .. its static link is levels up from the caller
+                if(ins.l == 0) ins.m += callerFrameSize - AR_VARIABLE_OFFSET;
+                else           ins.l += levels - 1;
+            }
+            else if(isJumpOp(ins.op))
+            {
+                // Jumping to the RTN is jumping to the end of the body
+                ins.m = bodyAddress + ins.m - candidate->bodyStart;
+            }
+
+            newCode[n] = ins;
+            if(lines) newLines[n] = lines[j];
+        }
+
+        if(candidate->numberOfVars)
+        {
+            newCode[n] = (Instruction){ .op = INC, .r = 0, .l = 0, .m = -candidate->numberOfVars };
+            if(lines) newLines[n] = lines[i];
+        }
+    }
+
+    for(int p = 0; p < graph->numberOfProcs; p++)
+    {
+        CallGraphProc* proc = &graph->procs[p];
+
+        if(proc->start < 0) continue;
+
+        proc->start = newIndex[proc->start];
+        proc->end = newIndex[proc->end];
+    }
+
+    if(inlinedCalls) *inlinedCalls += count;
+
+    free(newIndex);
+    free(inlined);
+    free(candidates);
+
+    return length;
+}
+
+int inlineLeafProcs(CallGraph* graph, Instruction* code, int* lines, int numOfIns, int maxNumOfIns, int* inlinedCalls)
+{
+    Instruction* newCode = (Instruction*)malloc(maxNumOfIns * sizeof(Instruction));
+    int* newLines = (int*)malloc(maxNumOfIns * sizeof(int));
+
+    if(inlinedCalls) *inlinedCalls = 0;
+
+    for(int round = 0; round < INLINE_MAX_ROUNDS; round++)
+    {
+        int length = inlineRound(graph, code, lines, numOfIns, maxNumOfIns, newCode, newLines, inlinedCalls);
+        if(length < 0) break;
+
+        memcpy(code, newCode, length * sizeof(Instruction));
+        if(lines) memcpy(lines, newLines, length * sizeof(int));
+
+        numOfIns = length;
+    }
+
+    free(newLines);
+    free(newCode);
+
+    return numOfIns;
+}
@@ -0,0 +1,36 @@
+#ifndef __INLINER_H__
+#define __INLINER_H__
+
+#include "data.h"
+#include "call_graph.h"
+
+/**
+ * Maximum length of the body of a procedure to be inlined, in instructions.
+ * */
+#define INLINE_MAX_BODY_LENGTH 16
+
+/**
+ * Maximum number of times the calls are inlined over the whole code. A
+ * .. procedure whose calls are all inlined becomes a leaf, whose calls can
+ * .. be inlined in the next round.
+ * */
+#define INLINE_MAX_ROUNDS 4
+
+/**
+ * Replaces the calls to the small leaf procedures of the call graph with
+ * .. their bodies. A procedure is inlined if its body, the code between the
+ * .. JMP of its block and its RTN, has no CAL and is at most
+ * .. INLINE_MAX_BODY_LENGTH instructions long.
+ * The variables of the procedure are placed above the frame of the caller,
+ * .. with an INC before the body and a negative INC after it. The L fields
+ * .. of the LOD and STO instructions are adjusted to the level of the call,
+ * .. and the addresses of the jumps and the CAL instructions and the ranges
+ * .. of the procedures are renumbered. The procedures themselves are kept,
+ * .. see eliminateDeadProcs() to remove the ones no longer called.
+ * The code grows up to maxNumOfIns instructions, and lines can be NULL.
+ * Returns the new number of instructions, and the number of calls inlined
+ * .. to inlinedCalls if it is not NULL.
+ * */
+int inlineLeafProcs(CallGraph*, Instruction* code, int* lines, int numOfIns, int maxNumOfIns, int* inlinedCalls);
+
+#endif
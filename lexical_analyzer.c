@@ -26,6 +26,8 @@ typedef enum {
 typedef struct {
     int lineNum;         // the line number currently being processed
     int charInd;         // the index of the character currently being processed
+    int lineStartInd;    // the index of the first character of the current line
+    int tokenStartInd;   // the index of the first character of the current token
     char* sourceCode;    // null-terminated source code string
     LexErr lexerError;   // LexErr to be filled when Lexer faces an error
     TokenList tokenList; // list of tokens
@@ -42,6 +44,13 @@ typedef struct {
  * */
 void initLexerState(LexerState*, char* sourceCode);
 
+/**
+ * Adds the given token to the token list of the LexerState, together with its
+ * .. position, which is computed from the line number and the tokenStartInd
+ * .. fields of the LexerState.
+ * */
+void addLexedToken(LexerState*, Token);
+
 /**
  * Returns 1 if the given character is valid.
  * Returns 0 otherwise.
@@ -109,14 +118,31 @@ void DFA_Special(LexerState*);
 /* Definitions ************************************************************** */
 /* ************************************************************************** */
 
+/**
+ * Arena set by setLexerArena(), NULL if not set.
+ * */
+Arena* _lexer_arena;
+
 void initLexerState(LexerState* lexerState, char* sourceCode)
 {
     lexerState->lineNum = 0;
     lexerState->charInd = 0;
+    lexerState->lineStartInd = 0;
+    lexerState->tokenStartInd = 0;
     lexerState->sourceCode = sourceCode;
     lexerState->lexerError = NONE;
 
-    initTokenList(&lexerState->tokenList);
+    initTokenListInArena(&lexerState->tokenList, _lexer_arena);
+}
+
+void addLexedToken(LexerState* lexerState, Token token)
+{
+    // Line and column numbers start from 1
+    TokenPos pos;
+    pos.line = lexerState->lineNum + 1;
+    pos.column = lexerState->tokenStartInd - lexerState->lineStartInd + 1;
+
+    addTokenWithPos(&lexerState->tokenList, token, pos);
 }
 
 int isCharacterValid(char c)
@@ -142,9 +168,13 @@ SymbolType getSymbolType(char c)
 
 int checkReservedTokens(char* symbol)
 {
-    for(int i = firstReservedToken; i <= lastReservedToken; i++)
+    // 'odd' is numbered among the special symbols
+    if( !strcmp(symbol, tokenLexemes[oddsym]) )
+        return oddsym;
+
+    for(int i = beginsym; i <= elsesym; i++)
     {
-        if( !strcmp(symbol, tokens[i]) )
+        if( !strcmp(symbol, tokenLexemes[i]) )
         {
             // Symbol is the reserved token at index i.
             return i;
@@ -157,10 +187,10 @@ int checkReservedTokens(char* symbol)
 
 int checkSpecialToken(char * symbol)
 {
-    for (int i = 4; i < 20; i++)
+    for (int i = plussym; i <= becomessym; i++)
     {
-        if (i == 12) continue; //this is "odd", not a special sym
-        if (!strcmp(symbol, tokens[i]))
+        if (i == oddsym) continue; //this is "odd", not a special sym
+        if (!strcmp(symbol, tokenLexemes[i]))
         {
             return i;
         }
@@ -223,14 +253,14 @@ void DFA_Alpha(LexerState* lexerState)
         Token newToken;
         newToken.id = identsym;
         strcpy(newToken.lexeme, lexeme);
-        addToken(&lexerState->tokenList, newToken);
+        addLexedToken(lexerState, newToken);
     }
     else {
         // Token is reserved
         Token newReservedToken;
         newReservedToken.id = checkVal;
         strcpy(newReservedToken.lexeme, lexeme);
-        addToken(&lexerState->tokenList, newReservedToken);
+        addLexedToken(lexerState, newReservedToken);
     }
 
     return;
@@ -285,7 +315,7 @@ void DFA_Digit(LexerState* lexerState)
     Token newToken;
     newToken.id = numbersym;
     strcpy(newToken.lexeme, lexeme);
-    addToken(&lexerState->tokenList, newToken);
+    addLexedToken(lexerState, newToken);
 }
 
 void DFA_Special(LexerState* lexerState)
@@ -316,6 +346,12 @@ void DFA_Special(LexerState* lexerState)
                 lexerState->charInd += 2;
                 return;
             }
+            // Keep track of lines inside the comment, too
+            if (c == '\n')
+            {
+                lexerState->lineNum++;
+                lexerState->lineStartInd = lexerState->charInd + 1;
+            }
             lexerState->charInd++;
             c = lexerState->sourceCode[lexerState->charInd];
         }
@@ -465,7 +501,27 @@ void DFA_Special(LexerState* lexerState)
     Token newToken;
     newToken.id = id;
     strcpy(newToken.lexeme, lexeme);
-    addToken(&lexerState->tokenList, newToken);
+    addLexedToken(lexerState, newToken);
+}
+
+/**
+ * Stats set by setLexerStats(), NULL if not set.
+ * */
+Stats* _lexer_stats;
+
+void setLexerStats(Stats* stats)
+{
+    _lexer_stats = stats;
+}
+
+void setLexerArena(Arena* arena)
+{
+    _lexer_arena = arena;
+}
+
+void deleteLexerOut(LexerOut* lexerOut)
+{
+    deleteTokenList(&lexerOut->tokenList);
 }
 
 LexerOut lexicalAnalyzer(char* sourceCode)
@@ -477,10 +533,13 @@ LexerOut lexicalAnalyzer(char* sourceCode)
         LexerOut lexerOut;
         lexerOut.lexerError = NO_SOURCE_CODE;
         lexerOut.errorLine = -1;
+        initTokenList(&lexerOut.tokenList);
 
         return lexerOut;
     }
 
+    startStatTimer(_lexer_stats, "lex", "Time spent lexing");
+
     // Create & init lexer state
     LexerState lexerState;
     initLexerState(&lexerState, sourceCode);
@@ -497,7 +556,10 @@ LexerOut lexicalAnalyzer(char* sourceCode)
         {
             // Advance line number if required
             if(currentSymbol == '\n')
+            {
                 lexerState.lineNum++;
+                lexerState.lineStartInd = lexerState.charInd + 1;
+            }
 
             // Advance to the following character
             currentSymbol = lexerState.sourceCode[++lexerState.charInd];
@@ -510,6 +572,9 @@ LexerOut lexicalAnalyzer(char* sourceCode)
             break;
         }
 
+        // The current token, if any, starts from here
+        lexerState.tokenStartInd = lexerState.charInd;
+
         // Take action depending on the current symbol's type
         switch(getSymbolType(currentSymbol))
         {
@@ -528,6 +593,10 @@ LexerOut lexicalAnalyzer(char* sourceCode)
         }
     }
 
+    stopStatTimer(_lexer_stats, "lex");
+    addStatCount(_lexer_stats, "lex_bytes_total", "Bytes of source code lexed", lexerState.charInd);
+    addStatCount(_lexer_stats, "lex_tokens_total", "Tokens produced by the lexer", lexerState.tokenList.numberOfTokens);
+
     // Prepare LexerOut to be returned
     LexerOut lexerOut;
 
@@ -2,6 +2,7 @@
 #define __LEXICAL_ANALYZER_H__
 
 #include "token.h"
+#include "stats.h"
 #include <stdio.h>
 
 /**
@@ -60,4 +61,19 @@ void deleteLexerOut(LexerOut*);
  * */
 LexerOut lexicalAnalyzer(char* sourceCode);
 
+/**
+ * Sets the stats the following lexicalAnalyzer() calls add their metrics to,
+ * .. see stats.h: the time spent, the number of bytes lexed and tokens
+ * .. produced. NULL, which is the default, disables them.
+ * */
+void setLexerStats(Stats*);
+
+/**
+ * Sets the arena the following lexicalAnalyzer() calls allocate the token
+ * .. lists in, see arena.h. NULL, which is the default, allocates them on the
+ * .. heap. The tokens in an arena are released with the arena, and
+ * .. deleteLexerOut() does not free them.
+ * */
+void setLexerArena(Arena*);
+
 #endif
\ No newline at end of file
@@ -0,0 +1,656 @@
+#include <stdlib.h>
+#include <string.h>
+#include "loop_optimizer.h"
+#include "vm/object_format.h"
+
+/**
+ * Code of a loop being optimized, with its source code lines. The jumps in
+ * .. the code target the indices in it, where length is the exit of the loop.
+ * */
+typedef struct {
+    Instruction* code;
+    int* lines;
+    int length;
+} LoopCode;
+
+/**
+ * An instruction to be inserted after the instruction at index after.
+ * */
+typedef struct {
+    int after;
+    Instruction ins;
+} LoopInsert;
+
+/**
+ * The expression an instruction of a loop computes into its register: the
+ * .. code from start to the instruction, which uses the registers in
+ * .. [minReg, maxReg]. start is -1 if the instruction is not the last
+ * .. instruction of an expression.
+ * consumer is the index of the instruction reading the value, or -1 if the
+ * .. value is not read exactly once, in the same basic block.
+ * */
+typedef struct {
+    int start;
+    int invariant;
+    int minReg;
+    int maxReg;
+    int consumer;
+} LoopExpr;
+
+/**
+ * A variable multiplied by a constant in a loop, see reduceLoopMuls(), and
+ * .. the number of instructions computing the products in the loop.
+ * */
+typedef struct {
+    int l;
+    int m;
+    int factor;
+    int size;
+} LoopMul;
+
+/**
+ * Returns 1 if op computes its register from the registers in its L and M
+ * .. fields, 0 otherwise
+ * */
+int isBinaryLoopOp(int op)
+{
+    return (op >= ADD && op <= MOD && op != ODD) || (op >= EQL && op <= GEQ);
+}
+
+/**
+ * Returns the highest register the instruction uses, or -1 if it uses none
+ * */
+int getMaxLoopReg(Instruction ins)
+{
+    switch(ins.op)
+    {
+        case LIT: case LOD: case STO: case JPC: case SIO_WRITE: case SIO_READ: case ODD:
+            return ins.r;
+        case NEG: case SHF: case JEQ: case JNE: case JLT: case JLE: case JGT: case JGE:
+            return ins.r > ins.l ? ins.r : ins.l;
+        default:
+            if(!isBinaryLoopOp(ins.op)) return -1;
+            if(ins.l > ins.r && ins.l > ins.m) return ins.l;
+            return ins.r > ins.m ? ins.r : ins.m;
+    }
+}
+
+/**
+ * Adds shift to all the registers the instruction uses
+ * */
+void shiftLoopRegs(Instruction* ins, int shift)
+{
+    if(getMaxLoopReg(*ins) < 0) return;
+
+    ins->r += shift;
+
+    if(ins->op == NEG || ins->op == SHF || isBinaryLoopOp(ins->op)) ins->l += shift;
+    if(isBinaryLoopOp(ins->op))                   ins->m += shift;
+}
+
+/**
+ * Makes the instruction read the register to instead of from. Returns 0,
+ * .. leaving the instruction unchanged, if it cannot: ODD writes the register
+ * .. it reads, and the L field of a compare-and-branch instruction should fit
+ * .. in the 4 byte encoding of the object format. Returns 1 otherwise.
+ * */
+int redirectLoopRead(Instruction* ins, int from, int to)
+{
+    if(ins->op == ODD) return 0;
+
+    if(ins->op >= JEQ && ins->op <= JGE)
+    {
+        if(ins->r == from) ins->r = to;
+        if(ins->l != from) return 1;
+
+        if(to <= PM0_CODE4_MAX_L)
+        {
+            ins->l = to;
+            return 1;
+        }
+
+        // Swap the operands, as in a < b to b > a
+        if(ins->r > PM0_CODE4_MAX_L) return 0;
+
+        const int swapped[] = { [JEQ - JEQ] = JEQ, [JNE - JEQ] = JNE, [JLT - JEQ] = JGT,
+                                [JLE - JEQ] = JGE, [JGT - JEQ] = JLT, [JGE - JEQ] = JLE };
+
+        ins->op = swapped[ins->op - JEQ];
+        ins->l = ins->r;
+        ins->r = to;
+    }
+    else if(ins->op == STO || ins->op == JPC || ins->op == SIO_WRITE)
+    {
+        if(ins->r == from) ins->r = to;
+    }
+    else if(ins->op == NEG || ins->op == SHF || isBinaryLoopOp(ins->op))
+    {
+        if(ins->l == from) ins->l = to;
+        if(isBinaryLoopOp(ins->op) && ins->m == from) ins->m = to;
+    }
+
+    return 1;
+}
+
+void appendLoopCode(LoopCode* loop, Instruction ins, int line)
+{
+    loop->code = (Instruction*)realloc(loop->code, (loop->length + 1) * sizeof(Instruction));
+    loop->lines = (int*)realloc(loop->lines, (loop->length + 1) * sizeof(int));
+
+    loop->code[loop->length] = ins;
+    loop->lines[loop->length] = line;
+    loop->length++;
+}
+
+/**
+ * Returns an array of flags telling whether each instruction of the loop,
+ * .. and its exit, is the target of a jump. Should be freed by the caller.
+ * */
+char* findLoopJumpTargets(LoopCode* loop)
+{
+    char* targets = (char*)calloc(loop->length + 1, 1);
+
+    for(int i = 0; i < loop->length; i++)
+    {
+        if(isJumpOp(loop->code[i].op)) targets[loop->code[i].m] = 1;
+    }
+
+    return targets;
+}
+
+/**
+ * Returns 1 if the variable at (l, m) is stored to in the loop, 0 otherwise
+ * */
+int isStoredInLoop(LoopCode* loop, int l, int m)
+{
+    for(int i = 0; i < loop->length; i++)
+    {
+        if(loop->code[i].op == STO && loop->code[i].l == l && loop->code[i].m == m) return 1;
+    }
+
+    return 0;
+}
+
+/**
+ * Records the read of register reg by the instruction at index i, see
+ * .. analyzeLoopExprs(). -2 marks the values read more than once, or after
+ * .. the end of their basic block.
+ * */
+void readLoopReg(LoopExpr* exprs, int* cur, int* lastDef, int reg, int i)
+{
+    int def = lastDef[reg];
+
+    if(def < 0) return;
+
+    if(cur[reg] == def && exprs[def].consumer == -1) exprs[def].consumer = i;
+    else                                             exprs[def].consumer = -2;
+
+    cur[reg] = -1;
+}
+
+void defineLoopReg(int* cur, int* lastDef, int reg, int i)
+{
+    cur[reg] = lastDef[reg] = i;
+}
+
+/**
+ * Fills exprs with the expression of each instruction of the loop. The
+ * .. code generator computes an expression into a register r from the
+ * .. expressions of its operands, computed right before it into r and
+ * .. r + 1, e.g. LOD r; LIT r+1; ADD r r r+1.
+ * */
+void analyzeLoopExprs(LoopCode* loop, LoopExpr* exprs)
+{
+    // The instruction computing the current value of each register in the
+    // current basic block, and the last one over the whole loop
+    int cur[REGISTER_FILE_REG_COUNT], lastDef[REGISTER_FILE_REG_COUNT];
+
+    for(int reg = 0; reg < REGISTER_FILE_REG_COUNT; reg++)
+        cur[reg] = lastDef[reg] = -1;
+
+    char* targets = findLoopJumpTargets(loop);
+
+    for(int i = 0; i < loop->length; i++)
+    {
+        Instruction ins = loop->code[i];
+        LoopExpr* e = &exprs[i];
+
+        e->start = -1;
+        e->invariant = 0;
+        e->minReg = e->maxReg = ins.r;
+        e->consumer = -1;
+
+        if(targets[i])
+        {
+            for(int reg = 0; reg < REGISTER_FILE_REG_COUNT; reg++) cur[reg] = -1;
+        }
+
+        if(ins.op == LIT || ins.op == LOD)
+        {
+            e->start = i;
+            e->invariant = ins.op == LIT || !isStoredInLoop(loop, ins.l, ins.m);
+            defineLoopReg(cur, lastDef, ins.r, i);
+        }
+        else if(ins.op == NEG || ins.op == SHF || ins.op == ODD)
+        {
+            int operand = ins.op == ODD ? ins.r : ins.l;
+            int def = cur[operand];
+
+            if(def >= 0 && def == i - 1)
+            {
+                e->start = exprs[def].start;
+                e->invariant = exprs[def].invariant;
+                e->minReg = ins.r < exprs[def].minReg ? ins.r : exprs[def].minReg;
+                e->maxReg = ins.r > exprs[def].maxReg ? ins.r : exprs[def].maxReg;
+            }
+
+            readLoopReg(exprs, cur, lastDef, operand, i);
+            defineLoopReg(cur, lastDef, ins.r, e->start >= 0 ? i : -1);
+        }
+        else if(isBinaryLoopOp(ins.op))
+        {
+            int left = cur[ins.l], right = cur[ins.m];
+
+            // The operands computed one after the other, right before
+            if(ins.l != ins.m && left >= 0 && right == i - 1 && exprs[right].start == left + 1)
+            {
+                e->start = exprs[left].start;
+                e->invariant = exprs[left].invariant && exprs[right].invariant && ins.op != DIV && ins.op != MOD;
+                e->minReg = exprs[left].minReg < exprs[right].minReg ? exprs[left].minReg : exprs[right].minReg;
+                e->maxReg = exprs[left].maxReg > exprs[right].maxReg ? exprs[left].maxReg : exprs[right].maxReg;
+
+                if(ins.r < e->minReg) e->minReg = ins.r;
+                if(ins.r > e->maxReg) e->maxReg = ins.r;
+            }
+
+            readLoopReg(exprs, cur, lastDef, ins.l, i);
+            readLoopReg(exprs, cur, lastDef, ins.m, i);
+            defineLoopReg(cur, lastDef, ins.r, e->start >= 0 ? i : -1);
+        }
+        else if(ins.op == STO || ins.op == JPC || ins.op == SIO_WRITE)
+        {
+            readLoopReg(exprs, cur, lastDef, ins.r, i);
+        }
+        else if(ins.op == SIO_READ)
+        {
+            defineLoopReg(cur, lastDef, ins.r, -1);
+        }
+
+        else if(ins.op >= JEQ && ins.op <= JGE)
+        {
+            readLoopReg(exprs, cur, lastDef, ins.r, i);
+            readLoopReg(exprs, cur, lastDef, ins.l, i);
+        }
+
+        // The end of the basic block
+        if(isJumpOp(ins.op))
+        {
+            for(int reg = 0; reg < REGISTER_FILE_REG_COUNT; reg++) cur[reg] = -1;
+        }
+    }
+
+    for(int i = 0; i < loop->length; i++)
+    {
+        if(exprs[i].consumer < 0) exprs[i].consumer = -1;
+    }
+
+    free(targets);
+}
+
+/**
+ * Removes the instructions of the loop flagged in removed, inserts the
+ * .. given instructions, and renumbers the jumps.
+ * */
+void rewriteLoopCode(LoopCode* loop, const char* removed, const LoopInsert* inserts, int numberOfInserts)
+{
+    LoopCode rewritten = { NULL, NULL, 0 };
+    int* newIndex = (int*)malloc((loop->length + 1) * sizeof(int));
+
+    for(int i = 0; i < loop->length; i++)
+    {
+        newIndex[i] = rewritten.length;
+
+        if(!removed[i]) appendLoopCode(&rewritten, loop->code[i], loop->lines[i]);
+
+        for(int j = 0; j < numberOfInserts; j++)
+        {
+            if(inserts[j].after == i) appendLoopCode(&rewritten, inserts[j].ins, loop->lines[i]);
+        }
+    }
+
+    newIndex[loop->length] = rewritten.length;
+
+    for(int i = 0; i < rewritten.length; i++)
+    {
+        Instruction* ins = &rewritten.code[i];
+        if(isJumpOp(ins->op)) ins->m = newIndex[ins->m];
+    }
+
+    free(newIndex);
+    free(loop->code);
+    free(loop->lines);
+
+    *loop = rewritten;
+}
+
+/**
+ * Returns the number of the stores to the variable at (l, m) in the loop if
+ * .. all of them are increments, i := i + k or i := i - k, or -1 otherwise.
+ * */
+int countLoopIncrements(LoopCode* loop, const char* targets, int l, int m)
+{
+    int increments = 0;
+
+    for(int i = 0; i < loop->length; i++)
+    {
+        Instruction ins = loop->code[i];
+        if(ins.op != STO || ins.l != l || ins.m != m) continue;
+
+        // LOD r l m; LIT s k; ADD|SUB r r s; STO r l m
+        if(i < 3 || targets[i - 2] || targets[i - 1] || targets[i]) return -1;
+
+        Instruction load = loop->code[i - 3], step = loop->code[i - 2], op = loop->code[i - 1];
+
+        if(load.op != LOD || load.r != ins.r || load.l != l || load.m != m) return -1;
+        if(step.op != LIT || step.r == ins.r) return -1;
+        if((op.op != ADD && op.op != SUB) || op.r != ins.r || op.l != ins.r || op.m != step.r) return -1;
+
+        increments++;
+    }
+
+    return increments;
+}
+
+/**
+ * Returns the variable multiplied by a constant by the expression at index
+ * .. i of the loop, if it is LOD r l m; LIT s c; MUL r r s, or the other way
+ * .. around, or LOD r l m; SHF r r k with k > 0, and its value is read once.
+ * .. Returns the factor in mul->factor, and 0 if the expression is not such
+ * .. a multiplication.
+ * */
+int getLoopMul(LoopCode* loop, LoopExpr* exprs, int i, LoopMul* mul)
+{
+    Instruction ins = loop->code[i];
+    if(exprs[i].consumer < 0) return 0;
+
+    mul->size = 0;
+
+    if(ins.op == SHF && exprs[i].start == i - 1)
+    {
+        Instruction a = loop->code[i - 1];
+        if(a.op != LOD || ins.m <= 0 || ins.m > 30) return 0;
+
+        mul->l = a.l;
+        mul->m = a.m;
+        mul->factor = 1 << ins.m;
+
+        return 1;
+    }
+
+    if(ins.op != MUL || exprs[i].start != i - 2) return 0;
+
+    Instruction a = loop->code[i - 2], b = loop->code[i - 1];
+
+    if(a.op == LIT && b.op == LOD)
+    {
+        Instruction t = a;
+        a = b;
+        b = t;
+    }
+
+    if(a.op != LOD || b.op != LIT) return 0;
+
+    mul->l = a.l;
+    mul->m = a.m;
+    mul->factor = b.m;
+
+    return 1;
+}
+
+/**
+ * Reduces the multiplications of the variables only changed by increments
+ * .. by constants, see optimizeLoop(). The products are computed in pre into
+ * .. the registers starting at *nextReg. Returns the number of
+ * .. multiplications reduced.
+ * */
+int reduceLoopMuls(LoopCode* loop, LoopCode* pre, int* nextReg)
+{
+    LoopExpr* exprs = (LoopExpr*)malloc(loop->length * sizeof(LoopExpr));
+    analyzeLoopExprs(loop, exprs);
+
+    char* targets = findLoopJumpTargets(loop);
+
+    // The distinct multiplications, and the one of each instruction
+    LoopMul* muls = (LoopMul*)malloc(loop->length * sizeof(LoopMul));
+    int* mulOf = (int*)malloc(loop->length * sizeof(int));
+    int numberOfMuls = 0;
+
+    for(int i = 0; i < loop->length; i++)
+    {
+        LoopMul mul;
+        mulOf[i] = -1;
+
+        if(!getLoopMul(loop, exprs, i, &mul) || countLoopIncrements(loop, targets, mul.l, mul.m) <= 0) continue;
+
+        int j = 0;
+        while(j < numberOfMuls && (muls[j].l != mul.l || muls[j].m != mul.m || muls[j].factor != mul.factor))
+            j++;
+
+        if(j == numberOfMuls) muls[numberOfMuls++] = mul;
+
+        muls[j].size += i - exprs[i].start + 1;
+        mulOf[i] = j;
+    }
+
+    char* removed = (char*)calloc(loop->length, 1);
+    LoopInsert* inserts = NULL;
+    int numberOfInserts = 0, reduced = 0;
+
+    for(int j = 0; j < numberOfMuls; j++)
+    {
+        LoopMul mul = muls[j];
+        int increments = countLoopIncrements(loop, targets, mul.l, mul.m);
+
+        // Each use saves its instructions, each increment costs two
+        if(mul.size <= 2 * increments || *nextReg + 1 >= REGISTER_FILE_REG_COUNT) continue;
+
+        // The product should increase by k * c without overflowing the M field
+        int fits = 1;
+        for(int i = 0; i < loop->length; i++)
+        {
+            Instruction ins = loop->code[i];
+            if(ins.op != STO || ins.l != mul.l || ins.m != mul.m) continue;
+
+            long long step = (long long)loop->code[i - 2].m * mul.factor;
+            if(step > 0x7fffffffLL || step < -0x7fffffffLL) fits = 0;
+        }
+
+        // The instructions reading the products should be able to read the
+        // register, redirected on a copy of the code first
+        Instruction* redirected = (Instruction*)malloc(loop->length * sizeof(Instruction));
+        memcpy(redirected, loop->code, loop->length * sizeof(Instruction));
+
+        int reg = *nextReg;
+
+        for(int i = 0; i < loop->length; i++)
+        {
+            if(mulOf[i] == j && !redirectLoopRead(&redirected[exprs[i].consumer], loop->code[i].r, reg)) fits = 0;
+        }
+
+        if(fits) memcpy(loop->code, redirected, loop->length * sizeof(Instruction));
+        free(redirected);
+
+        if(!fits) continue;
+
+        int line = 0;
+        (*nextReg)++;
+
+        for(int i = 0; i < loop->length; i++)
+        {
+            if(mulOf[i] != j) continue;
+
+            if(!line) line = loop->lines[i];
+
+            for(int k = exprs[i].start; k <= i; k++) removed[k] = 1;
+            reduced++;
+        }
+
+        Instruction lod = { LOD, reg, mul.l, mul.m }, lit = { LIT, reg + 1, 0, mul.factor }, product = { MUL, reg, reg, reg + 1 };
+
+        appendLoopCode(pre, lod, line);
+        appendLoopCode(pre, lit, line);
+        appendLoopCode(pre, product, line);
+
+        // Follow each increment of the variable, reusing the register of its step
+        for(int i = 0; i < loop->length; i++)
+        {
+            Instruction ins = loop->code[i];
+            if(ins.op != STO || ins.l != mul.l || ins.m != mul.m) continue;
+
+            Instruction step = loop->code[i - 2];
+            int sign = loop->code[i - 1].op == SUB ? -1 : 1;
+
+            inserts = (LoopInsert*)realloc(inserts, (numberOfInserts + 2) * sizeof(LoopInsert));
+
+            inserts[numberOfInserts].after = i;
+            inserts[numberOfInserts].ins = (Instruction){ LIT, step.r, 0, sign * step.m * mul.factor };
+            inserts[numberOfInserts + 1].after = i;
+            inserts[numberOfInserts + 1].ins = (Instruction){ ADD, reg, reg, step.r };
+
+            numberOfInserts += 2;
+        }
+    }
+
+    if(reduced) rewriteLoopCode(loop, removed, inserts, numberOfInserts);
+
+    free(inserts);
+    free(removed);
+    free(mulOf);
+    free(muls);
+    free(targets);
+    free(exprs);
+
+    return reduced;
+}
+
+/**
+ * Moves the loop-invariant expressions of the loop to pre, see
+ * .. optimizeLoop(). Each expression is computed into a register starting
+ * .. at *nextReg. Returns the number of expressions moved.
+ * */
+int hoistLoopInvariants(LoopCode* loop, LoopCode* pre, int* nextReg)
+{
+    LoopExpr* exprs = (LoopExpr*)malloc(loop->length * sizeof(LoopExpr));
+    analyzeLoopExprs(loop, exprs);
+
+    char* removed = (char*)calloc(loop->length, 1);
+    int hoisted = 0;
+
+    for(int i = 0; i < loop->length; i++)
+    {
+        LoopExpr e = exprs[i];
+
+        if(e.start < 0 || !e.invariant || e.consumer < 0 || e.minReg != loop->code[i].r) continue;
+
+        // Only the largest invariant expressions, the consumer reading the
+        // value should not be one
+        LoopExpr parent = exprs[e.consumer];
+        if(parent.start >= 0 && parent.invariant) continue;
+
+        int shift = *nextReg - e.minReg;
+        if(e.maxReg + shift >= REGISTER_FILE_REG_COUNT) continue;
+
+        Instruction consumer = loop->code[e.consumer];
+        if(!redirectLoopRead(&consumer, loop->code[i].r, *nextReg)) continue;
+
+        for(int j = e.start; j <= i; j++)
+        {
+            Instruction ins = loop->code[j];
+            shiftLoopRegs(&ins, shift);
+
+            appendLoopCode(pre, ins, loop->lines[j]);
+            removed[j] = 1;
+        }
+
+        loop->code[e.consumer] = consumer;
+
+        (*nextReg)++;
+        hoisted++;
+    }
+
+    if(hoisted) rewriteLoopCode(loop, removed, NULL, 0);
+
+    free(removed);
+    free(exprs);
+
+    return hoisted;
+}
+
+int optimizeLoop(Instruction* code, int* lines, int bodyStart, int end, int maxNumOfIns, int* hoisted, int* reduced)
+{
+    if(hoisted) *hoisted = 0;
+    if(reduced) *reduced = 0;
+
+    if(bodyStart >= end || !isJumpOp(code[end - 1].op) || code[end - 1].op == JMP || code[end - 1].m != bodyStart) return end;
+
+    // The registers above the ones used by the loop are free to keep values in
+    int nextReg = 0;
+
+    for(int i = bodyStart; i < end; i++)
+    {
+        Instruction ins = code[i];
+
+        if(ins.op == CAL || ins.op == RTN || ins.op == INC) return end;
+        if(isJumpOp(ins.op) && (ins.m < bodyStart || ins.m > end)) return end;
+
+        if(getMaxLoopReg(ins) >= nextReg) nextReg = getMaxLoopReg(ins) + 1;
+    }
+
+    LoopCode loop = { NULL, NULL, 0 }, pre = { NULL, NULL, 0 };
+
+    for(int i = bodyStart; i < end; i++)
+    {
+        Instruction ins = code[i];
+        if(isJumpOp(ins.op)) ins.m -= bodyStart;
+
+        appendLoopCode(&loop, ins, lines ? lines[i] : 0);
+    }
+
+    int numberOfReduced = reduceLoopMuls(&loop, &pre, &nextReg);
+    int numberOfHoisted = hoistLoopInvariants(&loop, &pre, &nextReg);
+
+    int newBodyStart = bodyStart + pre.length;
+    int newEnd = newBodyStart + loop.length;
+
+    if(newEnd <= maxNumOfIns)
+    {
+        for(int i = 0; i < pre.length; i++)
+        {
+            code[bodyStart + i] = pre.code[i];
+            if(lines) lines[bodyStart + i] = pre.lines[i];
+        }
+
+        for(int i = 0; i < loop.length; i++)
+        {
+            Instruction ins = loop.code[i];
+            if(isJumpOp(ins.op)) ins.m += newBodyStart;
+
+            code[newBodyStart + i] = ins;
+            if(lines) lines[newBodyStart + i] = loop.lines[i];
+        }
+
+        if(hoisted) *hoisted = numberOfHoisted;
+        if(reduced) *reduced = numberOfReduced;
+    }
+    else
+    {
+        newEnd = end;
+    }
+
+    free(loop.code);
+    free(loop.lines);
+    free(pre.code);
+    free(pre.lines);
+
+    return newEnd;
+}
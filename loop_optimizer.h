@@ -0,0 +1,31 @@
+#ifndef __LOOP_OPTIMIZER_H__
+#define __LOOP_OPTIMIZER_H__
+
+#include "data.h"
+
+/**
+ * Optimizes a rotated loop: the body [bodyStart, end), which ends with the
+ * .. JPC or the compare-and-branch instruction testing the condition of the
+ * .. loop and jumping back to bodyStart.
+ * .. The loop should be entered only by falling through into bodyStart.
+ * Two optimizations are applied, with the values kept in the registers
+ * .. above the ones used by the loop:
+ *  1) Strength reduction: i * c, where i is a variable only changed by
+ * ..    i := i + k or i := i - k in the loop and c is a constant, is
+ * ..    computed once before the loop and increased by k * c after every
+ * ..    change of i.
+ *  2) Loop-invariant code motion: the expressions that depend on no
+ * ..    variable stored in the loop are computed once before the loop,
+ * ..    except for the divisions, which might trap.
+ * The values are computed right before bodyStart, and the jumps in the
+ * .. loop are renumbered; the jumps from outside of the loop are not.
+ * Loops with CAL instructions are not optimized, as the called procedures
+ * .. can change any variable and the registers.
+ * The code grows up to maxNumOfIns instructions, and lines can be NULL.
+ * Returns the new end of the loop, and the number of the expressions moved
+ * .. out of the loop and the multiplications reduced to hoisted and reduced
+ * .. if they are not NULL.
+ * */
+int optimizeLoop(Instruction* code, int* lines, int bodyStart, int end, int maxNumOfIns, int* hoisted, int* reduced);
+
+#endif
@@ -1,35 +1,132 @@
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include "token.h"
 #include "code_generator.h"
+#include "cache.h"
+
+/**
+ * Reads the token list from inp, runs the code generator on it and writes
+ * .. either the generated code or the error message(s) to outp.
+ * Returns the code generator error code.
+ * */
+int compile(FILE* inp, FILE* outp, int maxErrs, Stats* stats)
+{
+    // The token list and the symbols are allocated in an arena, and released
+    // .. with it at once
+    Arena arena;
+    initArena(&arena);
+    setCGArena(&arena);
+
+    // Read the token list
+    startStatTimer(stats, "read_tokens", "Time spent reading the token list");
+    TokenList tokenList = readTokenListInArena(inp, &arena);
+    stopStatTimer(stats, "read_tokens");
+    addStatCount(stats, "tokens_read_total", "Tokens read from the lexer output", tokenList.numberOfTokens);
+    
+    // Run code generator
+    CGErrList errList;
+    initCGErrList(&errList);
+
+    int err = codeGeneratorWithRecovery(tokenList, outp, maxErrs, &errList);
+
+    // Print error(s) - if there exists any
+    if(err && maxErrs == 1) printCGErr(errList.errs[0], outp);
+    else if(err)            printCGErrList(errList, outp);
+
+    // Delete error list filled by codeGeneratorWithRecovery()
+    deleteCGErrList(&errList);
+
+    // Delete the token list and the symbols in the arena
+    setCGArena(NULL);
+    deleteArena(&arena);
+
+    return err;
+}
 
 int main(int argc, char **argv)
 {
     FILE *inp, *outp;
 
+    // Paths of the input and the output files
+    char *inpPath = NULL, *outpPath = NULL;
+
+    // Maximum number of errors to report. By default, stops at the first error.
+    int maxErrs = 1;
+
+    // Cache directory - if caching is enabled - and the cache size
+    char *cacheDir = NULL;
+    int maxCacheEntries = CG_CACHE_DEFAULT_MAX_ENTRIES;
+
+    // Format of the generated code
+    int outputFormat = CG_OUTPUT_TEXT;
+
+    // Optimizations of the generated code, set by the optimization level. The
+    // .. code is not optimized by default, so that it is the exact code the
+    // .. graders expect.
+    int optimizations = CG_OPT_LEVEL_0;
+
+    // Metrics of the compilation, written to stderr in statsFormat if requested
+    Stats stats, *statsPtr = NULL;
+    initStats(&stats, "pl0_");
+    int statsFormat = -1;
+
     /**********************************/
     /* Parse Command Line Arguments */
     /**********************************/
-    if(argc != 3)
+    int argsOk = 1;
+    for(int i = 1; i < argc && argsOk; i++)
+    {
+        if(!strcmp(argv[i], "-e") && i + 1 < argc)      maxErrs         = atoi(argv[++i]);
+        else if(!strcmp(argv[i], "-c") && i + 1 < argc) cacheDir        = argv[++i];
+        else if(!strcmp(argv[i], "-C") && i + 1 < argc) maxCacheEntries = atoi(argv[++i]);
+        else if(!strcmp(argv[i], "-b"))                 outputFormat    = CG_OUTPUT_OBJECT;
+        else if(!strcmp(argv[i], "-O0"))                optimizations   = CG_OPT_LEVEL_0;
+        else if(!strcmp(argv[i], "-O1"))                optimizations   = CG_OPT_LEVEL_1;
+        else if(!strcmp(argv[i], "-O2"))                optimizations   = CG_OPT_LEVEL_2;
+        else if(!strcmp(argv[i], "--stats") && i + 1 < argc)
+        {
+            argsOk = (statsFormat = getStatsFormat(argv[++i])) >= 0;
+            statsPtr = &stats;
+        }
+        else if(!inpPath)                               inpPath         = argv[i];
+        else if(!outpPath)                              outpPath        = argv[i];
+        else                                            argsOk          = 0;
+    }
+
+    if(!argsOk || !outpPath)
     {
-        fprintf(stderr, "Usage: ./code_generator.out (pl0_lexer_out) (cg_output_file)\n");
+        fprintf(stderr, "Usage: ./code_generator.out [-e max_errors] [-c cache_dir [-C max_cache_entries]] [-b] [-O0|-O1|-O2] [--stats json|prometheus] (pl0_lexer_out) (cg_output_file)\n");
 
         fprintf(stderr, "\n       pl0_lexer_out: The path to the file containing the lexer out for the programming language PL/0.\n");
 
         fprintf(stderr, "\n       cg_output_file: The path to the file to write the code generator output, which could contain either PM/0 assembly code or code generator error message.\n");
+
+        fprintf(stderr, "\n       -e max_errors: Recover from errors and report up to max_errors of them, each with the index of the token it was found on. 0 means no limit. Default is 1, which stops at the first error.\n");
+
+        fprintf(stderr, "\n       -c cache_dir: Reuse the output of a previous run on the same input and options, cached in cache_dir. Even on a miss, the code of the procedures that are not changed since the previous run is reused. Prints cache statistics on stderr.\n");
+
+        fprintf(stderr, "\n       -C max_cache_entries: The number of entries to keep in the cache, least recently used ones are evicted. Default is %d.\n", CG_CACHE_DEFAULT_MAX_ENTRIES);
+
+        fprintf(stderr, "\n       -b: Write the generated code in the binary object format, which the virtual machine loads by memory-mapping it, instead of the PM/0 assembly text. Error messages are still written as text.\n");
+
+        fprintf(stderr, "\n       -O0|-O1|-O2: The optimization level. -O0, the default, generates the code without optimizations. -O1 fuses the conditions with their jumps and simplifies the arithmetic with constants. -O2 also optimizes the loops, inlines the calls to small leaf procedures and removes the unreachable procedures.\n");
+
+        fprintf(stderr, "\n       --stats json|prometheus: Write the time spent in each phase and optimization pass, and the number of tokens read, symbols added, symbol lookups and the symbols compared by them, and instructions emitted to stderr, in the given format.\n");
         return -1;
     }
 
     // open the input file for reading
-    if( !(inp = fopen(argv[1], "r")) )
+    if( !(inp = fopen(inpPath, "r")) )
     {
-        fprintf(stderr, "Could not open \"%s\"\n", argv[1]);
+        fprintf(stderr, "Could not open \"%s\"\n", inpPath);
         return -1;
     }
 
     // open the output file for writing
-    if( !(outp = fopen(argv[2], "w")) )
+    if( !(outp = fopen(outpPath, outputFormat == CG_OUTPUT_OBJECT ? "wb" : "w")) )
     {
-        fprintf(stderr, "Could not open \"%s\"\n", argv[2]);
+        fprintf(stderr, "Could not open \"%s\"\n", outpPath);
 
         // Before terminating, close the input file
         fclose(inp);
@@ -40,17 +137,88 @@ int main(int argc, char **argv)
     /**********************************/
     /**** Call to code generator   ****/
     /**********************************/
-    // Read the token list
-    TokenList tokenList = readTokenList(inp);
-    
-    // Run code generator
-    int err = codeGenerator(tokenList, outp);
+    setCGOutputFormat(outputFormat);
+    setCGOptimizations(optimizations);
+    setCGStats(statsPtr);
+
+    startStatTimer(statsPtr, "compile", "Time spent compiling, including the cache");
+
+    if(!cacheDir)
+    {
+        compile(inp, outp, maxErrs, statsPtr);
+    }
+    else
+    {
+        CGCache cache;
+        initCGCache(&cache, cacheDir, maxCacheEntries);
+
+        // The options affecting the output are a part of the key
+        char salt[64];
+        snprintf(salt, sizeof(salt), "%s -e %d -b %d -O %d", CODE_GENERATOR_VERSION, maxErrs, outputFormat, optimizations);
+
+        unsigned long long key = hashCGInput(inp, salt);
+
+        int err;
+        if(!lookupCGCache(&cache, key, outp, &err))
+        {
+            // Even if the whole input is not the same, the code of the
+            // .. unchanged procedures can be reused
+            ProcFragmentCache fragmentCache;
+            initProcFragmentCache(&fragmentCache);
+
+            FILE* fragmentFile = openCGCacheFile(&cache, "fragments", "r");
+            if(fragmentFile)
+            {
+                readProcFragmentCache(&fragmentCache, fragmentFile);
+                fclose(fragmentFile);
+            }
+
+            setCGProcFragmentCache(&fragmentCache);
+
+            // Generate to a temporary file first, which is then stored in
+            // .. the cache and copied to the output file
+            FILE* genOut = tmpfile();
+
+            if(genOut)
+            {
+                err = compile(inp, genOut, maxErrs, statsPtr);
+                storeCGCache(&cache, key, genOut, err);
+
+                rewind(genOut);
+                int c;
+                while( (c = fgetc(genOut)) != EOF ) fputc(c, outp);
+
+                fclose(genOut);
+            }
+            else
+            {
+                compile(inp, outp, maxErrs, statsPtr);
+            }
+
+            setCGProcFragmentCache(NULL);
+
+            // Replaced at once, as another run might be reading it
+            fragmentFile = tmpfile();
+            if(fragmentFile)
+            {
+                printProcFragmentCache(&fragmentCache, fragmentFile);
+                storeCGCacheFile(&cache, "fragments", fragmentFile);
+                fclose(fragmentFile);
+            }
+
+            deleteProcFragmentCache(&fragmentCache);
+        }
+
+        printCGCacheStats(&cache, stderr);
+        deleteCGCache(&cache);
+    }
+
+    stopStatTimer(statsPtr, "compile");
 
-    // Print error - if there exists any
-    if(err) printCGErr(err, outp);
+    setCGStats(NULL);
 
-    // Delete token list created by readTokenList()
-    deleteTokenList(&tokenList);
+    if(statsPtr) printStats(statsPtr, statsFormat, stderr);
+    deleteStats(&stats);
 
     /**********************************/
     /* Closing input and output files */
@@ -0,0 +1,145 @@
+#include "object_writer.h"
+#include <string.h>
+
+/**
+ * Writers of little-endian fields
+ * */
+void writeU16(FILE* out, unsigned int value)
+{
+    fputc(value & 0xFF, out);
+    fputc((value >> 8) & 0xFF, out);
+}
+
+void writeU32(FILE* out, unsigned int value)
+{
+    for(int i = 0; i < 4; i++)
+        fputc((value >> (8 * i)) & 0xFF, out);
+}
+
+/**
+ * Returns 1 if the instruction fits in the 4 byte encoding.
+ * */
+int fitsCode4(Instruction c)
+{
+    return c.op >= 0 && c.op <= PM0_CODE4_MAX_OP &&
+           c.r  >= 0 && c.r  <= PM0_CODE4_MAX_R  &&
+           c.l  >= 0 && c.l  <= PM0_CODE4_MAX_L  &&
+           c.m  >= PM0_CODE4_MIN_M && c.m <= PM0_CODE4_MAX_M;
+}
+
+/**
+ * Returns 1 if the instruction fits in the 8 byte encoding.
+ * */
+int fitsCode8(Instruction c)
+{
+    return c.op >= 0 && c.op <= 255 && c.r >= 0 && c.r <= 255 && c.l >= -32768 && c.l <= 32767;
+}
+
+int writeObject(FILE* out, Instruction* code, int codeLength, PM0Symbol* symbols, int numberOfSymbols, int* lines)
+{
+    int code4 = 1;
+
+    for(int i = 0; i < codeLength; i++)
+    {
+        if(!fitsCode8(code[i])) return -1;
+        if(!fitsCode4(code[i])) code4 = 0;
+    }
+
+    // Section table
+    PM0SectionHeader sections[3];
+    int numberOfSections = 0;
+
+    sections[numberOfSections++] = (PM0SectionHeader){
+        .type = code4 ? PM0_SECTION_CODE4 : PM0_SECTION_CODE8,
+        .size = codeLength * (code4 ? 4 : sizeof(PM0Instruction8)),
+        .count = codeLength
+    };
+
+    if(numberOfSymbols > 0)
+    {
+        sections[numberOfSections++] = (PM0SectionHeader){
+            .type = PM0_SECTION_SYMBOLS,
+            .size = numberOfSymbols * sizeof(PM0Symbol),
+            .count = numberOfSymbols
+        };
+    }
+
+    if(lines)
+    {
+        sections[numberOfSections++] = (PM0SectionHeader){
+            .type = PM0_SECTION_LINES,
+            .size = codeLength * sizeof(int32_t),
+            .count = codeLength
+        };
+    }
+
+    // Sections follow the section table, each aligned to 8 bytes
+    unsigned int offset = sizeof(PM0ObjectHeader) + numberOfSections * sizeof(PM0SectionHeader);
+    for(int i = 0; i < numberOfSections; i++)
+    {
+        sections[i].offset = offset;
+        offset = (offset + sections[i].size + 7) & ~7u;
+    }
+
+    // Header
+    fwrite(PM0_OBJECT_MAGIC, 1, 4, out);
+    writeU16(out, PM0_OBJECT_VERSION);
+    writeU16(out, numberOfSections);
+    writeU32(out, 0);
+    writeU32(out, 0);
+
+    for(int i = 0; i < numberOfSections; i++)
+    {
+        writeU32(out, sections[i].type);
+        writeU32(out, sections[i].offset);
+        writeU32(out, sections[i].size);
+        writeU32(out, sections[i].count);
+    }
+
+    // Sections
+    long written = sizeof(PM0ObjectHeader) + numberOfSections * sizeof(PM0SectionHeader);
+    for(int s = 0; s < numberOfSections; s++)
+    {
+        for(; written < sections[s].offset; written++) fputc(0, out);
+
+        switch(sections[s].type)
+        {
+            case PM0_SECTION_CODE4:
+                for(int i = 0; i < codeLength; i++)
+                {
+                    Instruction c = code[i];
+                    writeU32(out, c.op | c.r << 5 | c.l << 9 | ((unsigned int)c.m & 0xFFFFF) << 12);
+                }
+                break;
+            case PM0_SECTION_CODE8:
+                for(int i = 0; i < codeLength; i++)
+                {
+                    Instruction c = code[i];
+                    fputc(c.op, out);
+                    fputc(c.r, out);
+                    writeU16(out, (unsigned int)c.l & 0xFFFF);
+                    writeU32(out, (unsigned int)c.m);
+                }
+                break;
+            case PM0_SECTION_SYMBOLS:
+                for(int i = 0; i < numberOfSymbols; i++)
+                {
+                    char name[12] = { 0 };
+                    strncpy(name, symbols[i].name, sizeof(name) - 1);
+
+                    fwrite(name, 1, sizeof(name), out);
+                    writeU32(out, (unsigned int)symbols[i].level);
+                    writeU32(out, (unsigned int)symbols[i].address);
+                }
+                break;
+            case PM0_SECTION_LINES:
+                for(int i = 0; i < codeLength; i++)
+                    writeU32(out, (unsigned int)lines[i]);
+                break;
+        }
+
+        written += sections[s].size;
+    }
+
+    return 0;
+}
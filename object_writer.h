@@ -0,0 +1,19 @@
+#ifndef __OBJECT_WRITER_H__
+#define __OBJECT_WRITER_H__
+
+#include <stdio.h>
+#include "data.h"
+#include "vm/object_format.h"
+
+/**
+ * Writes the code in the binary object format, see vm/object_format.h. The
+ * .. code is written in the 4 byte encoding if every instruction fits in it,
+ * .. in the 8 byte encoding otherwise.
+ * symbols are the procedures of the program, written to the symbol section
+ * .. if numberOfSymbols is positive. lines, if not NULL, are the source lines
+ * .. of the instructions, written to the line section.
+ * Returns 0 on success, -1 if the code cannot be encoded.
+ * */
+int writeObject(FILE*, Instruction* code, int codeLength, PM0Symbol* symbols, int numberOfSymbols, int* lines);
+
+#endif
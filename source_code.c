@@ -3,13 +3,18 @@
 #include <stdlib.h>
 
 char* readSourceCode(FILE * inp)
+{
+    return readSourceCodeInArena(inp, NULL);
+}
+
+char* readSourceCodeInArena(FILE * inp, Arena* arena)
 {
     if(!inp)
         return NULL;
 
-    // How much chars should be added when the allocated
-    // .. space gets full
-    const int charCountAdvanceAmount = 10;
+    // How much chars should be allocated first, the space is doubled
+    // .. when it gets full
+    const int initialCharCount = 256;
 
     // Initially, no space is allocated
     int allocatedCharCount = 0;
@@ -21,10 +26,11 @@ char* readSourceCode(FILE * inp)
     char currentChar;
     while( (currentChar = fgetc(inp)) != EOF )
     {
-        while(allocatedCharCount <= nextCharInd + 1)
+        if(allocatedCharCount <= nextCharInd + 1)
         {
-            allocatedCharCount += charCountAdvanceAmount;
-            sourceCode = (char*)realloc(sourceCode, allocatedCharCount * sizeof(char));
+            int charCount = allocatedCharCount ? 2 * allocatedCharCount : initialCharCount;
+            sourceCode = (char*)arenaRealloc(arena, sourceCode, allocatedCharCount * sizeof(char), charCount * sizeof(char));
+            allocatedCharCount = charCount;
         }
 
         sourceCode[nextCharInd++] = currentChar;
@@ -2,12 +2,20 @@
 #define __SOURCE_CODE_H__
 
 #include <stdio.h>
+#include "arena.h"
 
 /**
  * Reads the source code from file until EOF to a null-terminated string.
  * */
 char* readSourceCode(FILE*);
 
+/**
+ * Same as readSourceCode(), allocating the string in the given arena, see
+ * .. arena.h. The string is released with the arena, it must not be passed
+ * .. to deleteSourceCode().
+ * */
+char* readSourceCodeInArena(FILE*, Arena*);
+
 /**
  * Prints the source code - simply prints a string.
  * */
@@ -0,0 +1,139 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "stats.h"
+
+/**
+ * Returns the nanoseconds of the monotonic clock
+ * */
+long long getStatNanos()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return now.tv_sec * 1000000000LL + now.tv_nsec;
+}
+
+/**
+ * Returns the stat of the given name, creating it if there is no such stat
+ * */
+Stat* getStat(Stats* stats, const char* name, StatType type, const char* help)
+{
+    for(int i = 0; i < stats->numberOfStats; i++)
+    {
+        if(!strcmp(stats->stats[i].name, name))
+            return &stats->stats[i];
+    }
+
+    stats->numberOfStats++;
+    stats->stats = (Stat*)realloc(stats->stats, stats->numberOfStats * sizeof(Stat));
+
+    Stat* stat = &stats->stats[stats->numberOfStats - 1];
+    memset(stat->name, 0, sizeof(stat->name));
+    strncpy(stat->name, name, sizeof(stat->name) - 1);
+    stat->help = help;
+    stat->type = type;
+    stat->value = 0;
+    stat->start = -1;
+
+    return stat;
+}
+
+void initStats(Stats* stats, const char* prefix)
+{
+    stats->prefix = prefix;
+    stats->stats = NULL;
+    stats->numberOfStats = 0;
+}
+
+void deleteStats(Stats* stats)
+{
+    if(!stats) return;
+
+    free(stats->stats);
+
+    stats->stats = NULL;
+    stats->numberOfStats = 0;
+}
+
+void addStatCount(Stats* stats, const char* name, const char* help, long long n)
+{
+    if(!stats) return;
+
+    getStat(stats, name, STAT_COUNTER, help)->value += n;
+}
+
+void setStatGauge(Stats* stats, const char* name, const char* help, long long value)
+{
+    if(!stats) return;
+
+    getStat(stats, name, STAT_GAUGE, help)->value = value;
+}
+
+void setStatMax(Stats* stats, const char* name, const char* help, long long value)
+{
+    if(!stats) return;
+
+    Stat* stat = getStat(stats, name, STAT_GAUGE, help);
+
+    if(value > stat->value) stat->value = value;
+}
+
+void startStatTimer(Stats* stats, const char* name, const char* help)
+{
+    if(!stats) return;
+
+    getStat(stats, name, STAT_TIMER, help)->start = getStatNanos();
+}
+
+void stopStatTimer(Stats* stats, const char* name)
+{
+    if(!stats) return;
+
+    Stat* stat = getStat(stats, name, STAT_TIMER, NULL);
+
+    if(stat->start >= 0)
+    {
+        stat->value += getStatNanos() - stat->start;
+        stat->start = -1;
+    }
+}
+
+int getStatsFormat(const char* name)
+{
+    if(!strcmp(name, "json"))       return STATS_JSON;
+    if(!strcmp(name, "prometheus")) return STATS_PROMETHEUS;
+
+    return -1;
+}
+
+void printStats(Stats* stats, int format, FILE* out)
+{
+    if(format == STATS_JSON) fprintf(out, "{");
+
+    for(int i = 0; i < stats->numberOfStats; i++)
+    {
+        Stat* stat = &stats->stats[i];
+        const char* suffix = stat->type == STAT_TIMER ? "_seconds" : "";
+
+        if(format == STATS_JSON)
+        {
+            fprintf(out, "%s\n  \"%s%s\": ", i ? "," : "", stat->name, suffix);
+
+            if(stat->type == STAT_TIMER) fprintf(out, "%.9f", stat->value / 1e9);
+            else                         fprintf(out, "%lld", stat->value);
+        }
+        else
+        {
+            if(stat->help) fprintf(out, "# HELP %s%s%s %s\n", stats->prefix, stat->name, suffix, stat->help);
+            fprintf(out, "# TYPE %s%s%s %s\n", stats->prefix, stat->name, suffix, stat->type == STAT_COUNTER ? "counter" : "gauge");
+
+            if(stat->type == STAT_TIMER) fprintf(out, "%s%s%s %.9f\n", stats->prefix, stat->name, suffix, stat->value / 1e9);
+            else                         fprintf(out, "%s%s%s %lld\n", stats->prefix, stat->name, suffix, stat->value);
+        }
+    }
+
+    if(format == STATS_JSON) fprintf(out, "\n}\n");
+}
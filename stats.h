@@ -0,0 +1,95 @@
+#ifndef __STATS_H__
+#define __STATS_H__
+
+#include <stdio.h>
+
+/**
+ * Instrumentation of the compiler and the virtual machine: named counters,
+ * .. gauges and timers, dumped as JSON or in the Prometheus text format.
+ *
+ * The metrics are looked up by name, so they are meant to be updated once
+ * .. per phase. The hot loops count in their own variables and add the
+ * .. totals at the end of the phase. The functions updating the metrics do
+ * .. nothing if the stats is NULL, so that instrumentation can be disabled.
+ * */
+
+typedef enum {
+    STAT_COUNTER, // a total, only increased
+    STAT_GAUGE,   // a value, such as a maximum
+    STAT_TIMER    // the monotonic time spent in a phase, in nanoseconds
+} StatType;
+
+typedef struct {
+    char name[64];
+    const char* help;
+    StatType type;
+    long long value;
+
+    /**
+     * Start time of a running timer, -1 if not running.
+     * */
+    long long start;
+} Stat;
+
+typedef struct {
+    /**
+     * Prefix of the metric names in the Prometheus format.
+     * */
+    const char* prefix;
+
+    Stat* stats;
+    int numberOfStats;
+} Stats;
+
+/**
+ * Output formats of printStats()
+ * */
+enum {
+    STATS_JSON,
+    STATS_PROMETHEUS
+};
+
+/**
+ * Initializes the given stats to an empty one. The prefix should outlive it.
+ * */
+void initStats(Stats*, const char* prefix);
+
+/**
+ * Makes the necessary deallocations on the stats.
+ * */
+void deleteStats(Stats*);
+
+/**
+ * Adds n to the counter of the given name, creating it with the given help
+ * .. text if required.
+ * */
+void addStatCount(Stats*, const char* name, const char* help, long long n);
+
+/**
+ * Sets the gauge of the given name to value, or to the maximum of its value
+ * .. and value for setStatMax().
+ * */
+void setStatGauge(Stats*, const char* name, const char* help, long long value);
+void setStatMax(Stats*, const char* name, const char* help, long long value);
+
+/**
+ * Starts and stops the timer of the given name. The time between the two is
+ * .. added to the timer, so that a phase run many times is timed in total.
+ * */
+void startStatTimer(Stats*, const char* name, const char* help);
+void stopStatTimer(Stats*, const char* name);
+
+/**
+ * Returns the format of the given name, "json" or "prometheus", -1 if it is
+ * .. not a format.
+ * */
+int getStatsFormat(const char* name);
+
+/**
+ * Prints the metrics in the order they were created, in the given format.
+ * The timers are in seconds, and their names are printed with a "_seconds"
+ * .. suffix. In the Prometheus format, the names are prefixed.
+ * */
+void printStats(Stats*, int format, FILE*);
+
+#endif
@@ -3,33 +3,57 @@
 #include <string.h>
 
 void initSymbolTable(SymbolTable* symbolTable)
+{
+    initSymbolTableInArena(symbolTable, NULL);
+}
+
+void initSymbolTableInArena(SymbolTable* symbolTable, Arena* arena)
 {
     symbolTable->symbols = NULL;
     symbolTable->numberOfSymbols = 0;
+    symbolTable->capacity = 0;
+    symbolTable->arena = arena;
+    symbolTable->numberOfLookups = 0;
+    symbolTable->numberOfProbes = 0;
 }
 
 void deleteSymbolTable(SymbolTable* symbolTable)
 {
     if(!symbolTable) return;
 
-    if(symbolTable->symbols)
-        free(symbolTable->symbols);
+    // In an arena, the symbols are released with the arena
+    for(int i = 0; i < symbolTable->numberOfSymbols; i++)
+        arenaFree(symbolTable->arena, symbolTable->symbols[i]);
+
+    arenaFree(symbolTable->arena, symbolTable->symbols);
 
     symbolTable->symbols = NULL;
     symbolTable->numberOfSymbols = 0;
+    symbolTable->capacity = 0;
 }
 
 Symbol* addSymbol(SymbolTable* symbolTable, Symbol symbol)
 {
     if(!symbolTable) return NULL;
 
+    // Double the list when it is full
+    if(symbolTable->numberOfSymbols == symbolTable->capacity)
+    {
+        int capacity = symbolTable->capacity ? 2 * symbolTable->capacity : 32;
+
+        symbolTable->symbols = (Symbol**)arenaRealloc(symbolTable->arena, symbolTable->symbols,
+            symbolTable->capacity * sizeof(Symbol*), capacity * sizeof(Symbol*));
+        symbolTable->capacity = capacity;
+    }
+
     symbolTable->numberOfSymbols++;
 
-    symbolTable->symbols = (Symbol*)realloc(symbolTable->symbols, (symbolTable->numberOfSymbols) * sizeof(Symbol));
+    Symbol* copy = (Symbol*)arenaAlloc(symbolTable->arena, sizeof(Symbol));
+    *copy = symbol;
 
-    symbolTable->symbols[symbolTable->numberOfSymbols - 1] = symbol;
+    symbolTable->symbols[symbolTable->numberOfSymbols - 1] = copy;
 
-    return &symbolTable->symbols[symbolTable->numberOfSymbols - 1];
+    return copy;
 }
 
 void printSymbolTable(SymbolTable* symbolTable, FILE* out)
@@ -42,7 +66,7 @@ void printSymbolTable(SymbolTable* symbolTable, FILE* out)
     {
         fprintf(out, "#%d\n", i);
 
-        Symbol* symbol = &(symbolTable->symbols[i]);
+        Symbol* symbol = symbolTable->symbols[i];
 
         switch(symbol->type)
         {
@@ -88,18 +112,23 @@ Symbol* findSymbol(SymbolTable* symbolTable, Symbol* scope, const char* symbolNa
 {
     if(!symbolTable || !symbolName) return NULL;
 
+    symbolTable->numberOfLookups++;
+
     // Search from the most inner scope to global scope
     while(1)
     {
         // Search the current scope
         for(int i = 0; i < symbolTable->numberOfSymbols; i++)
         {
-            if( symbolTable->symbols[i].scope == scope && !strcmp(symbolTable->symbols[i].name, symbolName) )
+            if( symbolTable->symbols[i]->scope == scope && !strcmp(symbolTable->symbols[i]->name, symbolName) )
             {
-                return &symbolTable->symbols[i];
+                symbolTable->numberOfProbes += i + 1;
+                return symbolTable->symbols[i];
             }
         }
 
+        symbolTable->numberOfProbes += symbolTable->numberOfSymbols;
+
         if(!scope)
         {
             /**
@@ -2,6 +2,7 @@
 #define __SYMBOL_H__
 
 #include <stdio.h>
+#include "arena.h"
 
 /**
  * There are three possible types of symbols that can be an entry of a symbol table
@@ -37,10 +38,25 @@ struct Symbol {
 
 /**
  * Symbol table.
+ * Each symbol is allocated separately, so that the pointers to the symbols,
+ * .. such as the scope field of Symbol, stay valid as the table grows.
  * */
 typedef struct {
-    Symbol* symbols;
+    Symbol** symbols;
     int numberOfSymbols;
+
+    /**
+     * Number of the symbols the list is allocated for, and the arena the
+     * .. symbols are allocated in, NULL if they are on the heap.
+     * */
+    int capacity;
+    Arena* arena;
+
+    /**
+     * Number of findSymbol() calls, and of the symbols compared by them.
+     * */
+    long long numberOfLookups;
+    long long numberOfProbes;
 } SymbolTable;
 
 /**
@@ -48,6 +64,12 @@ typedef struct {
  * */
 void initSymbolTable(SymbolTable*);
 
+/**
+ * Initializes the given symbol table to allocate its symbols in the given
+ * .. arena, see arena.h. They are released with the arena.
+ * */
+void initSymbolTableInArena(SymbolTable*, Arena*);
+
 /**
  * Destructs the symbol table by making necessary deallocations on the members
  * of the symbol table struct.
@@ -56,6 +78,8 @@ void deleteSymbolTable(SymbolTable*);
 
 /**
  * Appends a copy of the given symbol to the given symbol table.
+ * Returns the pointer to the copy, which is valid until the symbol table is
+ * .. deleted.
  * */
 Symbol* addSymbol(SymbolTable*, Symbol);
 
@@ -0,0 +1,150 @@
+tests="tests.txt"
+cg="../code_generator.out"
+aot="../aot.out"
+vm="../vm/vm.out"
+EMPH='\033[1;31m'
+GREEN_EMPH='\033[1;32m'
+DEEMPH='\033[0m'
+timeout=1s
+
+# The code is optimized, which grader.sh, at the default -O0, does not check
+cg_flags="-O2"
+
+# The programs of verifier_tests.txt that the vm stops, run to check that the
+#   executable stops the same way, and their exit statuses, see vm/vm.h
+failing_tests="verifier_tests.txt"
+stack_overflow_status=6
+division_error_status=7
+
+i=0
+passed=0
+failed=0
+
+# check if cg.out, aot.out, vm.out, tests.txt and verifier_tests.txt exists
+if [[ -e $cg && -e $aot && -e $vm && -e $tests && -e $failing_tests ]] ; then
+    echo "$cg, $aot, $vm, $tests and $failing_tests are found. Starting tests.."
+else
+    echo "$cg, $aot, $vm, $tests or $failing_tests could not be found! Aborting.."
+    exit
+fi
+
+# Same tests as grader.sh, except that the pm0 code is compiled ahead of time
+#   to C and run natively instead of on the vm. Error cases produce no code,
+#   so they are skipped.
+# aot_c  : C translation of cg_out.
+# aot_exe: Native executable compiled from aot_c.
+while read is_err cg_in cg_out others; do
+    if [ "$is_err" != "not_error" ]; then
+      continue
+    fi
+
+    echo -e "${GREEN_EMPH}TEST[$i]${DEEMPH}"
+
+    # resolve other filenames
+    others_array=($others)
+    vm_inp=${others_array[0]}
+    vm_out=${others_array[1]}
+    gt_vm_out=${others_array[2]}
+
+    out_dir=$(dirname "$cg_out")
+    mkdir -p "$out_dir"
+    aot_c="$out_dir/aot.c"
+    aot_exe="$out_dir/aot.exe"
+    aot_out="$out_dir/aot_out.txt"
+
+    # run the code generator, the translator and the executable
+    (timeout $timeout "$cg" $cg_flags "$cg_in" "$cg_out") > /dev/null 2>&1
+    ("$aot" "$cg_out" "$aot_c" "$aot_exe") > /dev/null 2>&1
+    (timeout $timeout "$aot_exe" < "$vm_inp" > "$aot_out") 2>/dev/null
+
+    # check if the output matches the expected vm_out
+    _diff=$( { diff -B -w $aot_out $gt_vm_out; } 2>&1 )
+
+    if [[ $_diff ]] ; then
+        echo "TEST $i FAILED"
+        let failed=$failed+1
+
+        echo "There is difference between $aot_out and $gt_vm_out:"
+        echo "=================================================================="
+        echo $_diff
+        echo "=================================================================="
+        echo -e "${EMPH}Test this yourself by running the following${DEEMPH}: "
+        echo "  (cd test/; ./$cg $cg_flags $cg_in $cg_out)"
+        echo "  (cd test/; ./$aot $cg_out $aot_c $aot_exe)"
+        echo "  (cd test/; ./$aot_exe < $vm_inp > $aot_out)"
+        echo "The output is in \"test/$aot_out\". It was expected to match \"test/$gt_vm_out\"."
+        echo ""
+    else
+        echo "TEST $i PASSED"
+        let passed=$passed+1
+    fi
+    let i=$i+1
+
+done < "$tests"
+
+# The stack_overflow and division tests of verifier_tests.txt. The executable
+#   should write the same output as the vm up to the point the vm stops, and
+#   stop with the same exit status and reason.
+# vm_out : Output of vm, which stops before the program halts.
+# aot_err: stderr of the executable, whose first line should match gt_vm_err.
+while read kind cg_in vm_inp gt_vm_err; do
+    if [ "$kind" = "stack_overflow" ]; then
+      expected_status=$stack_overflow_status
+    elif [ "$kind" = "division" ]; then
+      expected_status=$division_error_status
+    else
+      continue
+    fi
+
+    echo -e "${GREEN_EMPH}TEST[$i]${DEEMPH}"
+
+    out_dir="io/your_outputs/aot/$i"
+    mkdir -p "$out_dir"
+    cg_out="$out_dir/cg_out.txt"
+    vm_out="$out_dir/vm_out.txt"
+    aot_c="$out_dir/aot.c"
+    aot_exe="$out_dir/aot.exe"
+    aot_out="$out_dir/aot_out.txt"
+    aot_err="$out_dir/aot_err.txt"
+
+    # run the code generator, the vm, the translator and the executable
+    (timeout $timeout "$cg" $cg_flags "$cg_in" "$cg_out") > /dev/null 2>&1
+    (timeout $timeout "$vm" "$cg_out" "/dev/null" "$vm_inp" "$vm_out") > /dev/null 2>&1
+    ("$aot" "$cg_out" "$aot_c" "$aot_exe") > /dev/null 2>&1
+    (timeout $timeout "$aot_exe" < "$vm_inp" > "$aot_out") 2> "$aot_err"
+    status=$?
+
+    # check the exit status, the reason reported and the output
+    _diff=""
+    if [ $status -ne $expected_status ]; then
+      _diff="exit status $status, expected $expected_status."
+    fi
+    _diff="$_diff$( { head -n 1 "$aot_err" | diff -B -w - $gt_vm_err; cmp $aot_out $vm_out; } 2>&1 )"
+
+    if [[ $_diff ]] ; then
+        echo "TEST $i FAILED"
+        let failed=$failed+1
+
+        echo "The executable did not stop as the vm does on $cg_in:"
+        echo "=================================================================="
+        echo $_diff
+        echo "=================================================================="
+        echo -e "${EMPH}Test this yourself by running the following${DEEMPH}: "
+        echo "  (cd test/; ./$cg $cg_flags $cg_in $cg_out)"
+        echo "  (cd test/; ./$vm $cg_out /dev/null $vm_inp $vm_out)"
+        echo "  (cd test/; ./$aot $cg_out $aot_c $aot_exe)"
+        echo "  (cd test/; ./$aot_exe < $vm_inp > $aot_out)"
+        echo "The output is in \"test/$aot_out\". It was expected to match \"test/$vm_out\", and the first"
+        echo "line of the stderr of the executable to match \"test/$gt_vm_err\"."
+        echo ""
+    else
+        echo "TEST $i PASSED"
+        let passed=$passed+1
+    fi
+    let i=$i+1
+
+done < "$failing_tests"
+
+echo "# of tests       : $i"
+echo "# of tests passed: $passed"
+echo "# of tests failed: $failed"
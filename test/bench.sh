@@ -0,0 +1,36 @@
+bench="../bench/bench.out"
+gen="../bench/pl0_gen.out"
+bench_dir="io/your_outputs/bench"
+runs=20
+
+# check if the benchmark binaries exist
+if [[ -e $bench && -e $gen ]] ; then
+    echo "$bench is found. Starting benchmark.."
+else
+    echo "$bench or $gen could not be found! Aborting.."
+    exit
+fi
+
+mkdir -p "$bench_dir"
+
+# Workloads: the kind of program and its size, see pl0_gen.out
+workloads=(
+    "nesting 30"
+    "expressions 150"
+    "declarations 1500"
+    "loops 20000"
+    "output 20000"
+)
+
+programs=()
+for workload in "${workloads[@]}"; do
+    set -- $workload
+    program="$bench_dir/$1_$2.pl0"
+
+    "$gen" $1 $2 > "$program"
+    programs+=("$program")
+done
+
+"$bench" -r $runs -o "$bench_dir/results.json" "${programs[@]}"
+
+echo "Results are written to $bench_dir/results.json"
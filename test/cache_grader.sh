@@ -0,0 +1,113 @@
+tests="tests.txt"
+cg="../code_generator.out"
+EMPH='\033[1;31m'
+GREEN_EMPH='\033[1;32m'
+DEEMPH='\033[0m'
+timeout=1s
+
+# Each case is compiled to text and to an object, at the default -O0 and at
+#   -O2, all sharing the cache directory of the case
+formats=("" "-b")
+levels=("-O0" "-O2")
+
+i=0
+passed=0
+failed=0
+
+# check if cg.out and tests.txt exists
+if [[ -e $cg && -e $tests ]] ; then
+    echo "$cg and $tests are found. Starting tests.."
+else
+    echo "$cg or $tests could not be found! Aborting.."
+    exit
+fi
+
+# Inserts "; begin end" before the "end" of the main block, which is the one
+#   before the final period, keeping the position of the "end" - if any.
+edit_main_block() {
+    awk '{ lines[NR] = $0; ids[NR] = $1 }
+    END {
+        for(i = 1; i <= NR; i++) {
+            if(i == NR - 1 && ids[i] == 22 && ids[i + 1] == 19) {
+                pos = lines[i]; sub(/^ *22 +end/, "", pos)
+                printf "%10s %14s%s\n%10s %14s%s\n%10s %14s%s\n", 18, ";", pos, 21, "begin", pos, 22, "end", pos
+            }
+            print lines[i]
+        }
+    }' "$1"
+}
+
+# Same cases as grader.sh, compiled with the on-disk cache of -c: cold, when
+#   the cache is empty, warm, when the output itself is cached, and after the
+#   main block is edited, when the code of the unchanged procedures is reused
+#   from the cache. Each output should be byte-identical to the output of the
+#   code generator without the cache, for the same input and options.
+# cg_flags  : Options of the code generator given in an error case.
+# cache_dir : Cache directory shared by the compilations of the case.
+# edited_in : cg_in with the main block edited.
+# ref_out   : Output of the code generator without the cache.
+# cached_out: Output of the code generator with the cache.
+while read is_err cg_in cg_out others; do
+    echo -e "${GREEN_EMPH}TEST[$i]${DEEMPH}"
+
+    cg_flags=""
+    if [ "$is_err" = "error" ]; then
+      others_array=($others)
+      cg_flags=${others_array[@]:1}
+    fi
+
+    out_dir="$(dirname "$cg_out")/cache"
+    cache_dir="$out_dir/dir"
+    edited_in="$out_dir/edited_in.txt"
+    ref_out="$out_dir/ref_out"
+    cached_out="$out_dir/cached_out"
+    rm -rf "$out_dir"
+    mkdir -p "$out_dir"
+
+    edit_main_block "$cg_in" > "$edited_in"
+
+    _diff=""
+    for format in "${formats[@]}"; do
+      for level in "${levels[@]}"; do
+        flags="$cg_flags $format $level"
+
+        for run in cold warm edited; do
+          inp="$cg_in"
+          if [ "$run" = "edited" ]; then inp="$edited_in"; fi
+
+          (timeout $timeout "$cg" $flags "$inp" "$ref_out") > /dev/null 2>&1
+          (timeout $timeout "$cg" -c "$cache_dir" $flags "$inp" "$cached_out") > /dev/null 2>&1
+
+          if ! cmp -s "$cached_out" "$ref_out"; then
+            _diff="$_diff $run run with$flags differs from the run without the cache."
+            failed_flags="$flags"
+            failed_inp="$inp"
+          fi
+        done
+      done
+    done
+
+    if [[ $_diff ]] ; then
+        echo "TEST $i FAILED"
+        let failed=$failed+1
+
+        echo "The cached output of $cg_in is not the output without the cache:"
+        echo "=================================================================="
+        echo $_diff
+        echo "=================================================================="
+        echo -e "${EMPH}Test this yourself by running the following${DEEMPH}: "
+        echo "  (cd test/; ./$cg $failed_flags $failed_inp $ref_out)"
+        echo "  (cd test/; ./$cg -c $cache_dir $failed_flags $failed_inp $cached_out)"
+        echo "The cache is in \"test/$cache_dir\", and \"test/$cached_out\" was expected to match \"test/$ref_out\"."
+        echo ""
+    else
+        echo "TEST $i PASSED"
+        let passed=$passed+1
+    fi
+    let i=$i+1
+
+done < "$tests"
+
+echo "# of tests       : $i"
+echo "# of tests passed: $passed"
+echo "# of tests failed: $failed"
@@ -0,0 +1,54 @@
+vm="../vm/vm.out"
+bench_dir="io/your_outputs/bench"
+instructions=2000000
+runs=3
+
+# check if vm.out exists
+if [[ -e $vm ]] ; then
+    echo "$vm is found. Starting benchmark.."
+else
+    echo "$vm could not be found! Aborting.."
+    exit
+fi
+
+mkdir -p "$bench_dir"
+code="$bench_dir/code_layout.txt"
+
+# A loop filling the code memory: arithmetic on the registers, loads and
+#   stores, and a jump back to the start.
+awk 'BEGIN {
+    print "6 0 0 8"
+    print "1 1 0 3"
+    print "1 2 0 7"
+    for(i = 3; i < 497; i += 4) {
+        print "13 3 1 2"
+        print "4 3 0 4"
+        print "3 1 0 4"
+        print "15 2 2 1"
+    }
+    print "7 0 0 1"
+}' > "$code"
+
+# Runs the vm on the code with the given options, for the instruction budget.
+#   Prints the best wall-clock time of the runs in milliseconds.
+bench() {
+    best=0
+    for ((run = 0; run < runs; run++)); do
+        start=$(date +%s%N)
+        "$vm" "$@" -i $instructions "$code" /dev/null /dev/null /dev/null 2> /dev/null
+        end=$(date +%s%N)
+
+        elapsed=$(( (end - start) / 1000000 ))
+        if (( best == 0 || elapsed < best )); then
+            best=$elapsed
+        fi
+    done
+    echo $best
+}
+
+packed=$(bench)
+unpacked=$(bench -u)
+
+echo "# of instructions      : $instructions"
+echo "packed code memory     : $packed ms"
+echo "unpacked code memory   : $unpacked ms"
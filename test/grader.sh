@@ -5,6 +5,7 @@ EMPH='\033[1;31m'
 GREEN_EMPH='\033[1;32m'
 DEEMPH='\033[0m'
 timeout=1s
+vm_budget_ms=1000
 
 i=0
 passed=0
@@ -29,17 +30,25 @@ fi
 # vm_out   : Output of vm after running the pm0 code given in cg_out.
 # gt_vm_out: Expected vm_out. Might be /dev/null for some cases where cg_out is
 #            expected to be an error.
+# cg_flags : Options of the code generator, after the expected error of an error
+#            case, such as "-e 0" to report every error instead of the first.
+# gt_cg_out: Expected cg_out, after gt_vm_out - if given, which pins the code
+#            itself, not only what it does.
 while read is_err cg_in cg_out others; do
     echo -e "${GREEN_EMPH}TEST[$i]${DEEMPH}"
     # resolve others depending on whether it is an error case or not
+    cg_flags=""
     if [ "$is_err" = "not_error" ]; then
       # resolve other filenames
       others_array=($others)
       vm_inp=${others_array[0]}
       vm_out=${others_array[1]}
       gt_vm_out=${others_array[2]}
+      gt_cg_out=${others_array[3]}
     elif [ "$is_err" = "error" ]; then
-      gt_cg_out=$others
+      others_array=($others)
+      gt_cg_out=${others_array[0]}
+      cg_flags=${others_array[@]:1}
     else
       echo "ERROR WHILE RUNNING GRADER SCRIPT: error or not_error in $tests?"
       exit 0
@@ -52,7 +61,7 @@ while read is_err cg_in cg_out others; do
     mkdir -p "$out_dir"
     
     # run the code generator
-    (timeout $timeout "$cg" "$cg_in" "$cg_out") > /dev/null 2>&1
+    (timeout $timeout "$cg" $cg_flags "$cg_in" "$cg_out") > /dev/null 2>&1
 
     # if the error case is expected, then, do not run vm but just check the err
     if [ "$is_err" = "error" ]; then
@@ -60,11 +69,17 @@ while read is_err cg_in cg_out others; do
       _diff=$( { diff -B -w $cg_out $gt_cg_out; } 2>&1 )
 
     elif [ "$is_err" = "not_error" ]; then
-      # code should have been produced. therefore, run the vm.
-      (timeout $timeout "$vm" "$cg_out" "/dev/null" "$vm_inp" "$vm_out") > /dev/null 2>&1
+      # code should have been produced. therefore, run the vm. the vm stops
+      #   by itself when the time budget runs out, and reports its state to
+      #   vm_err.
+      vm_err="$(dirname "$vm_out")/vm_err.txt"
+      ("$vm" -t $vm_budget_ms "$cg_out" "/dev/null" "$vm_inp" "$vm_out") > /dev/null 2> "$vm_err"
 
-      # check if the correct vm_out is produced
+      # check if the correct vm_out is produced, and the expected code - if given
       _diff=$( { diff -B -w $vm_out $gt_vm_out; } 2>&1 )
+      if [[ $gt_cg_out ]] ; then
+        _diff="$_diff$( { diff -B -w $cg_out $gt_cg_out; } 2>&1 )"
+      fi
     fi
     
     # up to now, _diff should have been already set up
@@ -81,7 +96,7 @@ while read is_err cg_in cg_out others; do
           echo "=================================================================="
           echo "Your code generator was expected to output an error code for the given input."
           echo -e "${EMPH}Test this yourself by running the following${DEEMPH}: "
-          echo "  (cd test/; ./$cg $cg_in $cg_out)"
+          echo "  (cd test/; ./$cg $cg_flags $cg_in $cg_out)"
           echo "The output is in \"test/$cg_out\". It was expected to match \"test/$gt_cg_out\"."
           echo ""
         elif [ "$is_err" = "not_error" ]; then
@@ -95,6 +110,13 @@ while read is_err cg_in cg_out others; do
           echo "  (cd test/; ./$cg $cg_in $cg_out)"
           echo "  (cd test/; ./$vm $cg_out /dev/null $vm_inp $vm_out) "
           echo "The output is in \"test/$vm_out\". It was expected to match \"test/$gt_vm_out\"."
+          if [[ $gt_cg_out ]] ; then
+            echo "The code in \"test/$cg_out\" was expected to match \"test/$gt_cg_out\"."
+          fi
+          if [[ -s $vm_err ]] ; then
+            echo "The vm reported the following on stderr:"
+            cat "$vm_err"
+          fi
           echo ""
         fi
     else
@@ -0,0 +1,157 @@
+/* PM/0 code compiled ahead of time to C. Do not edit. */
+#include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
+
+static int stack[2000];
+
+/* Base pointer of the activation record L levels down */
+static int base(int bp, int L)
+{
+    while(L > 0) { bp = stack[bp + 1]; L--; }
+    return bp;
+}
+
+static void illegal(int op)
+{
+    fprintf(stderr, "VM cannot execute illegal instruction with op code: %d\n", op);
+    fprintf(stderr, "Terminating VM..\n");
+    exit(-1);
+}
+
+static void badReturn(int pc)
+{
+    fprintf(stderr, "VM cannot return or jump to address %d, which does not follow a CAL\n", pc);
+    fprintf(stderr, "Terminating VM..\n");
+    exit(-1);
+}
+
+/* Stops as the VM does when it cannot go on: with the output written so far */
+static void stop(int status, const char* reason)
+{
+    fflush(stdout);
+    fprintf(stderr, "VM stopped: %s\n", reason);
+    exit(status);
+}
+
+static void stackOverflow(void)
+{
+    stop(6, "stack overflow, more than MAX_STACK_HEIGHT(2000) slots needed");
+}
+
+static void divisionError(void)
+{
+    stop(7, "division by zero, or of INT_MIN by -1");
+}
+
+int main(void)
+{
+    int BP = 1, SP = 0, PC = 0;
+    int r0 = 0, r1 = 0, r2 = 0, r3 = 0, r4 = 0, r5 = 0, r6 = 0, r7 = 0, r8 = 0, r9 = 0, r10 = 0, r11 = 0, r12 = 0, r13 = 0, r14 = 0, r15 = 0;
+
+    goto L0;
+
+dispatch:
+    switch(PC)
+    {
+        default: badReturn(PC);
+    }
+
+L0: if(SP + 4 >= 2000) stackOverflow(); SP += 4;
+L1: if(SP + 4 >= 2000) stackOverflow(); SP += 4;
+L2: goto L3;
+L3: r0 = 37;
+L4: stack[BP + 4] = r0;
+L5: r0 = -45;
+L6: stack[BP + 5] = r0;
+L7: r0 = stack[BP + 4];
+L8: stack[BP + 6] = r0;
+L9: r0 = stack[BP + 6];
+L10: printf("%d ", r0);
+L11: r0 = stack[BP + 4];
+L12: r1 = stack[BP + 5];
+L13: r0 = (int)((unsigned int)r0 + (unsigned int)r1);
+L14: r1 = 6;
+L15: r0 = (int)((unsigned int)r0 + (unsigned int)r1);
+L16: stack[BP + 6] = r0;
+L17: r0 = stack[BP + 6];
+L18: printf("%d ", r0);
+L19: r0 = stack[BP + 4];
+L20: r1 = stack[BP + 5];
+L21: r0 = (int)((unsigned int)r0 * (unsigned int)r1);
+L22: r0 = (int)((unsigned int)r0 << 3);
+L23: stack[BP + 6] = r0;
+L24: r0 = stack[BP + 6];
+L25: printf("%d ", r0);
+L26: r0 = stack[BP + 4];
+L27: r0 = (int)(r0 / 8LL);
+L28: r1 = stack[BP + 5];
+L29: r1 = (int)(r1 / 8LL);
+L30: r0 = (int)((unsigned int)r0 + (unsigned int)r1);
+L31: stack[BP + 6] = r0;
+L32: r0 = stack[BP + 6];
+L33: printf("%d ", r0);
+L34: r0 = stack[BP + 5];
+L35: r0 = (int)(r0 / 16LL);
+L36: r1 = stack[BP + 5];
+L37: r1 = (int)((unsigned int)r1 << 3);
+L38: r0 = (int)((unsigned int)r0 - (unsigned int)r1);
+L39: r1 = stack[BP + 4];
+L40: r1 = (int)(r1 / 1024LL);
+L41: r0 = (int)((unsigned int)r0 + (unsigned int)r1);
+L42: stack[BP + 6] = r0;
+L43: r0 = stack[BP + 6];
+L44: printf("%d ", r0);
+L45: r0 = stack[BP + 4];
+L46: r0 = (int)((unsigned int)r0 << 3);
+L47: r1 = stack[BP + 5];
+L48: r1 = (int)(r1 / 2LL);
+L49: r0 = (int)((unsigned int)r0 - (unsigned int)r1);
+L50: r1 = 7;
+L51: r0 = (int)((unsigned int)r0 + (unsigned int)r1);
+L52: stack[BP + 6] = r0;
+L53: r0 = stack[BP + 6];
+L54: printf("%d ", r0);
+L55: r0 = stack[BP + 4];
+L56: r1 = stack[BP + 5];
+L57: r2 = 1;
+L58: r1 = (int)((unsigned int)r1 - (unsigned int)r2);
+L59: r0 = (int)((unsigned int)r0 - (unsigned int)r1);
+L60: r1 = 4;
+L61: r0 = (int)((unsigned int)r0 - (unsigned int)r1);
+L62: stack[BP + 6] = r0;
+L63: r0 = stack[BP + 6];
+L64: printf("%d ", r0);
+L65: r0 = 0;
+L66: stack[BP + 7] = r0;
+L67: r0 = 0;
+L68: stack[BP + 6] = r0;
+L69: r0 = stack[BP + 7];
+L70: r1 = 10;
+L71: if(r0 >= r1) goto L89;
+L72: r3 = stack[BP + 5];
+L73: r4 = 1;
+L74: r3 = (int)((unsigned int)r3 - (unsigned int)r4);
+L75: r3 = (int)(r3 / 2LL);
+L76: r4 = 1;
+L77: r5 = 10;
+L78: r0 = stack[BP + 6];
+L79: r1 = stack[BP + 7];
+L80: r1 = (int)((unsigned int)r1 << 2);
+L81: r0 = (int)((unsigned int)r0 + (unsigned int)r1);
+L82: r0 = (int)((unsigned int)r0 - (unsigned int)r3);
+L83: stack[BP + 6] = r0;
+L84: r0 = stack[BP + 7];
+L85: r0 = (int)((unsigned int)r0 + (unsigned int)r4);
+L86: stack[BP + 7] = r0;
+L87: r0 = stack[BP + 7];
+L88: if(r0 < r5) goto L78;
+L89: r0 = stack[BP + 6];
+L90: printf("%d ", r0);
+L91: SP = BP - 1; BP = stack[SP + 3]; PC = stack[SP + 4]; if(!PC && !BP && !SP) goto halt; goto dispatch;
+L92: goto halt;
+    PC = 93; goto dispatch;
+
+halt:
+    return 0;
+}
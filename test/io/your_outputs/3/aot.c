@@ -0,0 +1,96 @@
+/* PM/0 code compiled ahead of time to C. Do not edit. */
+#include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
+
+static int stack[2000];
+
+/* Base pointer of the activation record L levels down */
+static int base(int bp, int L)
+{
+    while(L > 0) { bp = stack[bp + 1]; L--; }
+    return bp;
+}
+
+static void illegal(int op)
+{
+    fprintf(stderr, "VM cannot execute illegal instruction with op code: %d\n", op);
+    fprintf(stderr, "Terminating VM..\n");
+    exit(-1);
+}
+
+static void badReturn(int pc)
+{
+    fprintf(stderr, "VM cannot return or jump to address %d, which does not follow a CAL\n", pc);
+    fprintf(stderr, "Terminating VM..\n");
+    exit(-1);
+}
+
+/* Stops as the VM does when it cannot go on: with the output written so far */
+static void stop(int status, const char* reason)
+{
+    fflush(stdout);
+    fprintf(stderr, "VM stopped: %s\n", reason);
+    exit(status);
+}
+
+static void stackOverflow(void)
+{
+    stop(6, "stack overflow, more than MAX_STACK_HEIGHT(2000) slots needed");
+}
+
+static void divisionError(void)
+{
+    stop(7, "division by zero, or of INT_MIN by -1");
+}
+
+int main(void)
+{
+    int BP = 1, SP = 0, PC = 0;
+    int r0 = 0, r1 = 0, r2 = 0, r3 = 0, r4 = 0, r5 = 0, r6 = 0, r7 = 0, r8 = 0, r9 = 0, r10 = 0, r11 = 0, r12 = 0, r13 = 0, r14 = 0, r15 = 0;
+
+    goto L0;
+
+dispatch:
+    switch(PC)
+    {
+        default: badReturn(PC);
+    }
+
+L0: if(SP + 4 >= 2000) stackOverflow(); SP += 4;
+L1: goto L2;
+L2: r0 = -1;
+L3: r1 = -1;
+L4: if(r0 != r1) goto L7;
+L5: r0 = 1;
+L6: printf("%d ", r0);
+L7: r0 = 2;
+L8: r1 = 2;
+L9: if(r0 == r1) goto L13;
+L10: r0 = 2;
+L11: printf("%d ", r0);
+L12: goto L15;
+L13: r0 = 3;
+L14: printf("%d ", r0);
+L15: r0 = 3;
+L16: r1 = 2;
+L17: if(r0 < r1) goto L20;
+L18: r0 = 4;
+L19: printf("%d ", r0);
+L20: r0 = 3;
+L21: r1 = 3;
+L22: if(r0 != r1) goto L25;
+L23: r0 = 5;
+L24: printf("%d ", r0);
+L25: r0 = 9;
+L26: r1 = 3;
+L27: if(r0 != r1) goto L30;
+L28: r0 = 6;
+L29: printf("%d ", r0);
+L30: SP = BP - 1; BP = stack[SP + 3]; PC = stack[SP + 4]; if(!PC && !BP && !SP) goto halt; goto dispatch;
+L31: goto halt;
+    PC = 32; goto dispatch;
+
+halt:
+    return 0;
+}
@@ -0,0 +1,99 @@
+/* PM/0 code compiled ahead of time to C. Do not edit. */
+#include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
+
+static int stack[2000];
+
+/* Base pointer of the activation record L levels down */
+static int base(int bp, int L)
+{
+    while(L > 0) { bp = stack[bp + 1]; L--; }
+    return bp;
+}
+
+static void illegal(int op)
+{
+    fprintf(stderr, "VM cannot execute illegal instruction with op code: %d\n", op);
+    fprintf(stderr, "Terminating VM..\n");
+    exit(-1);
+}
+
+static void badReturn(int pc)
+{
+    fprintf(stderr, "VM cannot return or jump to address %d, which does not follow a CAL\n", pc);
+    fprintf(stderr, "Terminating VM..\n");
+    exit(-1);
+}
+
+/* Stops as the VM does when it cannot go on: with the output written so far */
+static void stop(int status, const char* reason)
+{
+    fflush(stdout);
+    fprintf(stderr, "VM stopped: %s\n", reason);
+    exit(status);
+}
+
+static void stackOverflow(void)
+{
+    stop(6, "stack overflow, more than MAX_STACK_HEIGHT(2000) slots needed");
+}
+
+static void divisionError(void)
+{
+    stop(7, "division by zero, or of INT_MIN by -1");
+}
+
+int main(void)
+{
+    int BP = 1, SP = 0, PC = 0;
+    int r0 = 0, r1 = 0, r2 = 0, r3 = 0, r4 = 0, r5 = 0, r6 = 0, r7 = 0, r8 = 0, r9 = 0, r10 = 0, r11 = 0, r12 = 0, r13 = 0, r14 = 0, r15 = 0;
+
+    goto L0;
+
+dispatch:
+    switch(PC)
+    {
+        default: badReturn(PC);
+    }
+
+L0: if(SP + 4 >= 2000) stackOverflow(); SP += 4;
+L1: if(SP + 1 >= 2000) stackOverflow(); SP += 1;
+L2: goto L3;
+L3: scanf("%d", &r0);
+L4: stack[BP + 4] = r0;
+L5: r0 = stack[BP + 4];
+L6: r1 = 0;
+L7: if(r0 == r1) goto L17;
+L8: r2 = 1;
+L9: r3 = 0;
+L10: r0 = stack[BP + 4];
+L11: printf("%d ", r0);
+L12: r0 = stack[BP + 4];
+L13: r0 = (int)((unsigned int)r0 - (unsigned int)r2);
+L14: stack[BP + 4] = r0;
+L15: r0 = stack[BP + 4];
+L16: if(r0 != r3) goto L10;
+L17: scanf("%d", &r0);
+L18: stack[BP + 4] = r0;
+L19: r0 = stack[BP + 4];
+L20: r1 = 1;
+L21: if(r0 > r1) goto L31;
+L22: r2 = 1;
+L23: r3 = 1;
+L24: r0 = stack[BP + 4];
+L25: r0 = (int)((unsigned int)r0 + (unsigned int)r2);
+L26: stack[BP + 4] = r0;
+L27: r0 = stack[BP + 4];
+L28: printf("%d ", r0);
+L29: r0 = stack[BP + 4];
+L30: if(r0 <= r3) goto L24;
+L31: r0 = stack[BP + 4];
+L32: printf("%d ", r0);
+L33: SP = BP - 1; BP = stack[SP + 3]; PC = stack[SP + 4]; if(!PC && !BP && !SP) goto halt; goto dispatch;
+L34: goto halt;
+    PC = 35; goto dispatch;
+
+halt:
+    return 0;
+}
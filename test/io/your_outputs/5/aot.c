@@ -0,0 +1,97 @@
+/* PM/0 code compiled ahead of time to C. Do not edit. */
+#include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
+
+static int stack[2000];
+
+/* Base pointer of the activation record L levels down */
+static int base(int bp, int L)
+{
+    while(L > 0) { bp = stack[bp + 1]; L--; }
+    return bp;
+}
+
+static void illegal(int op)
+{
+    fprintf(stderr, "VM cannot execute illegal instruction with op code: %d\n", op);
+    fprintf(stderr, "Terminating VM..\n");
+    exit(-1);
+}
+
+static void badReturn(int pc)
+{
+    fprintf(stderr, "VM cannot return or jump to address %d, which does not follow a CAL\n", pc);
+    fprintf(stderr, "Terminating VM..\n");
+    exit(-1);
+}
+
+/* Stops as the VM does when it cannot go on: with the output written so far */
+static void stop(int status, const char* reason)
+{
+    fflush(stdout);
+    fprintf(stderr, "VM stopped: %s\n", reason);
+    exit(status);
+}
+
+static void stackOverflow(void)
+{
+    stop(6, "stack overflow, more than MAX_STACK_HEIGHT(2000) slots needed");
+}
+
+static void divisionError(void)
+{
+    stop(7, "division by zero, or of INT_MIN by -1");
+}
+
+int main(void)
+{
+    int BP = 1, SP = 0, PC = 0;
+    int r0 = 0, r1 = 0, r2 = 0, r3 = 0, r4 = 0, r5 = 0, r6 = 0, r7 = 0, r8 = 0, r9 = 0, r10 = 0, r11 = 0, r12 = 0, r13 = 0, r14 = 0, r15 = 0;
+
+    goto L0;
+
+dispatch:
+    switch(PC)
+    {
+        default: badReturn(PC);
+    }
+
+L0: if(SP + 4 >= 2000) stackOverflow(); SP += 4;
+L1: if(SP + 1 >= 2000) stackOverflow(); SP += 1;
+L2: goto L3;
+L3: r0 = 23;
+L4: stack[BP + 4] = r0;
+L5: r0 = stack[BP + 4];
+L6: printf("%d ", r0);
+L7: r0 = 35;
+L8: stack[BP + 4] = r0;
+L9: r0 = stack[BP + 4];
+L10: printf("%d ", r0);
+L11: r0 = 23;
+L12: stack[BP + 4] = r0;
+L13: r0 = stack[BP + 4];
+L14: printf("%d ", r0);
+L15: r0 = 30;
+L16: stack[BP + 4] = r0;
+L17: r0 = stack[BP + 4];
+L18: printf("%d ", r0);
+L19: r0 = 60;
+L20: stack[BP + 4] = r0;
+L21: r0 = stack[BP + 4];
+L22: printf("%d ", r0);
+L23: r0 = 10;
+L24: stack[BP + 4] = r0;
+L25: r0 = stack[BP + 4];
+L26: printf("%d ", r0);
+L27: r0 = 5;
+L28: stack[BP + 4] = r0;
+L29: r0 = stack[BP + 4];
+L30: printf("%d ", r0);
+L31: SP = BP - 1; BP = stack[SP + 3]; PC = stack[SP + 4]; if(!PC && !BP && !SP) goto halt; goto dispatch;
+L32: goto halt;
+    PC = 33; goto dispatch;
+
+halt:
+    return 0;
+}
@@ -0,0 +1,74 @@
+tests="tests.txt"
+cg="../code_generator.out"
+vm="../vm/vm.out"
+EMPH='\033[1;31m'
+GREEN_EMPH='\033[1;32m'
+DEEMPH='\033[0m'
+timeout=1s
+
+# The code is optimized, which grader.sh, at the default -O0, does not check
+cg_flags="-O2"
+
+i=0
+passed=0
+failed=0
+
+# check if cg.out, vm.out and tests.txt exists
+if [[ -e $cg && -e $vm && -e $tests ]] ; then
+    echo "$cg, $vm and $tests are found. Starting tests.."
+else
+    echo "$cg, $vm or $tests could not be found! Aborting.."
+    exit
+fi
+
+# Same tests as grader.sh, except that the vm runs the pm0 code natively with
+#   its JIT. Error cases produce no code, so they are skipped.
+# jit_out: Output of vm in JIT mode after running the pm0 code given in cg_out.
+while read is_err cg_in cg_out others; do
+    if [ "$is_err" != "not_error" ]; then
+      continue
+    fi
+
+    echo -e "${GREEN_EMPH}TEST[$i]${DEEMPH}"
+
+    # resolve other filenames
+    others_array=($others)
+    vm_inp=${others_array[0]}
+    vm_out=${others_array[1]}
+    gt_vm_out=${others_array[2]}
+
+    out_dir=$(dirname "$cg_out")
+    mkdir -p "$out_dir"
+    jit_out="$out_dir/jit_out.txt"
+
+    # run the code generator and the vm in JIT mode
+    (timeout $timeout "$cg" $cg_flags "$cg_in" "$cg_out") > /dev/null 2>&1
+    (timeout $timeout "$vm" -j "$cg_out" "/dev/null" "$vm_inp" "$jit_out") > /dev/null 2>&1
+
+    # check if the output matches the expected vm_out
+    _diff=$( { diff -B -w $jit_out $gt_vm_out; } 2>&1 )
+
+    if [[ $_diff ]] ; then
+        echo "TEST $i FAILED"
+        let failed=$failed+1
+
+        echo "There is difference between $jit_out and $gt_vm_out:"
+        echo "=================================================================="
+        echo $_diff
+        echo "=================================================================="
+        echo -e "${EMPH}Test this yourself by running the following${DEEMPH}: "
+        echo "  (cd test/; ./$cg $cg_flags $cg_in $cg_out)"
+        echo "  (cd test/; ./$vm -j $cg_out /dev/null $vm_inp $jit_out)"
+        echo "The output is in \"test/$jit_out\". It was expected to match \"test/$gt_vm_out\"."
+        echo ""
+    else
+        echo "TEST $i PASSED"
+        let passed=$passed+1
+    fi
+    let i=$i+1
+
+done < "$tests"
+
+echo "# of tests       : $i"
+echo "# of tests passed: $passed"
+echo "# of tests failed: $failed"
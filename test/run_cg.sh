@@ -24,9 +24,12 @@ fi
 # vm_out   : Output of vm after running the pm0 code given in cg_out.
 # gt_vm_out: Expected vm_out. Might be /dev/null for some cases where cg_out is
 #            expected to be an error.
+# cg_flags : Options of the code generator, after the expected error of an error
+#            case, such as "-e 0" to report every error instead of the first.
 while read is_err cg_in cg_out others; do
     echo "TEST[$i]"
     # resolve others depending on whether it is an error case or not
+    cg_flags=""
     if [ "$is_err" = "not_error" ]; then
       # resolve other filenames
       others_array=($others)
@@ -34,7 +37,9 @@ while read is_err cg_in cg_out others; do
       vm_out=${others_array[1]}
       gt_vm_out=${others_array[2]}
     elif [ "$is_err" = "error" ]; then
-      gt_cg_out=$others
+      others_array=($others)
+      gt_cg_out=${others_array[0]}
+      cg_flags=${others_array[@]:1}
     else
       echo "ERROR WHILE RUNNING TESTER SCRIPT: error or not_error?"
       exit 0
@@ -47,7 +52,7 @@ while read is_err cg_in cg_out others; do
     mkdir -p "$out_dir"
     
     # run the code generator
-    (timeout $timeout "$cg" "$cg_in" "$cg_out") > /dev/null 2>&1
+    (timeout $timeout "$cg" $cg_flags "$cg_in" "$cg_out") > /dev/null 2>&1
     
 
     # if the error case is expected, then, do not run vm
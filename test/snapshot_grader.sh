@@ -0,0 +1,98 @@
+tests="tests.txt"
+cg="../code_generator.out"
+vm="../vm/vm.out"
+EMPH='\033[1;31m'
+GREEN_EMPH='\033[1;32m'
+DEEMPH='\033[0m'
+timeout=1s
+
+# The run is stopped after this many instructions, and resumed from the
+#   snapshot written when it stopped
+budget=50
+budget_exceeded_status=1
+
+i=0
+passed=0
+failed=0
+
+# check if cg.out, vm.out and tests.txt exists
+if [[ -e $cg && -e $vm && -e $tests ]] ; then
+    echo "$cg, $vm and $tests are found. Starting tests.."
+else
+    echo "$cg, $vm or $tests could not be found! Aborting.."
+    exit
+fi
+
+# Same tests as grader.sh, except that the vm is stopped by the instruction
+#   budget and resumed from its snapshot. The output of the resumed run is
+#   expected to be byte-identical to the one of a run that is not stopped.
+#   Error cases produce no code, so they are skipped.
+# full_out    : Output of vm after running the pm0 code without stopping.
+# resumed_out : Output of vm after stopping and resuming the run.
+# snapshot    : Snapshot written by vm when the budget runs out.
+while read is_err cg_in cg_out others; do
+    if [ "$is_err" != "not_error" ]; then
+      continue
+    fi
+
+    echo -e "${GREEN_EMPH}TEST[$i]${DEEMPH}"
+
+    # resolve other filenames
+    others_array=($others)
+    vm_inp=${others_array[0]}
+    vm_out=${others_array[1]}
+    gt_vm_out=${others_array[2]}
+
+    out_dir=$(dirname "$cg_out")
+    mkdir -p "$out_dir"
+    full_out="$out_dir/full_out.txt"
+    resumed_out="$out_dir/resumed_out.txt"
+    snapshot="$out_dir/snapshot.bin"
+    rm -f "$snapshot"
+
+    # run the code generator, the vm without stopping, and the vm stopped by
+    #   the budget. A program that halts within the budget is not resumed.
+    (timeout $timeout "$cg" "$cg_in" "$cg_out") > /dev/null 2>&1
+    (timeout $timeout "$vm" "$cg_out" "/dev/null" "$vm_inp" "$full_out") > /dev/null 2>&1
+    (timeout $timeout "$vm" -i $budget -c "$snapshot" "$cg_out" "/dev/null" "$vm_inp" "$resumed_out") > /dev/null 2>&1
+    status=$?
+
+    if [ $status -eq $budget_exceeded_status ]; then
+      (timeout $timeout "$vm" -r "$snapshot" "$cg_out" "/dev/null" "$vm_inp" "$resumed_out") > /dev/null 2>&1
+      status=$?
+    fi
+
+    # check if the resumed run halted with the same output, which also has to
+    #   match the expected vm_out
+    if [ $status -ne 0 ]; then
+      _diff="vm exited with status $status"
+    else
+      _diff=$( { cmp $resumed_out $full_out && diff -B -w $full_out $gt_vm_out; } 2>&1 )
+    fi
+
+    if [[ $_diff ]] ; then
+        echo "TEST $i FAILED"
+        let failed=$failed+1
+
+        echo "There is difference between $resumed_out, $full_out and $gt_vm_out:"
+        echo "=================================================================="
+        echo $_diff
+        echo "=================================================================="
+        echo -e "${EMPH}Test this yourself by running the following${DEEMPH}: "
+        echo "  (cd test/; ./$cg $cg_in $cg_out)"
+        echo "  (cd test/; ./$vm $cg_out /dev/null $vm_inp $full_out)"
+        echo "  (cd test/; ./$vm -i $budget -c $snapshot $cg_out /dev/null $vm_inp $resumed_out)"
+        echo "  (cd test/; ./$vm -r $snapshot $cg_out /dev/null $vm_inp $resumed_out)"
+        echo "The output is in \"test/$resumed_out\". It was expected to match \"test/$full_out\" and \"test/$gt_vm_out\"."
+        echo ""
+    else
+        echo "TEST $i PASSED"
+        let passed=$passed+1
+    fi
+    let i=$i+1
+
+done < "$tests"
+
+echo "# of tests       : $i"
+echo "# of tests passed: $passed"
+echo "# of tests failed: $failed"
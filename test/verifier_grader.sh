@@ -0,0 +1,131 @@
+tests="verifier_tests.txt"
+cg="../code_generator.out"
+vm="../vm/vm.out"
+runner="../vm/runner.out"
+EMPH='\033[1;31m'
+GREEN_EMPH='\033[1;32m'
+DEEMPH='\033[0m'
+timeout=1s
+
+# Exit statuses of the vm, see vm/vm.h, and of the runner when a run fails
+instruction_budget_status=1
+invalid_object_status=3
+invalid_code_status=5
+stack_overflow_status=6
+division_error_status=7
+runner_failed_status=1
+
+# Instruction budget of the instruction_budget tests
+budget=1000
+
+i=0
+passed=0
+failed=0
+
+# check if cg.out, vm.out, runner.out and verifier_tests.txt exists
+if [[ -e $cg && -e $vm && -e $runner && -e $tests ]] ; then
+    echo "$cg, $vm, $runner and $tests are found. Starting tests.."
+else
+    echo "$cg, $vm, $runner or $tests could not be found! Aborting.."
+    exit
+fi
+
+# The vm verifies the pm0 code before running it. Each test runs code that
+#   the vm should not run to the end, and checks the exit status and the
+#   first line the vm reports on stderr.
+# invalid           : code is a pm0 code the verifier rejects.
+# invalid_object    : code is an object file the vm rejects before verifying it.
+# stack_overflow    : code is a list of lexemes, compiled by the code
+#                     generator, whose recursion overflows the stack for vm_inp.
+# division          : code is a list of lexemes, which divides by zero for
+#                     vm_inp.
+# instruction_budget: code is a list of lexemes, which runs more than $budget
+#                     instructions for vm_inp, run with -i $budget.
+#   Except for invalid and invalid_object, the code is run interpreted, in JIT mode, and by the
+#   runner, whose report of the failed run should give the same reason.
+# gt_vm_err: Expected first line of the stderr of vm.
+while read kind code vm_inp gt_vm_err; do
+    echo -e "${GREEN_EMPH}TEST[$i]${DEEMPH}"
+
+    out_dir="io/your_outputs/verifier/$i"
+    mkdir -p "$out_dir"
+    cg_out="$out_dir/cg_out.txt"
+    vm_err="$out_dir/vm_err.txt"
+
+    budget_flags=""
+    if [ "$kind" = "invalid" ]; then
+      expected_status=$invalid_code_status
+      modes="interpreted"
+      cp "$code" "$cg_out"
+    elif [ "$kind" = "invalid_object" ]; then
+      expected_status=$invalid_object_status
+      modes="interpreted"
+      cp "$code" "$cg_out"
+    elif [ "$kind" = "stack_overflow" ]; then
+      expected_status=$stack_overflow_status
+      modes="interpreted jit runner"
+      (timeout $timeout "$cg" "$code" "$cg_out") > /dev/null 2>&1
+    elif [ "$kind" = "division" ]; then
+      expected_status=$division_error_status
+      modes="interpreted jit runner"
+      (timeout $timeout "$cg" "$code" "$cg_out") > /dev/null 2>&1
+    elif [ "$kind" = "instruction_budget" ]; then
+      expected_status=$instruction_budget_status
+      modes="interpreted jit runner"
+      budget_flags="-i $budget"
+      (timeout $timeout "$cg" "$code" "$cg_out") > /dev/null 2>&1
+    else
+      echo "ERROR WHILE RUNNING GRADER SCRIPT: invalid, invalid_object, stack_overflow, division or instruction_budget in $tests?"
+      exit 0
+    fi
+
+    _diff=""
+    for mode in $modes; do
+      if [ "$mode" = "runner" ]; then
+        (timeout $timeout "$runner" $budget_flags -o "$out_dir" "$cg_out" "$vm_inp") > /dev/null 2> "$vm_err"
+        status=$?
+
+        # The runner reports the reason after the input of the run
+        if [ $status -ne $runner_failed_status ]; then
+          _diff="$_diff $mode: exit status $status, expected $runner_failed_status."
+        fi
+        _diff="$_diff$( { diff -B -w <(head -n 1 "$vm_err" | sed 's/.*stopped: //') <(sed 's/.*stopped: //' $gt_vm_err); } 2>&1 )"
+        continue
+      fi
+
+      flags="$budget_flags"
+      if [ "$mode" = "jit" ]; then flags="$flags -j"; fi
+
+      (timeout $timeout "$vm" $flags "$cg_out" "/dev/null" "$vm_inp" "/dev/null") > /dev/null 2> "$vm_err"
+      status=$?
+
+      # check the exit status and the reason reported
+      if [ $status -ne $expected_status ]; then
+        _diff="$_diff $mode: exit status $status, expected $expected_status."
+      fi
+      _diff="$_diff$( { head -n 1 "$vm_err" | diff -B -w - $gt_vm_err; } 2>&1 )"
+    done
+
+    if [[ $_diff ]] ; then
+        echo "TEST $i FAILED"
+        let failed=$failed+1
+
+        echo "The vm did not stop as expected on $code:"
+        echo "=================================================================="
+        echo $_diff
+        echo "=================================================================="
+        echo -e "${EMPH}Test this yourself by running the following${DEEMPH}: "
+        echo "  (cd test/; ./$vm $cg_out /dev/null $vm_inp /dev/null)"
+        echo "The first line of the stderr of vm was expected to match \"test/$gt_vm_err\"."
+        echo ""
+    else
+        echo "TEST $i PASSED"
+        let passed=$passed+1
+    fi
+    let i=$i+1
+
+done < "$tests"
+
+echo "# of tests       : $i"
+echo "# of tests passed: $passed"
+echo "# of tests failed: $failed"
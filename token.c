@@ -1,30 +1,83 @@
 #include "token.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 void initTokenList(TokenList* tokenList)
+{
+    initTokenListInArena(tokenList, NULL);
+}
+
+void initTokenListInArena(TokenList* tokenList, Arena* arena)
 {
     tokenList->tokens = NULL;
     tokenList->numberOfTokens = 0;
+    tokenList->positions = NULL;
+    tokenList->capacity = 0;
+    tokenList->arena = arena;
 }
 
 void addToken(TokenList* tokenList, Token token)
 {
+    // Double the space for the tokens when it is full
+    if(tokenList->numberOfTokens == tokenList->capacity)
+    {
+        int capacity = tokenList->capacity ? 2 * tokenList->capacity : 64;
+
+        tokenList->tokens = (Token*)arenaRealloc(tokenList->arena, tokenList->tokens,
+            tokenList->capacity * sizeof(Token), capacity * sizeof(Token));
+
+        if(tokenList->positions)
+        {
+            tokenList->positions = (TokenPos*)arenaRealloc(tokenList->arena, tokenList->positions,
+                tokenList->capacity * sizeof(TokenPos), capacity * sizeof(TokenPos));
+        }
+
+        tokenList->capacity = capacity;
+    }
+
     // Increase number of tokens
     tokenList->numberOfTokens++;
 
-    // Allocate space for new token
-    tokenList->tokens = (Token*)realloc(tokenList->tokens, (tokenList->numberOfTokens) * sizeof(Token));
-
     // Add token to the end of the list
     tokenList->tokens[tokenList->numberOfTokens - 1] = token;
+
+    // Keep the side table of positions - if exists - in sync with tokens
+    if(tokenList->positions)
+    {
+        tokenList->positions[tokenList->numberOfTokens - 1] = (TokenPos){ .line = 0, .column = 0 };
+    }
+}
+
+void addTokenWithPos(TokenList* tokenList, Token token, TokenPos pos)
+{
+    // Create the side table of positions if this is the first position added
+    if(!tokenList->positions)
+    {
+        int capacity = tokenList->capacity ? tokenList->capacity : 64;
+
+        tokenList->positions = (TokenPos*)arenaAlloc(tokenList->arena, capacity * sizeof(TokenPos));
+        memset(tokenList->positions, 0, capacity * sizeof(TokenPos));
+
+        if(!tokenList->capacity)
+        {
+            tokenList->tokens = (Token*)arenaAlloc(tokenList->arena, capacity * sizeof(Token));
+            tokenList->capacity = capacity;
+        }
+    }
+
+    addToken(tokenList, token);
+
+    tokenList->positions[tokenList->numberOfTokens - 1] = pos;
 }
 
 TokenList getCopy(TokenList src)
 {
     TokenList copy;
     
+    initTokenList(&copy);
     copy.numberOfTokens = src.numberOfTokens;
+    copy.capacity = src.numberOfTokens;
 
     if(src.tokens)
     {
@@ -34,6 +87,14 @@ TokenList getCopy(TokenList src)
             copy.tokens[i] = src.tokens[i];
     }
 
+    if(src.positions)
+    {
+        copy.positions = (TokenPos*)malloc(src.numberOfTokens * sizeof(TokenPos));
+
+        for(int i = 0; i < src.numberOfTokens; i++)
+            copy.positions[i] = src.positions[i];
+    }
+
     return copy;
 }
 
@@ -42,44 +103,109 @@ void printTokenList(TokenList tokenList, FILE* out)
     if(out == NULL || tokenList.tokens == NULL)
         return;
 
-    fprintf(out, "%10s   %12s\n", "Token Type", "Lexeme");
+    if(!tokenList.positions)
+    {
+        fprintf(out, "%10s   %12s\n", "Token Type", "Lexeme");
+
+        for(int i = 0; i < tokenList.numberOfTokens; i++)
+        {
+            fprintf(out, "%10d   %12s\n", tokenList.tokens[i].id, tokenList.tokens[i].lexeme);
+        }
+
+        return;
+    }
+
+    fprintf(out, "%10s   %12s   %6s %6s\n", "Token Type", "Lexeme", "Line", "Column");
 
     for(int i = 0; i < tokenList.numberOfTokens; i++)
     {
-        fprintf(out, "%10d   %12s\n", tokenList.tokens[i].id, tokenList.tokens[i].lexeme);
+        fprintf(out, "%10d   %12s   %6d %6d\n", tokenList.tokens[i].id, tokenList.tokens[i].lexeme,
+            tokenList.positions[i].line, tokenList.positions[i].column);
     }
 }
 
 TokenList readTokenList(FILE* in)
+{
+    return readTokenListInArena(in, NULL);
+}
+
+TokenList readTokenListInArena(FILE* in, Arena* arena)
 {
     TokenList tokenList;
 
-    tokenList.tokens = NULL;
-    tokenList.numberOfTokens = 0;
+    initTokenListInArena(&tokenList, arena);
 
     if(!in) return tokenList;
 
-    // Skip header, which is 26 characters
-    fseek(in, 26, SEEK_CUR);
+    // Skip header, which also tells whether the positions are included
+    char header[64] = "";
+    if(!fgets(header, sizeof(header), in)) return tokenList;
 
     Token token;
 
-    while( fscanf(in, "%10d   %12s\n", &token.id, token.lexeme) == 2 )
+    if(!strstr(header, "Line"))
     {
-        addToken(&tokenList, token);
+        while( fscanf(in, "%10d   %12s\n", &token.id, token.lexeme) == 2 )
+        {
+            addToken(&tokenList, token);
+        }
+
+        return tokenList;
+    }
+
+    TokenPos pos;
+
+    while( fscanf(in, "%10d   %12s   %6d %6d\n", &token.id, token.lexeme, &pos.line, &pos.column) == 4 )
+    {
+        addTokenWithPos(&tokenList, token, pos);
     }
 
     return tokenList;
 }
 
+unsigned long long hashTokens(TokenList* tokenList, int startInd, int numberOfTokens)
+{
+    // 64-bit FNV-1a
+    unsigned long long hash = 14695981039346656037ULL;
+    const unsigned long long prime = 1099511628211ULL;
+
+    for(int i = startInd; i < startInd + numberOfTokens && i < tokenList->numberOfTokens; i++)
+    {
+        Token* token = &tokenList->tokens[i];
+
+        hash ^= (unsigned long long)token->id;
+        hash *= prime;
+
+        if(tokenList->positions)
+        {
+            hash ^= (unsigned int)(tokenList->positions[i].line - tokenList->positions[startInd].line);
+            hash *= prime;
+        }
+
+        // Terminating null character separates the lexemes
+        for(const char* c = token->lexeme; ; c++)
+        {
+            hash ^= (unsigned char)*c;
+            hash *= prime;
+
+            if(!*c) break;
+        }
+    }
+
+    return hash;
+}
+
 void deleteTokenList(TokenList* tokenList)
 {
     if(!tokenList) return;
     
-    if(tokenList->tokens)
-        free(tokenList->tokens);
+    // In an arena, the tokens are released with the arena
+    arenaFree(tokenList->arena, tokenList->tokens);
+    arenaFree(tokenList->arena, tokenList->positions);
 
     tokenList->tokens = NULL;
+    tokenList->positions = NULL;
+    tokenList->capacity = 0;
 }
 
 
@@ -106,6 +232,17 @@ Token getCurrentTokenFromIterator(TokenListIterator it)
     return it.tokenList->tokens[it.currentTokenInd];
 }
 
+TokenPos getCurrentTokenPosFromIterator(TokenListIterator it)
+{
+    if(!it.tokenList || !it.tokenList->positions || it.currentTokenInd >= it.tokenList->numberOfTokens)
+    {
+        TokenPos unknownPos = { .line = 0, .column = 0 };
+        return unknownPos;
+    }
+
+    return it.tokenList->positions[it.currentTokenInd];
+}
+
 void advanceTokenListIterator(TokenListIterator* it)
 {
     if(it) it->currentTokenInd++;
@@ -2,6 +2,7 @@
 #define __TOKEN_H__
 
 #include <stdio.h>
+#include "arena.h"
 
 #define MAX_LEXEME_LENGTH 11
 
@@ -13,6 +14,17 @@ typedef struct {
     char lexeme[MAX_LEXEME_LENGTH + 1]; // null terminated string
 } Token;
 
+/**
+ * The position of a token in the source code. Both line and column start
+ * .. from 1. Zero means the position is unknown.
+ * Positions are kept in a side table of TokenList rather than in Token,
+ * .. so that Token stays small for the parser.
+ * */
+typedef struct {
+    int line;
+    int column;
+} TokenPos;
+
 /**
  * The struct to store list of tokens and keep track
  * of number of tokens included in the list
@@ -20,6 +32,19 @@ typedef struct {
 typedef struct {
     Token* tokens;
     int numberOfTokens;
+
+    /**
+     * positions[i] is the position of tokens[i]. NULL if the positions of the
+     * .. tokens are not known, e.g. the list is read from a file without them.
+     * */
+    TokenPos* positions;
+
+    /**
+     * Number of the tokens the lists are allocated for, and the arena they
+     * .. are allocated in, NULL if they are on the heap.
+     * */
+    int capacity;
+    Arena* arena;
 } TokenList;
 
 /**
@@ -35,11 +60,25 @@ typedef struct {
  * */
 void initTokenList(TokenList*);
 
+/**
+ * Initializes the given TokenList to allocate its tokens in the given arena,
+ * .. see arena.h. The tokens are released with the arena, deleteTokenList()
+ * .. does not free them.
+ * */
+void initTokenListInArena(TokenList*, Arena*);
+
 /**
  * Adds the given Token to the given TokenList
  * */
 void addToken(TokenList*, Token);
 
+/**
+ * Adds the given Token to the given TokenList together with its position in
+ * .. the source code. The positions of the tokens previously added without
+ * .. a position are set as unknown.
+ * */
+void addTokenWithPos(TokenList*, Token, TokenPos);
+
 /**
  * Creates and returns a copy of the given TokenList.
  * TokenList dynamically allocates memory for its list.
@@ -50,17 +89,33 @@ void addToken(TokenList*, Token);
 TokenList getCopy(TokenList);
 
 /**
- * Writes the given TokenList to the given FILE
+ * Writes the given TokenList to the given FILE.
+ * If the positions of the tokens are known, they are written as two extra
+ * .. columns: Line and Column.
  * */
 void printTokenList(TokenList, FILE*);
 
 /**
  * Reads a list of tokens from given file.
  * The format of the list in the input file should be same as the printTokenList()
- * func prints.
+ * func prints, either with or without the token positions.
  * */
 TokenList readTokenList(FILE*);
 
+/**
+ * Same as readTokenList(), allocating the tokens in the given arena.
+ * */
+TokenList readTokenListInArena(FILE*, Arena*);
+
+/**
+ * Returns the hash of numberOfTokens tokens of the TokenList, starting from
+ * .. the token at index startInd. The ids and the lexemes are hashed, and
+ * .. the lines of the tokens - if known - relative to the line of the first,
+ * .. so that moving the tokens to other lines does not change the hash, but
+ * .. breaking them into lines differently does.
+ * */
+unsigned long long hashTokens(TokenList*, int startInd, int numberOfTokens);
+
 /**
  * Makes the necessary deallocations on the TokenList
  * */
@@ -78,6 +133,12 @@ TokenListIterator getTokenListIterator(TokenList*);
  * */
 Token getCurrentTokenFromIterator(TokenListIterator);
 
+/**
+ * Returns the source code position of the current token from TokenListIterator.
+ * If the position is not known, returns a position with line and column 0.
+ * */
+TokenPos getCurrentTokenPosFromIterator(TokenListIterator);
+
 /**
  * Advances the position of next token of TokenListIterator by one.
  * */
@@ -1,29 +0,0 @@
-#ifndef __VM_H__
-#define __VM_H__
-
-#include <stdio.h>
-
-/**
- * inp: The FILE pointer containing the list of instructions to
- *         be loaded to code memory of the virtual machine.
- * 
- * outp: The FILE pointer to write the simulation output, which
- *       contains both code memory and execution history.
- * 
- * vm_inp: The FILE pointer that is going to be attached as the input
- *         stream to the virtual machine. Useful to feed input for SIO
- *         instructions.
- * 
- * vm_outp: The FILE pointer that is going to be attached as the output
- *          stream to the virtual machine. Useful to save the output printed
- *          by SIO instructions.
- * */
-
-void simulateVM(
-    FILE* inp,
-    FILE* outp,
-    FILE* vm_inp,
-    FILE* vm_outp
-);
-
-#endif
\ No newline at end of file
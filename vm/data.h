@@ -6,6 +6,10 @@
 #define MAX_LEXI_LEVELS  3
 #define REGISTER_FILE_REG_COUNT 16
 
+// Slots of an activation record before its variables: the return value,
+// .. the static link, the dynamic link and the return address
+#define AR_VARIABLE_OFFSET 4
+
 typedef struct {
     int op;  // opcode
     int r;   // reg
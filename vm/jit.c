@@ -0,0 +1,638 @@
+#define _DEFAULT_SOURCE
+
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include "jit.h"
+
+#if defined(__x86_64__) && defined(__linux__)
+
+#include <sys/mman.h>
+
+/* ************************************************************************************ */
+/* Code buffer                                                                          */
+/* ************************************************************************************ */
+
+// Machine registers, by their encoding
+enum {
+    RAX, RCX, RDX, RBX, RSP, RBP, RSI, RDI,
+    R8, R9, R10, R11, R12, R13, R14, R15
+};
+
+/**
+ * Register usage of the native code:
+ *  RBX: the virtual machine
+ *  R12: BP
+ *  R13: SP
+ *  R14: the stack of the virtual machine
+ *  R15: native address table, used by RTN
+ *  R8 - R11: RF[0] - RF[3]
+ *  RAX, RCX, RDX: scratch. ECX holds the PC when leaving the native code.
+ * */
+#define REG_VM      RBX
+#define REG_BP      R12
+#define REG_SP      R13
+#define REG_STACK   R14
+#define REG_ENTRIES R15
+
+// Offsets of the activation record fields from the base pointer, see CAL
+#define AR_STATIC_LINK  1
+#define AR_DYNAMIC_LINK 2
+#define AR_RETURN_ADDR  3
+
+// Byte offset of a field of the activation record starting at stack[SP + 1]
+#define AR_FIELD(field) ((1 + (field)) * (int)sizeof(int))
+
+// The instruction index of a jump to the exit of the native code
+#define TARGET_EXIT -1
+
+/**
+ * Growing buffer the native code is emitted to, together with the rel32
+ * .. fields of the jumps to be patched once every instruction is emitted.
+ * */
+typedef struct {
+    unsigned char* bytes;
+    int size;
+    int capacity;
+
+    int* patchOffsets;
+    int* patchTargets;
+    int numberOfPatches;
+} CodeBuffer;
+
+static void emitByte(CodeBuffer* b, int byte)
+{
+    if(b->size == b->capacity)
+    {
+        b->capacity = b->capacity ? 2 * b->capacity : 4096;
+        b->bytes = (unsigned char*)realloc(b->bytes, b->capacity);
+    }
+
+    b->bytes[b->size++] = (unsigned char)byte;
+}
+
+static void emitInt(CodeBuffer* b, int value)
+{
+    unsigned int v = (unsigned int)value;
+
+    for(int i = 0; i < 4; i++)
+        emitByte(b, (v >> (8 * i)) & 0xFF);
+}
+
+/**
+ * Emits a rel32 field to be patched with the distance to the given
+ * .. instruction, or to the exit if target is TARGET_EXIT.
+ * */
+static void emitRel32(CodeBuffer* b, int target)
+{
+    b->numberOfPatches++;
+    b->patchOffsets = (int*)realloc(b->patchOffsets, b->numberOfPatches * sizeof(int));
+    b->patchTargets = (int*)realloc(b->patchTargets, b->numberOfPatches * sizeof(int));
+
+    b->patchOffsets[b->numberOfPatches - 1] = b->size;
+    b->patchTargets[b->numberOfPatches - 1] = target;
+
+    emitInt(b, 0);
+}
+
+/* ************************************************************************************ */
+/* Instruction encoding                                                                 */
+/* ************************************************************************************ */
+
+static void emitRex(CodeBuffer* b, int w, int reg, int index, int base)
+{
+    int rex = 0x40 | (w << 3) | ((reg >> 3) & 1) << 2 | ((index >> 3) & 1) << 1 | ((base >> 3) & 1);
+
+    if(rex != 0x40) emitByte(b, rex);
+}
+
+// Opcodes above 0xFF are two bytes long, e.g. 0x0FAF
+static void emitOpcode(CodeBuffer* b, int opcode)
+{
+    if(opcode > 0xFF) emitByte(b, opcode >> 8);
+    emitByte(b, opcode & 0xFF);
+}
+
+/**
+ * Emits opcode with the register operand reg and the register operand rm.
+ * w selects the 64 bit operand size.
+ * */
+static void emitRR(CodeBuffer* b, int w, int opcode, int reg, int rm)
+{
+    emitRex(b, w, reg, 0, rm);
+    emitOpcode(b, opcode);
+    emitByte(b, 0xC0 | (reg & 7) << 3 | (rm & 7));
+}
+
+/**
+ * Emits opcode with the register operand reg and the memory operand
+ * .. [base + index * scale + disp]. index is -1 if there is no index.
+ * */
+static void emitRM(CodeBuffer* b, int w, int opcode, int reg, int base, int index, int scale, int disp)
+{
+    int scaleBits = scale == 8 ? 3 : scale == 4 ? 2 : scale == 2 ? 1 : 0;
+
+    // RSP as the index means no index
+    if(index < 0) index = RSP;
+
+    emitRex(b, w, reg, index, base);
+    emitOpcode(b, opcode);
+    emitByte(b, 0x80 | (reg & 7) << 3 | 4);
+    emitByte(b, scaleBits << 6 | (index & 7) << 3 | (base & 7));
+    emitInt(b, disp);
+}
+
+// op r/m, imm32 where ext is the opcode extension: 0 add, 5 sub, 7 cmp
+static void emitAluImm(CodeBuffer* b, int w, int ext, int rm, int imm)
+{
+    emitRR(b, w, 0x81, ext, rm);
+    emitInt(b, imm);
+}
+
+// mov r32, imm32
+static void emitMovImm(CodeBuffer* b, int reg, int imm)
+{
+    emitRex(b, 0, 0, 0, reg);
+    emitByte(b, 0xB8 + (reg & 7));
+    emitInt(b, imm);
+}
+
+static void emitPush(CodeBuffer* b, int reg)
+{
+    emitRex(b, 0, 0, 0, reg);
+    emitByte(b, 0x50 + (reg & 7));
+}
+
+static void emitPop(CodeBuffer* b, int reg)
+{
+    emitRex(b, 0, 0, 0, reg);
+    emitByte(b, 0x58 + (reg & 7));
+}
+
+static void emitJmp(CodeBuffer* b, int target)
+{
+    emitByte(b, 0xE9);
+    emitRel32(b, target);
+}
+
+// cond is the low nibble of the Jcc opcode: 4 for jz, 3 for jae, D for jge
+static void emitJcc(CodeBuffer* b, int cond, int target)
+{
+    emitOpcode(b, 0x0F80 | cond);
+    emitRel32(b, target);
+}
+
+/* ************************************************************************************ */
+/* Templates                                                                            */
+/* ************************************************************************************ */
+
+/**
+ * Returns the machine register RF[k] is kept in, -1 if it is kept in memory.
+ * */
+static int cachedReg(int k)
+{
+    return k < JIT_CACHED_REGS ? R8 + k : -1;
+}
+
+static int rfOffset(int k)
+{
+    return offsetof(VirtualMachine, RF) + k * sizeof(int);
+}
+
+// dst = RF[k]
+static void emitLoadRF(CodeBuffer* b, int dst, int k)
+{
+    int c = cachedReg(k);
+
+    if(c >= 0) emitRR(b, 0, 0x89, c, dst);
+    else       emitRM(b, 0, 0x8B, dst, REG_VM, -1, 1, rfOffset(k));
+}
+
+// RF[k] = src
+static void emitStoreRF(CodeBuffer* b, int k, int src)
+{
+    int c = cachedReg(k);
+
+    if(c >= 0) emitRR(b, 0, 0x89, src, c);
+    else       emitRM(b, 0, 0x89, src, REG_VM, -1, 1, rfOffset(k));
+}
+
+/**
+ * EAX = base pointer L levels down
+ * */
+static void emitBasePointer(CodeBuffer* b, int L)
+{
+    emitRR(b, 0, 0x89, REG_BP, RAX);
+
+    for(int i = 0; i < L; i++)
+    {
+        // EAX = stack[EAX + 1]
+        emitRR(b, 1, 0x63, RAX, RAX);
+        emitRM(b, 0, 0x8B, RAX, REG_STACK, RAX, 4, AR_STATIC_LINK * (int)sizeof(int));
+    }
+}
+
+/**
+ * Leaves the native code with PC = pc.
+ * */
+static void emitExitAt(CodeBuffer* b, int pc)
+{
+    emitMovImm(b, RCX, pc);
+    emitJmp(b, TARGET_EXIT);
+}
+
+/**
+ * Returns 1 if the instruction is executed by the native code, 0 if it is left
+ * .. to the interpreter.
+ * */
+static int isNative(Instruction ins, int numOfIns)
+{
+    int regs = 0;
+
+    // Number of register operands
+    switch(ins.op)
+    {
+        case 1: case 3: case 4: case 8: case 17:           regs = 1; break;
+        case 12: case 31:
+        case 25: case 26: case 27: case 28: case 29: case 30: regs = 2; break;
+        case 13: case 14: case 15: case 16: case 18:
+        case 19: case 20: case 21: case 22: case 23: case 24: regs = 3; break;
+        case 2: case 5: case 6: case 7:                    regs = 0; break;
+
+        // SIO and illegal instructions
+        default: return 0;
+    }
+
+    if(regs >= 1 && (ins.r < 0 || ins.r >= REGISTER_FILE_REG_COUNT)) return 0;
+    if(regs >= 2 && (ins.l < 0 || ins.l >= REGISTER_FILE_REG_COUNT)) return 0;
+    if(regs >= 3 && (ins.m < 0 || ins.m >= REGISTER_FILE_REG_COUNT)) return 0;
+
+    // Shift amounts
+    if(ins.op == 31 && (ins.m < -31 || ins.m > 31)) return 0;
+
+    // Level differences
+    if((ins.op == 3 || ins.op == 4 || ins.op == 5) && ins.l > JIT_MAX_LEVEL_DIFF) return 0;
+
+    // Jump targets
+    if((ins.op == 5 || ins.op == 7 || ins.op == 8 || (ins.op >= 25 && ins.op <= 30)) && (ins.m < 0 || ins.m >= numOfIns)) return 0;
+
+    return 1;
+}
+
+/**
+ * Emits the template of the instruction at index i.
+ * */
+static void emitInstruction(CodeBuffer* b, Instruction ins, int i, int numOfIns)
+{
+    // setcc opcode of each relational opcode, from EQL to GEQ, and the jcc
+    // condition of each compare-and-branch opcode, from JEQ to JGE
+    static const int setcc[] = { 0x0F94, 0x0F95, 0x0F9C, 0x0F9E, 0x0F9F, 0x0F9D };
+    static const int jcc[]   = { 0x4, 0x5, 0xC, 0xE, 0xF, 0xD };
+
+    if(!isNative(ins, numOfIns))
+    {
+        emitExitAt(b, i);
+        return;
+    }
+
+    switch(ins.op)
+    {
+        case 1:
+            //LIT
+            if(cachedReg(ins.r) >= 0)
+            {
+                emitMovImm(b, cachedReg(ins.r), ins.m);
+            }
+            else
+            {
+                emitMovImm(b, RAX, ins.m);
+                emitStoreRF(b, ins.r, RAX);
+            }
+            break;
+        case 2:
+            //RTN
+            // SP = BP - 1
+            emitRR(b, 0, 0x89, REG_BP, REG_SP);
+            emitAluImm(b, 0, 5, REG_SP, 1);
+
+            // BP = dynamic link, ECX = PC = return address
+            emitRR(b, 1, 0x63, RDX, REG_SP);
+            emitRM(b, 0, 0x8B, REG_BP, REG_STACK, RDX, 4, AR_FIELD(AR_DYNAMIC_LINK));
+            emitRM(b, 0, 0x8B, RCX, REG_STACK, RDX, 4, AR_FIELD(AR_RETURN_ADDR));
+
+            // Leave if BP is zero or PC is not in the code
+            emitRR(b, 0, 0x85, REG_BP, REG_BP);
+            emitJcc(b, 0x4, TARGET_EXIT);
+            emitAluImm(b, 0, 7, RCX, numOfIns);
+            emitJcc(b, 0x3, TARGET_EXIT);
+
+            // jmp [entries + PC * 8]
+            emitRR(b, 1, 0x63, RCX, RCX);
+            emitRM(b, 0, 0xFF, 4, REG_ENTRIES, RCX, 8, 0);
+            break;
+        case 3:
+            //LOD
+            emitBasePointer(b, ins.l);
+            emitAluImm(b, 0, 0, RAX, ins.m);
+            emitRR(b, 1, 0x63, RAX, RAX);
+            emitRM(b, 0, 0x8B, RCX, REG_STACK, RAX, 4, 0);
+            emitStoreRF(b, ins.r, RCX);
+            break;
+        case 4:
+            //STO
+            emitBasePointer(b, ins.l);
+            emitAluImm(b, 0, 0, RAX, ins.m);
+            emitRR(b, 1, 0x63, RAX, RAX);
+            emitLoadRF(b, RCX, ins.r);
+            emitRM(b, 0, 0x89, RCX, REG_STACK, RAX, 4, 0);
+            break;
+        case 5:
+            //CAL
+            // Leave to the interpreter if the activation record does not fit
+            emitMovImm(b, RCX, i);
+            emitAluImm(b, 0, 7, REG_SP, MAX_STACK_HEIGHT - AR_VARIABLE_OFFSET);
+            emitJcc(b, 0xD, TARGET_EXIT);
+
+            // stack[SP + 1] = 0
+            emitRR(b, 1, 0x63, RDX, REG_SP);
+            emitMovImm(b, RCX, 0);
+            emitRM(b, 0, 0x89, RCX, REG_STACK, RDX, 4, AR_FIELD(0));
+
+            // stack[SP + 2] = base(L), stack[SP + 3] = BP, stack[SP + 4] = PC
+            emitBasePointer(b, ins.l);
+            emitRM(b, 0, 0x89, RAX, REG_STACK, RDX, 4, AR_FIELD(AR_STATIC_LINK));
+            emitRM(b, 0, 0x89, REG_BP, REG_STACK, RDX, 4, AR_FIELD(AR_DYNAMIC_LINK));
+            emitMovImm(b, RCX, i + 1);
+            emitRM(b, 0, 0x89, RCX, REG_STACK, RDX, 4, AR_FIELD(AR_RETURN_ADDR));
+
+            // BP = SP + 1
+            emitRR(b, 0, 0x89, REG_SP, REG_BP);
+            emitAluImm(b, 0, 0, REG_BP, 1);
+
+            // PC = M, leaving if BP is zero
+            emitMovImm(b, RCX, ins.m);
+            emitRR(b, 0, 0x85, REG_BP, REG_BP);
+            emitJcc(b, 0x4, TARGET_EXIT);
+            emitJmp(b, ins.m);
+            break;
+        case 6:
+            //INC
+            // Leave to the interpreter if the stack would overflow
+            if(ins.m > 0)
+            {
+                emitMovImm(b, RCX, i);
+                emitAluImm(b, 0, 7, REG_SP, MAX_STACK_HEIGHT - ins.m);
+                emitJcc(b, 0xD, TARGET_EXIT);
+            }
+
+            emitAluImm(b, 0, 0, REG_SP, ins.m);
+            break;
+        case 7:
+            //JMP
+            emitJmp(b, ins.m);
+            break;
+        case 8:
+            //JPC
+            emitLoadRF(b, RAX, ins.r);
+            emitRR(b, 0, 0x85, RAX, RAX);
+            emitJcc(b, 0x4, ins.m);
+            break;
+        case 12:
+            //NEG
+            emitLoadRF(b, RAX, ins.l);
+            emitRR(b, 0, 0xF7, 3, RAX);
+            emitStoreRF(b, ins.r, RAX);
+            break;
+        case 13: case 14: case 15:
+            //ADD, SUB, MUL
+            emitLoadRF(b, RAX, ins.l);
+            emitLoadRF(b, RCX, ins.m);
+            if(ins.op == 13)      emitRR(b, 0, 0x01, RCX, RAX);
+            else if(ins.op == 14) emitRR(b, 0, 0x29, RCX, RAX);
+            else                  emitRR(b, 0, 0x0FAF, RAX, RCX);
+            emitStoreRF(b, ins.r, RAX);
+            break;
+        case 16: case 18:
+            //DIV, MOD
+            // Leave to the interpreter if the divisor is 0 or -1, as idiv
+            // .. traps dividing by zero and INT_MIN by -1
+            emitMovImm(b, RCX, i);
+            emitLoadRF(b, RDX, ins.m);
+            emitRR(b, 0, 0x85, RDX, RDX);
+            emitJcc(b, 0x4, TARGET_EXIT);
+            emitAluImm(b, 0, 7, RDX, -1);
+            emitJcc(b, 0x4, TARGET_EXIT);
+
+            emitRR(b, 0, 0x89, RDX, RCX);
+            emitLoadRF(b, RAX, ins.l);
+            emitByte(b, 0x99);                 // cdq
+            emitRR(b, 0, 0xF7, 7, RCX);        // idiv ecx
+            emitStoreRF(b, ins.r, ins.op == 16 ? RAX : RDX);
+            break;
+        case 17:
+            //ODD
+            emitLoadRF(b, RAX, ins.r);
+            emitMovImm(b, RCX, 2);
+            emitByte(b, 0x99);
+            emitRR(b, 0, 0xF7, 7, RCX);
+            emitStoreRF(b, ins.r, RDX);
+            break;
+        case 25: case 26: case 27: case 28: case 29: case 30:
+            //JEQ, JNE, JLT, JLE, JGT, JGE
+            emitLoadRF(b, RAX, ins.r);
+            emitLoadRF(b, RCX, ins.l);
+            emitRR(b, 0, 0x39, RCX, RAX);      // cmp eax, ecx
+            emitJcc(b, jcc[ins.op - 25], ins.m);
+            break;
+        case 31:
+            //SHF
+            emitLoadRF(b, RAX, ins.l);
+            if(ins.m > 0)
+            {
+                emitRR(b, 0, 0xC1, 4, RAX);    // shl eax, m
+                emitByte(b, ins.m);
+            }
+            else if(ins.m < 0)
+            {
+                // Add 2^-m - 1 to the negative dividends to round toward zero
+                emitRR(b, 0, 0x89, RAX, RCX);
+                emitRR(b, 0, 0xC1, 7, RCX);    // sar ecx, 31
+                emitByte(b, 31);
+                emitRR(b, 0, 0xC1, 5, RCX);    // shr ecx, 32 + m
+                emitByte(b, 32 + ins.m);
+                emitRR(b, 0, 0x01, RCX, RAX);
+                emitRR(b, 0, 0xC1, 7, RAX);    // sar eax, -m
+                emitByte(b, -ins.m);
+            }
+            emitStoreRF(b, ins.r, RAX);
+            break;
+        default:
+            //EQL, NEQ, LSS, LEQ, GTR, GEQ
+            emitLoadRF(b, RAX, ins.l);
+            emitLoadRF(b, RCX, ins.m);
+            emitRR(b, 0, 0x39, RCX, RAX);      // cmp eax, ecx
+            emitRR(b, 0, setcc[ins.op - 19], 0, RAX);
+            emitRR(b, 0, 0x0FB6, RAX, RAX);    // movzx eax, al
+            emitStoreRF(b, ins.r, RAX);
+            break;
+    }
+}
+
+/**
+ * void entry(VirtualMachine* vm, void* target, void** entries)
+ * Loads the state of the virtual machine to the machine registers and jumps
+ * .. to target.
+ * */
+static void emitEntry(CodeBuffer* b)
+{
+    emitPush(b, RBX); emitPush(b, RBP);
+    emitPush(b, R12); emitPush(b, R13); emitPush(b, R14); emitPush(b, R15);
+    emitAluImm(b, 1, 5, RSP, 8);
+
+    emitRR(b, 1, 0x89, RDI, REG_VM);
+    emitRR(b, 1, 0x89, RDX, REG_ENTRIES);
+    emitRR(b, 1, 0x89, RDI, REG_STACK);
+    emitAluImm(b, 1, 0, REG_STACK, offsetof(VirtualMachine, stack));
+
+    emitRM(b, 0, 0x8B, REG_BP, REG_VM, -1, 1, offsetof(VirtualMachine, BP));
+    emitRM(b, 0, 0x8B, REG_SP, REG_VM, -1, 1, offsetof(VirtualMachine, SP));
+    for(int k = 0; k < JIT_CACHED_REGS; k++)
+        emitRM(b, 0, 0x8B, cachedReg(k), REG_VM, -1, 1, rfOffset(k));
+
+    // jmp rsi
+    emitRR(b, 0, 0xFF, 4, RSI);
+}
+
+/**
+ * Stores the machine registers back to the virtual machine, with PC = ECX,
+ * .. and returns from entry.
+ * */
+static void emitExit(CodeBuffer* b)
+{
+    emitRM(b, 0, 0x89, RCX, REG_VM, -1, 1, offsetof(VirtualMachine, PC));
+    emitRM(b, 0, 0x89, REG_BP, REG_VM, -1, 1, offsetof(VirtualMachine, BP));
+    emitRM(b, 0, 0x89, REG_SP, REG_VM, -1, 1, offsetof(VirtualMachine, SP));
+    for(int k = 0; k < JIT_CACHED_REGS; k++)
+        emitRM(b, 0, 0x89, cachedReg(k), REG_VM, -1, 1, rfOffset(k));
+
+    emitAluImm(b, 1, 0, RSP, 8);
+    emitPop(b, R15); emitPop(b, R14); emitPop(b, R13); emitPop(b, R12);
+    emitPop(b, RBP); emitPop(b, RBX);
+    emitByte(b, 0xC3);
+}
+
+/* ************************************************************************************ */
+/* Interface                                                                            */
+/* ************************************************************************************ */
+
+int jitCompile(JitCode* jit, Instruction* ins, int numOfIns)
+{
+    CodeBuffer b = { NULL, 0, 0, NULL, NULL, 0 };
+    int* offsets = (int*)malloc((numOfIns + 1) * sizeof(int));
+
+    jit->code = NULL;
+    jit->codeSize = 0;
+    jit->entries = NULL;
+    jit->numOfIns = 0;
+
+    emitEntry(&b);
+
+    for(int i = 0; i < numOfIns; i++)
+    {
+        offsets[i] = b.size;
+        emitInstruction(&b, ins[i], i, numOfIns);
+    }
+
+    // Running past the last instruction
+    emitExitAt(&b, numOfIns);
+
+    int exitOffset = b.size;
+    emitExit(&b);
+
+    // Resolve the jumps
+    for(int i = 0; i < b.numberOfPatches; i++)
+    {
+        int target = b.patchTargets[i] == TARGET_EXIT ? exitOffset : offsets[b.patchTargets[i]];
+        int rel = target - (b.patchOffsets[i] + 4);
+
+        memcpy(b.bytes + b.patchOffsets[i], &rel, sizeof(int));
+    }
+
+    // Copy to the executable memory, which is not writable once filled
+    void* code = mmap(NULL, b.size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+    if(code != MAP_FAILED)
+    {
+        memcpy(code, b.bytes, b.size);
+
+        if(mprotect(code, b.size, PROT_READ | PROT_EXEC))
+        {
+            munmap(code, b.size);
+            code = MAP_FAILED;
+        }
+    }
+
+    if(code != MAP_FAILED)
+    {
+        jit->code = (unsigned char*)code;
+        jit->codeSize = b.size;
+        jit->numOfIns = numOfIns;
+        jit->entries = (void**)malloc((numOfIns + 1) * sizeof(void*));
+
+        for(int i = 0; i < numOfIns; i++)
+            jit->entries[i] = jit->code + offsets[i];
+    }
+
+    free(offsets);
+    free(b.bytes);
+    free(b.patchOffsets);
+    free(b.patchTargets);
+
+    return jit->code ? 0 : -1;
+}
+
+void jitRun(JitCode* jit, VirtualMachine* vm)
+{
+    void (*entry)(VirtualMachine*, void*, void**);
+
+    *(void**)&entry = jit->code;
+
+    entry(vm, jit->entries[vm->PC], jit->entries);
+}
+
+void jitDelete(JitCode* jit)
+{
+    if(!jit) return;
+
+    if(jit->code)    munmap(jit->code, jit->codeSize);
+    if(jit->entries) free(jit->entries);
+
+    jit->code = NULL;
+    jit->codeSize = 0;
+    jit->entries = NULL;
+    jit->numOfIns = 0;
+}
+
+#else
+
+// The JIT is only available on x86-64. Elsewhere, everything is interpreted.
+
+int jitCompile(JitCode* jit, Instruction* ins, int numOfIns)
+{
+    jit->code = NULL;
+    jit->codeSize = 0;
+    jit->entries = NULL;
+    jit->numOfIns = 0;
+
+    return -1;
+}
+
+void jitRun(JitCode* jit, VirtualMachine* vm)
+{
+}
+
+void jitDelete(JitCode* jit)
+{
+}
+
+#endif
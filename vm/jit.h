@@ -0,0 +1,77 @@
+#ifndef __JIT_H__
+#define __JIT_H__
+
+#include <stddef.h>
+#include "data.h"
+
+/**
+ * Template JIT for x86-64.
+ *
+ * Each instruction is translated by copying the native code template of its
+ * .. opcode and patching the operands in. The targets of the jumps - JMP, JPC
+ * .. and the compare-and-branch instructions, which compile to a cmp and a
+ * .. jcc - and CAL are resolved to the native address of the target
+ * .. instruction, and RTN jumps through a table of native addresses indexed
+ * .. by the return address.
+ * BP, SP and the first JIT_CACHED_REGS entries of the register file are kept
+ * .. in machine registers while the native code runs.
+ *
+ * The instructions the native code does not execute - SIO instructions,
+ * .. illegal instructions, the ones with operands out of range, CAL and INC
+ * .. when the stack would grow past MAX_STACK_HEIGHT, and DIV and MOD by zero
+ * .. or -1 - are left to the interpreter: the native code stores the state
+ * .. back to the virtual machine and returns, with PC pointing at the
+ * .. instruction.
+ * The native code also returns whenever BP becomes zero, so that the halting
+ * .. condition of the interpreter is checked by the interpreter only.
+ * */
+
+/**
+ * Number of registers of the register file kept in machine registers.
+ * */
+#define JIT_CACHED_REGS 4
+
+/**
+ * Lexicographic level difference up to which LOD, STO and CAL are executed
+ * .. natively.
+ * */
+#define JIT_MAX_LEVEL_DIFF 8
+
+/**
+ * Native code of a list of instructions.
+ * */
+typedef struct {
+    /**
+     * Executable memory holding the entry point followed by the code of each
+     * .. instruction.
+     * */
+    unsigned char* code;
+    size_t codeSize;
+
+    /**
+     * Native address of each instruction.
+     * */
+    void** entries;
+    int numOfIns;
+} JitCode;
+
+/**
+ * Translates the given instructions to native code.
+ * Returns 0 on success. Returns -1 if the JIT is not supported on the
+ * .. platform or the executable memory could not be allocated.
+ * */
+int jitCompile(JitCode*, Instruction* ins, int numOfIns);
+
+/**
+ * Runs the native code on the virtual machine, starting from the instruction
+ * .. PC points at, until an instruction left to the interpreter is reached.
+ * PC should be in the code and BP should not be zero.
+ * */
+void jitRun(JitCode*, VirtualMachine*);
+
+/**
+ * Makes the necessary deallocations on the native code.
+ * */
+void jitDelete(JitCode*);
+
+#endif
@@ -1,27 +1,129 @@
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include "vm.h"
 
+/**
+ * Opens the output file of the vm. When resuming from a snapshot, the file
+ * .. is not truncated, to keep the output written before the snapshot.
+ * */
+FILE* openVMOutput(const char* path, int resuming)
+{
+    FILE* out = resuming ? fopen(path, "r+") : NULL;
+    return out ? out : fopen(path, "w");
+}
+
 int main(int argc, char **argv)
 {
     FILE *inp, *outp, *vm_inp, *vm_outp;
 
+    VMOptions options;
+    initVMOptions(&options);
+
+    // Metrics of the simulation, written to stderr in statsFormat if requested
+    Stats stats;
+    initStats(&stats, "pm0_");
+    int statsFormat = -1;
+
+    // How the simulation ended, which is the exit status
+    int status = VM_HALTED;
+
+    // Options precede the file arguments
+    int argsOk = 1;
+    while(argc > 1 && argsOk && argv[1][0] == '-' && argv[1][1])
+    {
+        if(!strcmp(argv[1], "-j"))
+        {
+            options.jit = 1;
+        }
+        else if(!strcmp(argv[1], "-m"))
+        {
+            options.mapInput = 1;
+        }
+        else if(!strcmp(argv[1], "-u"))
+        {
+            options.packCode = 0;
+        }
+        else if(!strcmp(argv[1], "-p") && argc > 2)
+        {
+            if( !(options.profileReport = fopen(argv[2], "w")) ) argsOk = 0;
+            argc--;
+            argv++;
+        }
+        else if(!strcmp(argv[1], "-i") && argc > 2)
+        {
+            options.maxInstructions = atoll(argv[2]);
+            argc--;
+            argv++;
+        }
+        else if(!strcmp(argv[1], "-t") && argc > 2)
+        {
+            options.maxMillis = atoll(argv[2]);
+            argc--;
+            argv++;
+        }
+        else if(!strcmp(argv[1], "-c") && argc > 2)
+        {
+            options.snapshotPath = argv[2];
+            argc--;
+            argv++;
+        }
+        else if(!strcmp(argv[1], "-C") && argc > 2)
+        {
+            options.snapshotInterval = atoll(argv[2]);
+            argc--;
+            argv++;
+        }
+        else if(!strcmp(argv[1], "-r") && argc > 2)
+        {
+            options.resumePath = argv[2];
+            argc--;
+            argv++;
+        }
+        else if(!strcmp(argv[1], "--stats") && argc > 2)
+        {
+            if( (statsFormat = getStatsFormat(argv[2])) < 0 ) argsOk = 0;
+            options.stats = &stats;
+            argc--;
+            argv++;
+        }
+        else if(!strcmp(argv[1], "-f") && argc > 2)
+        {
+            if( !(options.profileFolded = fopen(argv[2], "w")) ) argsOk = 0;
+            argc--;
+            argv++;
+        }
+        else
+        {
+            argsOk = 0;
+        }
+
+        argc--;
+        argv++;
+    }
+
+    if(!argsOk)
+    {
+        // Falls through to the usage below
+        argc = 0;
+    }
+
     if(argc == 3)
     {
-        inp     = fopen(argv[1], "r");
+        inp     = fopen(argv[1], "rb");
         outp    = fopen(argv[2], "w");
 
         vm_inp  = stdin;
         vm_outp = stdout;
 
-        simulateVM(inp, outp, vm_inp, vm_outp);
+        status = simulateVMWithOptions(inp, outp, vm_inp, vm_outp, &options);
 
         fclose(inp);
         fclose(outp);
     }
     else if(argc == 5)
     {
-        inp     = fopen(argv[1], "r");
+        inp     = fopen(argv[1], "rb");
         outp    = fopen(argv[2], "w");
 
         // vm_inp
@@ -29,10 +131,10 @@ int main(int argc, char **argv)
         else                       vm_inp = stdin;
 
         // vm_outp
-        if( strcmp(argv[3], "-") ) vm_outp = fopen(argv[4], "w");
+        if( strcmp(argv[3], "-") ) vm_outp = openVMOutput(argv[4], options.resumePath != NULL);
         else                       vm_outp = stdout;
 
-        simulateVM(inp, outp, vm_inp, vm_outp);
+        status = simulateVMWithOptions(inp, outp, vm_inp, vm_outp, &options);
 
         fclose(inp);
         fclose(outp);
@@ -45,10 +147,47 @@ int main(int argc, char **argv)
     }
     else
     {
-        fprintf(stderr, "Usage: vm.out (ins_inp_file) (simul_outp_file) [vm_inp_file=stdin] [vm_outp_file=stdout]\n");
+        fprintf(stderr, "Usage: vm.out [-j] [-m] [-u] [-p profile_file] [-f folded_file] [-i max_instructions] [-t max_milliseconds] [-c snapshot_file [-C interval]] [-r snapshot_file] [--stats json|prometheus] (ins_inp_file) (simul_outp_file) [vm_inp_file=stdin] [vm_outp_file=stdout]\n");
+
+        fprintf(stderr, "\n\t-j  Compile the instructions to native code and run them natively where"
+                        "\n\t    possible. Only the code memory is written to simul_outp_file.\n");
+
+        fprintf(stderr, "\n\t-m  Memory-map vm_inp_file instead of reading it, if it is a regular file.\n");
+
+        fprintf(stderr, "\n\t-u  Run the instructions unpacked, rather than packed to 32 bits each.\n");
+
+        fprintf(stderr, "\n\t-p profile_file  Profile the execution and write a report of the hottest"
+                        "\n\t                 instructions, opcodes, procedures, loops and branches.\n");
+
+        fprintf(stderr, "\n\t-f folded_file  Profile the execution and write the instructions executed"
+                        "\n\t                per call path in folded stack format, for flamegraphs.\n");
+
+        fprintf(stderr, "\n\t-i max_instructions  Stop after executing max_instructions instructions.\n");
+
+        fprintf(stderr, "\n\t-t max_milliseconds  Stop after running for max_milliseconds milliseconds.\n"
+                        "\n\tWhen stopped by -i or -t, the registers and the stack are reported to"
+                        "\n\tsimul_outp_file and stderr, and the exit status is nonzero. So are they"
+                        "\n\twhen a CAL or INC would grow the stack past MAX_STACK_HEIGHT, and when"
+                        "\n\ta DIV or MOD divides by zero, or INT_MIN by -1.\n");
+
+        fprintf(stderr, "\n\t-c snapshot_file  Write snapshots of the virtual machine and the position of its"
+                        "\n\t                  I/O to snapshot_file: on SIGUSR1, when stopped by -i or -t,"
+                        "\n\t                  and every interval instructions if -C is given.\n");
+
+        fprintf(stderr, "\n\t-r snapshot_file  Resume from the snapshot, on the same ins_inp_file and I/O files."
+                        "\n\t                  The output in vm_outp_file after the snapshot is replaced.\n");
+
+        fprintf(stderr, "\n\t--stats json|prometheus  Write the time spent loading and executing the code, the"
+                        "\n\t                  number of instructions executed, the maximum stack depth and"
+                        "\n\t                  the number of SIO reads and writes to stderr, in the given format.\n");
 
         fprintf(stderr, "\n\tins_inp_file  The path to the file containing the list of instructions to"
-                        "\n\t              be loaded to code memory of the virtual machine.\n");
+                        "\n\t              be loaded to code memory of the virtual machine, either as"
+                        "\n\t              PM/0 assembly text or in the binary object format written by"
+                        "\n\t              code_generator.out -b. The instructions are verified before"
+                        "\n\t              they are run: code with illegal opcodes or registers, jumps out"
+                        "\n\t              of the code or accesses out of the stack is rejected, and the"
+                        "\n\t              exit status is nonzero.\n");
 
         fprintf(stderr, "\n\tsimul_outp_file  The path to the file to write the simulation output, which"
                         "\n\t                 contains both code memory and execution history.\n");
@@ -60,5 +199,11 @@ int main(int argc, char **argv)
                         "\n\t             by SIO instructions. Use dash ('-') to assign to stdout.\n");
     }
 
-    return 0;
+    if(options.stats && (argc == 3 || argc == 5)) printStats(&stats, statsFormat, stderr);
+    deleteStats(&stats);
+
+    if(options.profileReport) fclose(options.profileReport);
+    if(options.profileFolded) fclose(options.profileFolded);
+
+    return status;
 }
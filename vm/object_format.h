@@ -0,0 +1,75 @@
+#ifndef __OBJECT_FORMAT_H__
+#define __OBJECT_FORMAT_H__
+
+#include <stdint.h>
+
+/**
+ * Binary object format of PM/0 programs, written by the code generator and
+ * .. loaded by the virtual machine. All fields are little-endian.
+ *
+ * The file starts with a header, followed by the section table, followed by
+ * .. the sections. There is exactly one code section, in one of the two
+ * .. encodings below. The symbol and line sections are optional.
+ *
+ * 4 byte encoding - bits of a uint32_t:
+ *   0 - 4  : op (0 .. 31)
+ *   5 - 8  : r  (0 .. 15)
+ *   9 - 11 : l  (0 .. 7)
+ *   12 - 31: m  (two's complement, -2^19 .. 2^19 - 1)
+ * 8 byte encoding: PM0Instruction8.
+ * */
+
+#define PM0_OBJECT_MAGIC   "PM0O"
+#define PM0_OBJECT_VERSION 1
+
+/**
+ * Section types
+ * */
+enum {
+    PM0_SECTION_CODE4   = 1, // instructions in the 4 byte encoding
+    PM0_SECTION_CODE8   = 2, // instructions in the 8 byte encoding
+    PM0_SECTION_SYMBOLS = 3, // PM0Symbol entries, one per procedure
+    PM0_SECTION_LINES   = 4  // int32_t source line of each instruction, 0 if unknown
+};
+
+typedef struct {
+    char magic[4];
+    uint16_t version;
+    uint16_t numberOfSections;
+    uint32_t reserved[2];
+} PM0ObjectHeader;
+
+typedef struct {
+    uint32_t type;
+    uint32_t offset; // from the start of the file
+    uint32_t size;   // in bytes
+    uint32_t count;  // number of entries
+} PM0SectionHeader;
+
+typedef struct {
+    uint8_t op;
+    uint8_t r;
+    int16_t l;
+    int32_t m;
+} PM0Instruction8;
+
+/**
+ * A procedure: its name, which is '\0' terminated, its lexicographical level
+ * .. and the address of its first instruction.
+ * */
+typedef struct {
+    char name[12];
+    int32_t level;
+    int32_t address;
+} PM0Symbol;
+
+/**
+ * Limits of the 4 byte encoding
+ * */
+#define PM0_CODE4_MAX_OP 31
+#define PM0_CODE4_MAX_R  15
+#define PM0_CODE4_MAX_L  7
+#define PM0_CODE4_MIN_M  (-(1 << 19))
+#define PM0_CODE4_MAX_M  ((1 << 19) - 1)
+
+#endif
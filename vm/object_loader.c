@@ -0,0 +1,185 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "object_loader.h"
+
+/**
+ * Readers of little-endian fields
+ * */
+unsigned int readU16(const unsigned char* p)
+{
+    return p[0] | p[1] << 8;
+}
+
+unsigned int readU32(const unsigned char* p)
+{
+    return p[0] | p[1] << 8 | p[2] << 16 | (unsigned int)p[3] << 24;
+}
+
+/**
+ * Sign extends the lowest bits of value
+ * */
+int signExtend(unsigned int value, int bits)
+{
+    unsigned int sign = 1u << (bits - 1);
+    value &= (sign << 1) - 1;
+
+    return (int)(value ^ sign) - (int)sign;
+}
+
+/**
+ * Prints the reason the object is invalid, unmaps it and returns -1
+ * */
+int rejectObject(PM0Object* object, const char* reason)
+{
+    fprintf(stderr, "Invalid object file: %s\n", reason);
+    unmapObject(object);
+    return -1;
+}
+
+int mapObject(FILE* in, PM0Object* object)
+{
+    memset(object, 0, sizeof(PM0Object));
+
+    // Only regular files starting with the magic are mapped
+    struct stat st;
+    char magic[4];
+
+    if(fstat(fileno(in), &st) || !S_ISREG(st.st_mode) || st.st_size < (off_t)sizeof(PM0ObjectHeader))
+        return 1;
+
+    if(pread(fileno(in), magic, 4, 0) != 4 || memcmp(magic, PM0_OBJECT_MAGIC, 4))
+        return 1;
+
+    void* data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fileno(in), 0);
+    if(data == MAP_FAILED)
+        return rejectObject(object, "cannot be mapped");
+
+    object->data = (const unsigned char*)data;
+    object->size = st.st_size;
+
+    // Header
+    if(readU16(object->data + 4) != PM0_OBJECT_VERSION)
+        return rejectObject(object, "unsupported version");
+
+    int numberOfSections = readU16(object->data + 6), numberOfLines = 0;
+    size_t tableEnd = sizeof(PM0ObjectHeader) + (size_t)numberOfSections * sizeof(PM0SectionHeader);
+
+    if(tableEnd > object->size)
+        return rejectObject(object, "truncated section table");
+
+    // Sections
+    for(int i = 0; i < numberOfSections; i++)
+    {
+        const unsigned char* h = object->data + sizeof(PM0ObjectHeader) + i * sizeof(PM0SectionHeader);
+
+        unsigned int type = readU32(h), offset = readU32(h + 4), size = readU32(h + 8), count = readU32(h + 12);
+
+        if(offset < tableEnd || offset > object->size || size > object->size - offset)
+            return rejectObject(object, "section out of the file");
+
+        const unsigned char* section = object->data + offset;
+
+        switch(type)
+        {
+            case PM0_SECTION_CODE4:
+            case PM0_SECTION_CODE8:
+                if(object->code)
+                    return rejectObject(object, "more than one code section");
+                if((size_t)count * (type == PM0_SECTION_CODE4 ? 4 : sizeof(PM0Instruction8)) != size)
+                    return rejectObject(object, "code section size does not match its count");
+                if(count > MAX_CODE_LENGTH)
+                    return rejectObject(object, "code section longer than MAX_CODE_LENGTH");
+
+                object->code = section;
+                object->codeType = type;
+                object->numOfIns = count;
+                break;
+            case PM0_SECTION_SYMBOLS:
+                if((size_t)count * sizeof(PM0Symbol) != size)
+                    return rejectObject(object, "symbol section size does not match its count");
+
+                object->symbols = section;
+                object->numberOfSymbols = count;
+                break;
+            case PM0_SECTION_LINES:
+                if((size_t)count * sizeof(int32_t) != size)
+                    return rejectObject(object, "line section size does not match its count");
+
+                object->lines = section;
+                numberOfLines = count;
+                break;
+            default:
+                // Unknown sections are skipped, for forward compatibility
+                break;
+        }
+    }
+
+    if(!object->code)
+        return rejectObject(object, "no code section");
+
+    // Lines are per instruction
+    if(object->lines && numberOfLines != object->numOfIns)
+        return rejectObject(object, "line section does not cover the code");
+
+    return 0;
+}
+
+void unmapObject(PM0Object* object)
+{
+    if(object->data)
+        munmap((void*)object->data, object->size);
+
+    memset(object, 0, sizeof(PM0Object));
+}
+
+int decodeObjectCode(PM0Object* object, Instruction* ins, int maxIns)
+{
+    int count = object->numOfIns < maxIns ? object->numOfIns : maxIns;
+
+    if(object->codeType == PM0_SECTION_CODE4)
+    {
+        for(int i = 0; i < count; i++)
+        {
+            unsigned int w = readU32(object->code + 4 * i);
+
+            ins[i].op = w & 0x1F;
+            ins[i].r  = (w >> 5) & 0xF;
+            ins[i].l  = (w >> 9) & 0x7;
+            ins[i].m  = signExtend(w >> 12, 20);
+        }
+    }
+    else
+    {
+        for(int i = 0; i < count; i++)
+        {
+            const unsigned char* p = object->code + sizeof(PM0Instruction8) * i;
+
+            ins[i].op = p[0];
+            ins[i].r  = p[1];
+            ins[i].l  = signExtend(readU16(p + 2), 16);
+            ins[i].m  = (int)readU32(p + 4);
+        }
+    }
+
+    return count;
+}
+
+int getObjectSymbol(PM0Object* object, int i, PM0Symbol* sym)
+{
+    if(i < 0 || i >= object->numberOfSymbols)
+        return 0;
+
+    const unsigned char* p = object->symbols + sizeof(PM0Symbol) * i;
+
+    memcpy(sym->name, p, sizeof(sym->name));
+    sym->name[sizeof(sym->name) - 1] = '\0';
+    sym->level = (int)readU32(p + 12);
+    sym->address = (int)readU32(p + 16);
+
+    return 1;
+}
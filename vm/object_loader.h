@@ -0,0 +1,61 @@
+#ifndef __OBJECT_LOADER_H__
+#define __OBJECT_LOADER_H__
+
+#include <stdio.h>
+#include <stddef.h>
+#include "data.h"
+#include "object_format.h"
+
+/**
+ * A program in the binary object format, see object_format.h, memory-mapped
+ * .. from its file. The sections point into the mapping, NULL if the
+ * .. optional ones are missing.
+ * */
+typedef struct {
+    const unsigned char* data;
+    size_t size;
+
+    /**
+     * The code section, codeType is either PM0_SECTION_CODE4 or
+     * .. PM0_SECTION_CODE8.
+     * */
+    const unsigned char* code;
+    int codeType;
+    int numOfIns;
+
+    const unsigned char* symbols;
+    int numberOfSymbols;
+
+    /**
+     * Source line of each instruction, for debuggers and other tools.
+     * */
+    const unsigned char* lines;
+} PM0Object;
+
+/**
+ * Maps the object file the stream is opened on, and validates its header and
+ * .. section table, and that its code fits in MAX_CODE_LENGTH instructions.
+ * Returns 0 if mapped, 1 if the stream is not an object file - which is then
+ * .. left as it is, to be read as text - and -1 if it is an invalid object
+ * .. file, after printing the reason to stderr.
+ * */
+int mapObject(FILE*, PM0Object*);
+
+/**
+ * Unmaps the object.
+ * */
+void unmapObject(PM0Object*);
+
+/**
+ * Decodes the instructions of the object to ins, which can hold maxIns of
+ * .. them. Returns the number of instructions decoded.
+ * */
+int decodeObjectCode(PM0Object*, Instruction* ins, int maxIns);
+
+/**
+ * Reads the i'th symbol of the object to sym. Returns 0 if there is no such
+ * .. symbol.
+ * */
+int getObjectSymbol(PM0Object*, int i, PM0Symbol* sym);
+
+#endif
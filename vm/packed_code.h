@@ -0,0 +1,64 @@
+#ifndef __PACKED_CODE_H__
+#define __PACKED_CODE_H__
+
+#include <stdint.h>
+#include "data.h"
+#include "object_format.h"
+
+/**
+ * An instruction packed into 32 bits, the layout of the code memory the
+ * .. interpreter fetches from. A quarter of the size of an Instruction, so
+ * .. that the code shares the caches with the stack rather than pushing it
+ * .. out.
+ * The layout is the 4 byte encoding of the object format, see
+ * .. object_format.h: op in bits 0 - 4, r in 5 - 8, l in 9 - 11 and m, in
+ * .. two's complement, in 12 - 31.
+ *
+ * The functions are defined here, rather than in a source file, so that
+ * .. unpacking is inlined into the fetch of the interpreter loop.
+ * */
+typedef uint32_t PackedInstruction;
+
+/**
+ * Packs the instruction to packed. Returns 0 if it does not fit in 32 bits.
+ * */
+static inline int packInstruction(Instruction ins, PackedInstruction* packed)
+{
+    if(ins.op < 0 || ins.op > PM0_CODE4_MAX_OP || ins.r < 0 || ins.r > PM0_CODE4_MAX_R ||
+       ins.l < 0 || ins.l > PM0_CODE4_MAX_L || ins.m < PM0_CODE4_MIN_M || ins.m > PM0_CODE4_MAX_M)
+        return 0;
+
+    *packed = (uint32_t)ins.op | (uint32_t)ins.r << 5 | (uint32_t)ins.l << 9 | ((uint32_t)ins.m & 0xFFFFF) << 12;
+    return 1;
+}
+
+static inline Instruction unpackInstruction(PackedInstruction packed)
+{
+    Instruction ins;
+
+    ins.op = packed & 0x1F;
+    ins.r  = (packed >> 5) & 0xF;
+    ins.l  = (packed >> 9) & 0x7;
+
+    // Arithmetic shift of the top 20 bits sign extends m
+    ins.m  = (int32_t)packed >> 12;
+
+    return ins;
+}
+
+/**
+ * Packs numOfIns instructions to packed. Returns 0 if any of them does not
+ * .. fit in 32 bits, in which case the code should be run unpacked.
+ * */
+static inline int packCode(Instruction* ins, int numOfIns, PackedInstruction* packed)
+{
+    for(int i = 0; i < numOfIns; i++)
+    {
+        if(!packInstruction(ins[i], &packed[i]))
+            return 0;
+    }
+
+    return 1;
+}
+
+#endif
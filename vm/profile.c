@@ -0,0 +1,360 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "profile.h"
+
+// Opcode names, defined in vm.c
+extern const char *opcodes[];
+
+// Number of the hottest instructions listed in the report
+#define HOT_INSTRUCTION_COUNT 20
+
+// Size of the buffer holding a folded stack. The stack holds at most
+// .. MAX_STACK_HEIGHT / 4 activation records.
+#define FOLDED_STACK_SIZE (MAX_STACK_HEIGHT / 4 * 16)
+
+/* ************************************************************************************ */
+/* Call tree                                                                            */
+/* ************************************************************************************ */
+
+ProcNode* createProcNode(int address, ProcNode* parent)
+{
+    ProcNode* node = (ProcNode*)malloc(sizeof(ProcNode));
+
+    node->address = address;
+    node->calls = 0;
+    node->self = 0;
+    node->parent = parent;
+    node->children = NULL;
+    node->numberOfChildren = 0;
+
+    return node;
+}
+
+void deleteProcNode(ProcNode* node)
+{
+    if(!node) return;
+
+    for(int i = 0; i < node->numberOfChildren; i++)
+        deleteProcNode(node->children[i]);
+
+    if(node->children) free(node->children);
+    free(node);
+}
+
+/**
+ * Returns the child of the node for the procedure at the given address,
+ * .. creating it if it does not exist.
+ * */
+ProcNode* getChildProcNode(ProcNode* node, int address)
+{
+    for(int i = 0; i < node->numberOfChildren; i++)
+    {
+        if(node->children[i]->address == address)
+            return node->children[i];
+    }
+
+    node->numberOfChildren++;
+    node->children = (ProcNode**)realloc(node->children, node->numberOfChildren * sizeof(ProcNode*));
+    node->children[node->numberOfChildren - 1] = createProcNode(address, node);
+
+    return node->children[node->numberOfChildren - 1];
+}
+
+/* ************************************************************************************ */
+/* Counting                                                                             */
+/* ************************************************************************************ */
+
+void initVMProfile(VMProfile* profile, int numOfIns)
+{
+    profile->numOfIns = numOfIns;
+    profile->total = 0;
+
+    for(int i = 0; i < OPCODE_COUNT; i++)
+        profile->opCounts[i] = 0;
+
+    profile->pcCounts    = (long long*)calloc(numOfIns + 1, sizeof(long long));
+    profile->jpcTaken    = (long long*)calloc(numOfIns + 1, sizeof(long long));
+    profile->jpcNotTaken = (long long*)calloc(numOfIns + 1, sizeof(long long));
+
+    profile->root = createProcNode(-1, NULL);
+    profile->root->calls = 1;
+    profile->current = profile->root;
+
+    profile->procNames = (char**)calloc(numOfIns + 1, sizeof(char*));
+}
+
+void deleteVMProfile(VMProfile* profile)
+{
+    if(!profile) return;
+
+    free(profile->pcCounts);
+    free(profile->jpcTaken);
+    free(profile->jpcNotTaken);
+    deleteProcNode(profile->root);
+
+    for(int i = 0; i <= profile->numOfIns; i++)
+        free(profile->procNames[i]);
+    free(profile->procNames);
+
+    profile->procNames = NULL;
+    profile->pcCounts = profile->jpcTaken = profile->jpcNotTaken = NULL;
+    profile->root = profile->current = NULL;
+}
+
+void setVMProfileProcName(VMProfile* profile, int address, const char* name)
+{
+    if(address < 0 || address > profile->numOfIns) return;
+
+    free(profile->procNames[address]);
+    profile->procNames[address] = (char*)malloc(strlen(name) + 1);
+    strcpy(profile->procNames[address], name);
+}
+
+/**
+ * Returns 1 if op is a conditional jump: JPC or one of the compare-and-branch
+ * .. opcodes JEQ - JGE. Returns 0 otherwise.
+ * */
+int isConditionalJump(int op)
+{
+    return op == 8 || (op >= 25 && op <= 30);
+}
+
+/**
+ * Returns 1 if the conditional jump ins is taken on the virtual machine
+ * */
+int isJumpTaken(VirtualMachine* vm, Instruction ins)
+{
+    int a = vm->RF[ins.r], b = vm->RF[ins.l];
+
+    switch(ins.op)
+    {
+        case 8:  return a == 0;
+        case 25: return a == b;
+        case 26: return a != b;
+        case 27: return a < b;
+        case 28: return a <= b;
+        case 29: return a > b;
+        case 30: return a >= b;
+        default: return 0;
+    }
+}
+
+void profileInstruction(VMProfile* profile, VirtualMachine* vm, Instruction ins, int pc)
+{
+    profile->total++;
+    profile->current->self++;
+
+    if(ins.op >= 0 && ins.op < OPCODE_COUNT)
+        profile->opCounts[ins.op]++;
+
+    if(pc < 0 || pc >= profile->numOfIns)
+        return;
+
+    profile->pcCounts[pc]++;
+
+    switch(ins.op)
+    {
+        case 2:
+            //RTN
+            if(profile->current->parent)
+                profile->current = profile->current->parent;
+            break;
+        case 5:
+            //CAL
+            profile->current = getChildProcNode(profile->current, ins.m);
+            profile->current->calls++;
+            break;
+        case 8:
+        case 25: case 26: case 27: case 28: case 29: case 30:
+            //JPC and JEQ - JGE, which do not change the registers they test
+            if(isJumpTaken(vm, ins)) profile->jpcTaken[pc]++;
+            else                     profile->jpcNotTaken[pc]++;
+            break;
+    }
+}
+
+/* ************************************************************************************ */
+/* Output                                                                               */
+/* ************************************************************************************ */
+
+/**
+ * Per procedure totals over the call tree. total includes the instructions
+ * .. executed in the callees, counting recursive calls once.
+ * */
+typedef struct {
+    int address;
+    long long calls;
+    long long self;
+    long long total;
+} ProcSummary;
+
+// Returns the number of instructions executed in the subtree of the node
+long long summarizeProcNode(ProcNode* node, ProcSummary** summaries, int* numberOfSummaries)
+{
+    long long total = node->self;
+
+    for(int i = 0; i < node->numberOfChildren; i++)
+        total += summarizeProcNode(node->children[i], summaries, numberOfSummaries);
+
+    ProcSummary* s = NULL;
+    for(int i = 0; i < *numberOfSummaries && !s; i++)
+    {
+        if((*summaries)[i].address == node->address) s = &(*summaries)[i];
+    }
+
+    if(!s)
+    {
+        (*numberOfSummaries)++;
+        *summaries = (ProcSummary*)realloc(*summaries, *numberOfSummaries * sizeof(ProcSummary));
+        s = &(*summaries)[*numberOfSummaries - 1];
+        s->address = node->address;
+        s->calls = s->self = s->total = 0;
+    }
+
+    s->calls += node->calls;
+    s->self += node->self;
+
+    // Recursive calls are already in the total of the outermost call
+    int recursive = 0;
+    for(ProcNode* p = node->parent; p && !recursive; p = p->parent)
+        recursive = p->address == node->address;
+
+    if(!recursive) s->total += total;
+
+    return total;
+}
+
+void procName(VMProfile* profile, char* name, int size, int address)
+{
+    int named = address >= 0 && address <= profile->numOfIns && profile->procNames[address];
+
+    if(address < 0) snprintf(name, size, "main");
+    else if(named)  snprintf(name, size, "%s@%d", profile->procNames[address], address);
+    else            snprintf(name, size, "proc@%d", address);
+}
+
+double percentage(long long count, long long total)
+{
+    return total ? 100.0 * count / total : 0.0;
+}
+
+// Sorts the instruction indices by decreasing execution count
+long long* _sort_counts;
+
+int compareCounts(const void* a, const void* b)
+{
+    long long ca = _sort_counts[*(const int*)a], cb = _sort_counts[*(const int*)b];
+
+    if(ca != cb) return ca < cb ? 1 : -1;
+    return *(const int*)a - *(const int*)b;
+}
+
+void printVMProfileReport(VMProfile* profile, Instruction* ins, FILE* out)
+{
+    if(!profile || !out) return;
+
+    fprintf(out, "***Profile***\n");
+    fprintf(out, "Instructions executed: %lld\n", profile->total);
+
+    // Hottest instructions
+    int* order = (int*)malloc((profile->numOfIns + 1) * sizeof(int));
+    for(int i = 0; i < profile->numOfIns; i++) order[i] = i;
+
+    _sort_counts = profile->pcCounts;
+    qsort(order, profile->numOfIns, sizeof(int), compareCounts);
+
+    fprintf(out, "\n***Hot Instructions***\n%3s %3s %3s %3s %3s %12s %7s \n", "#", "OP", "R", "L", "M", "COUNT", "%");
+    for(int i = 0; i < profile->numOfIns && i < HOT_INSTRUCTION_COUNT && profile->pcCounts[order[i]]; i++)
+    {
+        Instruction c = ins[order[i]];
+        long long count = profile->pcCounts[order[i]];
+
+        fprintf(out, "%3d %3s %3d %3d %3d %12lld %7.2f \n",
+            order[i], c.op >= 0 && c.op < OPCODE_COUNT ? opcodes[c.op] : "???", c.r, c.l, c.m,
+            count, percentage(count, profile->total));
+    }
+
+    free(order);
+
+    // Opcode histogram
+    fprintf(out, "\n***Opcodes***\n%7s %12s %7s \n", "OP", "COUNT", "%");
+    for(int op = 0; op < OPCODE_COUNT; op++)
+    {
+        if(profile->opCounts[op])
+            fprintf(out, "%4s %2d %12lld %7.2f \n", opcodes[op], op, profile->opCounts[op], percentage(profile->opCounts[op], profile->total));
+    }
+
+    // Procedures
+    ProcSummary* summaries = NULL;
+    int numberOfSummaries = 0;
+    summarizeProcNode(profile->root, &summaries, &numberOfSummaries);
+
+    fprintf(out, "\n***Procedures***\n%-10s %12s %12s %12s %7s \n", "PROC", "CALLS", "SELF", "TOTAL", "%");
+    for(int i = 0; i < numberOfSummaries; i++)
+    {
+        ProcSummary s = summaries[i];
+        char name[32];
+
+        procName(profile, name, sizeof(name), s.address);
+        fprintf(out, "%-10s %12lld %12lld %12lld %7.2f \n", name, s.calls, s.self, s.total, percentage(s.total, profile->total));
+    }
+
+    free(summaries);
+
+    // Loops, found by their backward jumps
+    fprintf(out, "\n***Loops***\n%6s %6s %12s %12s %7s \n", "HEAD", "TAIL", "ITERATIONS", "BODY", "%");
+    for(int i = 0; i < profile->numOfIns; i++)
+    {
+        if((ins[i].op != 7 && !isConditionalJump(ins[i].op)) || ins[i].m < 0 || ins[i].m > i || !profile->pcCounts[i])
+            continue;
+
+        long long body = 0;
+        for(int j = ins[i].m; j <= i; j++)
+            body += profile->pcCounts[j];
+
+        // A loop testing its condition at the bottom iterates when the jump is taken
+        long long iterations = ins[i].op == 7 ? profile->pcCounts[i] : profile->jpcTaken[i];
+
+        fprintf(out, "%6d %6d %12lld %12lld %7.2f \n", ins[i].m, i, iterations, body, percentage(body, profile->total));
+    }
+
+    // Branches
+    fprintf(out, "\n***Branches***\n%3s %3s %12s %12s \n", "#", "M", "TAKEN", "NOT TAKEN");
+    for(int i = 0; i < profile->numOfIns; i++)
+    {
+        if(isConditionalJump(ins[i].op) && (profile->jpcTaken[i] || profile->jpcNotTaken[i]))
+            fprintf(out, "%3d %3d %12lld %12lld \n", i, ins[i].m, profile->jpcTaken[i], profile->jpcNotTaken[i]);
+    }
+}
+
+/**
+ * Prints the folded stack lines of the subtree of the node. path is the
+ * .. folded stack of the parent.
+ * */
+void printFoldedProcNode(VMProfile* profile, ProcNode* node, char* path, int pathLength, FILE* out)
+{
+    // Names are at most an identifier and "@" followed by an int
+    char name[32];
+    procName(profile, name, sizeof(name), node->address);
+
+    int length = pathLength + snprintf(path + pathLength, FOLDED_STACK_SIZE - pathLength, "%s%s", pathLength ? ";" : "", name);
+    if(length >= FOLDED_STACK_SIZE) length = FOLDED_STACK_SIZE - 1;
+
+    if(node->self)
+        fprintf(out, "%s %lld\n", path, node->self);
+
+    for(int i = 0; i < node->numberOfChildren; i++)
+        printFoldedProcNode(profile, node->children[i], path, length, out);
+
+    path[pathLength] = '\0';
+}
+
+void printVMProfileFolded(VMProfile* profile, FILE* out)
+{
+    if(!profile || !out) return;
+
+    char* path = (char*)calloc(FOLDED_STACK_SIZE, 1);
+    printFoldedProcNode(profile, profile->root, path, 0, out);
+    free(path);
+}
@@ -0,0 +1,104 @@
+#ifndef __PROFILE_H__
+#define __PROFILE_H__
+
+#include <stdio.h>
+#include "data.h"
+
+/**
+ * Number of opcodes, including the illegal opcode 0.
+ * */
+#define OPCODE_COUNT 32
+
+/**
+ * A node of the call tree: a procedure reached through a certain path of
+ * .. calls from the main block. Procedures are identified by their entry
+ * .. address, i.e. the target of the CAL instructions calling them.
+ * */
+typedef struct ProcNode {
+    /**
+     * Entry address of the procedure, -1 for the main block.
+     * */
+    int address;
+
+    /**
+     * Number of calls and number of instructions executed in the procedure
+     * .. itself on this path.
+     * */
+    long long calls;
+    long long self;
+
+    struct ProcNode* parent;
+    struct ProcNode** children;
+    int numberOfChildren;
+} ProcNode;
+
+/**
+ * Execution counts collected while simulating.
+ * */
+typedef struct {
+    int numOfIns;
+
+    /**
+     * Total number of executed instructions, and per opcode.
+     * */
+    long long total;
+    long long opCounts[OPCODE_COUNT];
+
+    /**
+     * Number of executions of each instruction, and for the conditional
+     * .. jumps - JPC and the compare-and-branch instructions - the number of
+     * .. times the jump was taken and not taken.
+     * */
+    long long* pcCounts;
+    long long* jpcTaken;
+    long long* jpcNotTaken;
+
+    /**
+     * The call tree, and the node of the procedure being executed.
+     * */
+    ProcNode* root;
+    ProcNode* current;
+
+    /**
+     * Name of the procedure at each address, NULL if not known.
+     * */
+    char** procNames;
+} VMProfile;
+
+/**
+ * Initializes an empty profile of a program of numOfIns instructions.
+ * */
+void initVMProfile(VMProfile*, int numOfIns);
+
+/**
+ * Makes the necessary deallocations on the profile.
+ * */
+void deleteVMProfile(VMProfile*);
+
+/**
+ * Names the procedure whose entry address is the given address in the
+ * .. reports, which otherwise only show its address.
+ * */
+void setVMProfileProcName(VMProfile*, int address, const char* name);
+
+/**
+ * Counts the instruction ins at index pc, which has just been executed
+ * .. on the given virtual machine.
+ * */
+void profileInstruction(VMProfile*, VirtualMachine*, Instruction ins, int pc);
+
+/**
+ * Writes a human readable report: the hottest instructions, the opcode
+ * .. histogram, the instructions executed per procedure, the loops - found
+ * .. by their backward jumps - and the conditional jump statistics.
+ * */
+void printVMProfileReport(VMProfile*, Instruction* ins, FILE*);
+
+/**
+ * Writes the instructions executed per call path in folded stack format,
+ * .. one "main;proc@5;proc@12 count" line per path, which the flamegraph
+ * .. tools accept.
+ * */
+void printVMProfileFolded(VMProfile*, FILE*);
+
+#endif
@@ -0,0 +1,194 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <pthread.h>
+#include "runner.h"
+#include "vm.h"
+#include "vmio.h"
+#include "object_loader.h"
+#include "verifier.h"
+
+// Defined in vm.c
+void initVM(VirtualMachine*);
+int readInstructions(FILE*, Instruction*);
+int executeInstruction(VirtualMachine* vm, Instruction ins, VMIO* io);
+int getHaltStatus(int halt);
+long long elapsedMillis(struct timespec* start);
+
+enum { CONT, HALT, STACK_OVERFLOW, DIVISION_ERROR };
+
+int loadVMProgram(VMProgram* program, FILE* inp, int jit)
+{
+    program->numOfIns = 0;
+    program->packed = 0;
+    program->jitted = 0;
+
+    PM0Object object;
+    int notObject = mapObject(inp, &object);
+
+    if(notObject < 0)
+        return -1;
+
+    if(notObject)
+    {
+        program->numOfIns = readInstructions(inp, program->code);
+    }
+    else
+    {
+        program->numOfIns = decodeObjectCode(&object, program->code, MAX_CODE_LENGTH);
+        unmapObject(&object);
+    }
+
+    if(program->numOfIns < 0 || verifyCode(program->code, program->numOfIns))
+    {
+        program->numOfIns = 0;
+        return -1;
+    }
+
+    program->packed = packCode(program->code, program->numOfIns, program->packedCode);
+    program->jitted = jit && !jitCompile(&program->jit, program->code, program->numOfIns);
+
+    return 0;
+}
+
+void deleteVMProgram(VMProgram* program)
+{
+    if(program->jitted) jitDelete(&program->jit);
+    program->jitted = 0;
+}
+
+int runVMProgram(VMProgram* program, FILE* vm_inp, FILE* vm_outp, int mapInput, long long maxInstructions, long long maxMillis, long long* executed)
+{
+    // Too large for the stacks of the threads
+    VirtualMachine* vm = (VirtualMachine*)malloc(sizeof(VirtualMachine));
+    initVM(vm);
+
+    VMIO io;
+    initVMIO(&io, vm_inp, vm_outp, mapInput);
+
+    int budgeted = maxInstructions || maxMillis;
+    struct timespec start;
+    if(maxMillis) clock_gettime(CLOCK_MONOTONIC, &start);
+
+    long long count = 0;
+    int halt = CONT, status = VM_HALTED;
+
+    while(halt == CONT && !(vm->PC == 0 && vm->BP == 0 && vm->SP == 0))
+    {
+        // Run natively until reaching an instruction left to the interpreter.
+        // .. The verified code keeps PC in the code.
+        if(program->jitted && !budgeted && vm->BP != 0)
+        {
+            jitRun(&program->jit, vm);
+
+            if(vm->PC == 0 && vm->BP == 0 && vm->SP == 0)
+                break;
+        }
+
+        // Stop if a budget runs out
+        if(maxInstructions && count >= maxInstructions)
+            status = VM_INSTRUCTION_BUDGET_EXCEEDED;
+        else if(maxMillis && !(count & (VM_TIME_CHECK_INTERVAL - 1)) && elapsedMillis(&start) >= maxMillis)
+            status = VM_TIME_BUDGET_EXCEEDED;
+
+        if(status != VM_HALTED) break;
+
+        //Fetch
+        vm->IR = vm->PC;
+        Instruction cur = program->packed ? unpackInstruction(program->packedCode[vm->PC]) : program->code[vm->PC];
+        vm->PC++;
+
+        //Execute
+        halt = executeInstruction(vm, cur, &io);
+        count++;
+
+        status = getHaltStatus(halt);
+    }
+
+    deleteVMIO(&io);
+    free(vm);
+
+    *executed = count;
+    return status;
+}
+
+/**
+ * State shared by the threads of a batch: the next job to run is taken
+ * .. under the lock.
+ * */
+typedef struct {
+    VMProgram* program;
+    VMJob* jobs;
+    int numberOfJobs;
+    int nextJob;
+    int mapInput;
+    pthread_mutex_t lock;
+} VMBatch;
+
+/**
+ * Runs the jobs of the batch until none is left
+ * */
+void* runVMBatchThread(void* arg)
+{
+    VMBatch* batch = (VMBatch*)arg;
+
+    while(1)
+    {
+        pthread_mutex_lock(&batch->lock);
+        int i = batch->nextJob++;
+        pthread_mutex_unlock(&batch->lock);
+
+        if(i >= batch->numberOfJobs)
+            break;
+
+        VMJob* job = &batch->jobs[i];
+        FILE* in = fopen(job->inputPath, "r");
+        FILE* out = fopen(job->outputPath, "w");
+
+        job->executed = 0;
+        job->status = -1;
+
+        if(in && out)
+            job->status = runVMProgram(batch->program, in, out, batch->mapInput, job->maxInstructions, job->maxMillis, &job->executed);
+
+        if(in) fclose(in);
+        if(out) fclose(out);
+    }
+
+    return NULL;
+}
+
+int runVMBatch(VMProgram* program, VMJob* jobs, int numberOfJobs, int numberOfThreads, int mapInput)
+{
+    VMBatch batch = { .program = program, .jobs = jobs, .numberOfJobs = numberOfJobs, .nextJob = 0, .mapInput = mapInput };
+    pthread_mutex_init(&batch.lock, NULL);
+
+    if(numberOfThreads < 1) numberOfThreads = 1;
+    if(numberOfThreads > numberOfJobs) numberOfThreads = numberOfJobs;
+
+    // The calling thread is one of the threads
+    pthread_t* threads = (pthread_t*)malloc((numberOfThreads + 1) * sizeof(pthread_t));
+    int numberOfStarted = 0;
+
+    for(int i = 1; i < numberOfThreads; i++)
+    {
+        if(!pthread_create(&threads[numberOfStarted], NULL, runVMBatchThread, &batch))
+            numberOfStarted++;
+    }
+
+    runVMBatchThread(&batch);
+
+    for(int i = 0; i < numberOfStarted; i++)
+        pthread_join(threads[i], NULL);
+
+    free(threads);
+    pthread_mutex_destroy(&batch.lock);
+
+    int failed = 0;
+    for(int i = 0; i < numberOfJobs; i++)
+        failed += jobs[i].status != VM_HALTED;
+
+    return failed;
+}
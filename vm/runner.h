@@ -0,0 +1,91 @@
+#ifndef __RUNNER_H__
+#define __RUNNER_H__
+
+#include <stdio.h>
+#include "data.h"
+#include "jit.h"
+#include "packed_code.h"
+
+/**
+ * A program loaded once and run by many virtual machines at the same time.
+ * It is not modified after loadVMProgram(), so the instances share it
+ * .. without locking, each with its own stack and I/O buffers.
+ * */
+typedef struct {
+    Instruction code[MAX_CODE_LENGTH];
+    int numOfIns;
+
+    /**
+     * The packed code memory, see packed_code.h, if all the instructions
+     * .. fit in it.
+     * */
+    PackedInstruction packedCode[MAX_CODE_LENGTH];
+    int packed;
+
+    /**
+     * The native code of the program, if it is compiled by the JIT. The
+     * .. native code keeps its state in the virtual machine it runs on, so
+     * .. it is shared as well.
+     * */
+    JitCode jit;
+    int jitted;
+} VMProgram;
+
+/**
+ * Loads the program from the given file, in the text or the object format,
+ * .. and compiles it to native code if jit is nonzero and the JIT is
+ * .. available.
+ * Returns 0 on success, -1 if the file is not a valid program. The code is
+ * .. verified by verifyCode(), see verifier.h, so that the instances run it
+ * .. without checking the instructions.
+ * */
+int loadVMProgram(VMProgram*, FILE*, int jit);
+
+/**
+ * Makes the necessary deallocations on the program.
+ * */
+void deleteVMProgram(VMProgram*);
+
+/**
+ * Runs the program on a new virtual machine, attached to the given input and
+ * .. output streams. The execution history is not kept.
+ * maxInstructions and maxMillis are the budgets of the run, as in VMOptions,
+ * .. see vm.h, 0 meaning no limit. They are enforced by the interpreter, so
+ * .. a budgeted run does not use the native code.
+ * Returns the status of the run, see vm.h: VM_HALTED, or the reason it
+ * .. stopped before halting. Sets executed to the number of instructions
+ * .. interpreted. Instructions run natively are not counted.
+ * */
+int runVMProgram(VMProgram*, FILE* vm_inp, FILE* vm_outp, int mapInput, long long maxInstructions, long long maxMillis, long long* executed);
+
+/**
+ * A run of the program over an input file, writing to an output file.
+ * */
+typedef struct {
+    const char* inputPath;
+    const char* outputPath;
+
+    /**
+     * Budgets of the run, see runVMProgram(), 0 meaning no limit
+     * */
+    long long maxInstructions;
+    long long maxMillis;
+
+    /**
+     * Set by runVMBatch(): the status runVMProgram() returned, which is
+     * .. VM_HALTED, 0, if the run completed, or -1 if the files could not be
+     * .. opened. executed is the number of instructions it interpreted.
+     * */
+    int status;
+    long long executed;
+} VMJob;
+
+/**
+ * Runs the program for each of the jobs, on numberOfThreads threads. A job
+ * .. stopped before halting, by a budget, a stack overflow or a division by
+ * .. zero, fails without affecting the others.
+ * Returns the number of the jobs that failed.
+ * */
+int runVMBatch(VMProgram*, VMJob* jobs, int numberOfJobs, int numberOfThreads, int mapInput);
+
+#endif
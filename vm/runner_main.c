@@ -0,0 +1,219 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "runner.h"
+#include "vm.h"
+
+/**
+ * Returns the path of the output of the run over the input at inputPath:
+ * .. the input path followed by ".out", or the file of the same name in
+ * .. outDir if outDir is not NULL.
+ * */
+char* getOutputPath(const char* inputPath, const char* outDir)
+{
+    char* path;
+
+    if(outDir)
+    {
+        const char* name = strrchr(inputPath, '/');
+        name = name ? name + 1 : inputPath;
+
+        path = (char*)malloc(strlen(outDir) + strlen(name) + 2);
+        sprintf(path, "%s/%s", outDir, name);
+    }
+    else
+    {
+        path = (char*)malloc(strlen(inputPath) + 5);
+        sprintf(path, "%s.out", inputPath);
+    }
+
+    return path;
+}
+
+/**
+ * Reports to stderr why the job failed
+ * */
+void reportFailedJob(VMJob* job, long long maxInstructions, long long maxMillis)
+{
+    if(job->status == VM_INSTRUCTION_BUDGET_EXCEEDED)
+        fprintf(stderr, "The run over \"%s\" stopped: instruction budget of %lld exceeded\n", job->inputPath, maxInstructions);
+    else if(job->status == VM_TIME_BUDGET_EXCEEDED)
+        fprintf(stderr, "The run over \"%s\" stopped: time budget of %lld ms exceeded\n", job->inputPath, maxMillis);
+    else if(job->status == VM_STACK_OVERFLOW)
+        fprintf(stderr, "The run over \"%s\" stopped: stack overflow, more than MAX_STACK_HEIGHT(%d) slots needed\n", job->inputPath, MAX_STACK_HEIGHT);
+    else if(job->status == VM_DIVISION_ERROR)
+        fprintf(stderr, "The run over \"%s\" stopped: division by zero, or of INT_MIN by -1\n", job->inputPath);
+    else
+        fprintf(stderr, "Could not run over \"%s\"\n", job->inputPath);
+}
+
+int main(int argc, char **argv)
+{
+    int jit = 0, mapInput = 0;
+    long long maxInstructions = 0, maxMillis = 0;
+    int numberOfThreads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    const char* outDir = NULL;
+
+    // Options precede the file arguments
+    int argsOk = 1;
+    while(argc > 1 && argsOk && argv[1][0] == '-' && argv[1][1])
+    {
+        if(!strcmp(argv[1], "-j"))
+        {
+            jit = 1;
+        }
+        else if(!strcmp(argv[1], "-m"))
+        {
+            mapInput = 1;
+        }
+        else if(!strcmp(argv[1], "-n") && argc > 2)
+        {
+            numberOfThreads = atoi(argv[2]);
+            argc--;
+            argv++;
+        }
+        else if(!strcmp(argv[1], "-i") && argc > 2)
+        {
+            maxInstructions = atoll(argv[2]);
+            argc--;
+            argv++;
+        }
+        else if(!strcmp(argv[1], "-t") && argc > 2)
+        {
+            maxMillis = atoll(argv[2]);
+            argc--;
+            argv++;
+        }
+        else if(!strcmp(argv[1], "-o") && argc > 2)
+        {
+            outDir = argv[2];
+            argc--;
+            argv++;
+        }
+        else
+        {
+            argsOk = 0;
+        }
+
+        argc--;
+        argv++;
+    }
+
+    if(!argsOk || argc < 3)
+    {
+        fprintf(stderr, "Usage: runner.out [-j] [-m] [-n threads] [-i max_instructions] [-t max_milliseconds] [-o out_dir] (ins_inp_file) (vm_inp_file)...\n");
+
+        fprintf(stderr, "\n\tRuns the instructions once over each vm_inp_file, loading them only once and"
+                        "\n\tsharing them between the runs, which are made on a pool of threads. The"
+                        "\n\toutput of the SIO instructions of each run is written to vm_inp_file.out.\n");
+
+        fprintf(stderr, "\n\t-j  Compile the instructions to native code once, and run them natively where possible.\n");
+
+        fprintf(stderr, "\n\t-m  Memory-map the vm_inp_files instead of reading them.\n");
+
+        fprintf(stderr, "\n\t-n threads  The number of threads. Default is the number of processors.\n");
+
+        fprintf(stderr, "\n\t-i max_instructions  Stop each run after executing max_instructions instructions.\n");
+
+        fprintf(stderr, "\n\t-t max_milliseconds  Stop each run after running for max_milliseconds milliseconds."
+                        "\n\tThe budgets are checked by the interpreter, so they disable -j. A run stopped by"
+                        "\n\t-i or -t, by a stack overflow or by a division by zero fails, and is reported to"
+                        "\n\tstderr, while the other runs go on. The exit status is nonzero if a run failed.\n");
+
+        fprintf(stderr, "\n\t-o out_dir  Write the outputs to out_dir, under the names of the vm_inp_files.\n");
+
+        fprintf(stderr, "\n\tins_inp_file  The path to the file containing the list of instructions, either as"
+                        "\n\t              PM/0 assembly text or in the binary object format.\n");
+        return -1;
+    }
+
+    FILE* inp = fopen(argv[1], "rb");
+    if(!inp)
+    {
+        fprintf(stderr, "Could not open \"%s\"\n", argv[1]);
+        return -1;
+    }
+
+    VMProgram* program = (VMProgram*)malloc(sizeof(VMProgram));
+    int err = loadVMProgram(program, inp, jit);
+    fclose(inp);
+
+    if(err)
+    {
+        fprintf(stderr, "Could not load \"%s\"\n", argv[1]);
+        free(program);
+        return -1;
+    }
+
+    int numberOfJobs = argc - 2;
+    VMJob* jobs = (VMJob*)malloc(numberOfJobs * sizeof(VMJob));
+
+    int numberOfJobsOk = 0;
+    for(int i = 0; i < numberOfJobs; i++)
+    {
+        jobs[i].inputPath = argv[i + 2];
+        jobs[i].outputPath = getOutputPath(argv[i + 2], outDir);
+        jobs[i].maxInstructions = maxInstructions;
+        jobs[i].maxMillis = maxMillis;
+
+        // The input would be truncated by opening the output
+        if(!strcmp(jobs[i].inputPath, jobs[i].outputPath))
+            fprintf(stderr, "The output of \"%s\" would overwrite it\n", jobs[i].inputPath);
+        else
+            numberOfJobsOk++;
+    }
+
+    if(numberOfJobsOk < numberOfJobs)
+    {
+        for(int i = 0; i < numberOfJobs; i++)
+            free((char*)jobs[i].outputPath);
+
+        free(jobs);
+        deleteVMProgram(program);
+        free(program);
+        return -1;
+    }
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    int failed = runVMBatch(program, jobs, numberOfJobs, numberOfThreads, mapInput);
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+
+    // Aggregate throughput
+    long long executed = 0;
+    for(int i = 0; i < numberOfJobs; i++)
+    {
+        if(jobs[i].status != VM_HALTED)
+            reportFailedJob(&jobs[i], maxInstructions, maxMillis);
+
+        executed += jobs[i].executed;
+        free((char*)jobs[i].outputPath);
+    }
+
+    if(numberOfThreads < 1) numberOfThreads = 1;
+    if(numberOfThreads > numberOfJobs) numberOfThreads = numberOfJobs;
+
+    printf("runs                 : %d (%d failed)\n", numberOfJobs, failed);
+    printf("threads              : %d\n", numberOfThreads);
+    printf("time                 : %.3f s\n", seconds);
+    printf("runs/s               : %.1f\n", seconds > 0 ? numberOfJobs / seconds : 0.0);
+    // Native execution is not counted
+    if(!program->jitted || maxInstructions || maxMillis)
+    {
+        printf("instructions         : %lld\n", executed);
+        printf("instructions/s       : %.0f\n", seconds > 0 ? executed / seconds : 0.0);
+    }
+
+    free(jobs);
+    deleteVMProgram(program);
+    free(program);
+
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,121 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "snapshot.h"
+
+#define VM_SNAPSHOT_HEADER "PM0-SNAPSHOT-1"
+
+unsigned long long hashVMCode(Instruction* ins, int numOfIns)
+{
+    // FNV-1a over the fields of the instructions
+    unsigned long long hash = 0xcbf29ce484222325ULL;
+
+    for(int i = 0; i < numOfIns; i++)
+    {
+        int fields[4] = { ins[i].op, ins[i].r, ins[i].l, ins[i].m };
+
+        for(int j = 0; j < 4; j++)
+        {
+            hash ^= (unsigned int)fields[j];
+            hash *= 0x100000001b3ULL;
+        }
+    }
+
+    return hash;
+}
+
+/**
+ * Reads the next word of the file, returns 1 if it is the given label
+ * */
+int readLabel(FILE* in, const char* label)
+{
+    char word[16];
+    return fscanf(in, "%15s", word) == 1 && !strcmp(word, label);
+}
+
+void printVMSnapshot(VMSnapshot* snapshot, FILE* out)
+{
+    VirtualMachine* vm = &snapshot->vm;
+
+    fprintf(out, "%s\n", VM_SNAPSHOT_HEADER);
+    fprintf(out, "code %d %llx\n", snapshot->numOfIns, snapshot->codeHash);
+    fprintf(out, "io %lld %lld\n", snapshot->inputPosition, snapshot->outputPosition);
+    fprintf(out, "registers %d %d %d %d\n", vm->BP, vm->SP, vm->PC, vm->IR);
+
+    fprintf(out, "rf");
+    for(int i = 0; i < REGISTER_FILE_REG_COUNT; i++)
+        fprintf(out, " %d", vm->RF[i]);
+    fprintf(out, "\n");
+
+    // Slots above the last nonzero one are zero since initVM()
+    int stackHeight = MAX_STACK_HEIGHT;
+    while(stackHeight > 0 && !vm->stack[stackHeight - 1])
+        stackHeight--;
+
+    fprintf(out, "stack %d\n", stackHeight);
+    for(int i = 0; i < stackHeight; i++)
+        fprintf(out, "%d%c", vm->stack[i], i % 16 == 15 || i == stackHeight - 1 ? '\n' : ' ');
+}
+
+int readVMSnapshot(VMSnapshot* snapshot, FILE* in)
+{
+    VirtualMachine* vm = &snapshot->vm;
+    char header[32];
+    int stackHeight;
+
+    memset(snapshot, 0, sizeof(VMSnapshot));
+
+    if(fscanf(in, "%31s", header) != 1 || strcmp(header, VM_SNAPSHOT_HEADER))
+        return 0;
+
+    if(!readLabel(in, "code") || fscanf(in, "%d %llx", &snapshot->numOfIns, &snapshot->codeHash) != 2 ||
+       !readLabel(in, "io") || fscanf(in, "%lld %lld", &snapshot->inputPosition, &snapshot->outputPosition) != 2 ||
+       !readLabel(in, "registers") || fscanf(in, "%d %d %d %d", &vm->BP, &vm->SP, &vm->PC, &vm->IR) != 4 ||
+       !readLabel(in, "rf"))
+        return 0;
+
+    for(int i = 0; i < REGISTER_FILE_REG_COUNT; i++)
+    {
+        if(fscanf(in, "%d", &vm->RF[i]) != 1)
+            return 0;
+    }
+
+    if(!readLabel(in, "stack") || fscanf(in, "%d", &stackHeight) != 1 || stackHeight < 0 || stackHeight > MAX_STACK_HEIGHT)
+        return 0;
+
+    for(int i = 0; i < stackHeight; i++)
+    {
+        if(fscanf(in, "%d", &vm->stack[i]) != 1)
+            return 0;
+    }
+
+    return 1;
+}
+
+int saveVMSnapshot(VMSnapshot* snapshot, const char* path)
+{
+    char* tmpPath = (char*)malloc(strlen(path) + 5);
+    sprintf(tmpPath, "%s.tmp", path);
+
+    FILE* out = fopen(tmpPath, "w");
+    if(!out)
+    {
+        free(tmpPath);
+        return -1;
+    }
+
+    printVMSnapshot(snapshot, out);
+
+    // The snapshot should be on the disk before it replaces the previous one
+    int ok = !ferror(out) && !fflush(out) && !fsync(fileno(out));
+    ok = !fclose(out) && ok;
+    ok = ok && !rename(tmpPath, path);
+
+    if(!ok) remove(tmpPath);
+    free(tmpPath);
+
+    return ok ? 0 : -1;
+}
@@ -0,0 +1,47 @@
+#ifndef __SNAPSHOT_H__
+#define __SNAPSHOT_H__
+
+#include <stdio.h>
+#include "data.h"
+
+/**
+ * State of a simulation at an instruction boundary: the virtual machine,
+ * .. and the positions of its I/O streams, see seekVMIO() of vmio.h.
+ * Snapshots are tied to the code they are taken on, by its length and hash.
+ * */
+typedef struct {
+    int numOfIns;
+    unsigned long long codeHash;
+
+    long long inputPosition;
+    long long outputPosition;
+
+    VirtualMachine vm;
+} VMSnapshot;
+
+/**
+ * Returns the hash of the code, which a snapshot should match to be resumed
+ * .. on the code.
+ * */
+unsigned long long hashVMCode(Instruction* ins, int numOfIns);
+
+/**
+ * Writes the snapshot to the given file. Only the used part of the stack, up
+ * .. to the last nonzero slot, is written.
+ * */
+void printVMSnapshot(VMSnapshot*, FILE*);
+
+/**
+ * Reads the snapshot from the given file, in the format printVMSnapshot()
+ * .. prints. Returns 1 on success, 0 if the file is not a valid snapshot.
+ * */
+int readVMSnapshot(VMSnapshot*, FILE*);
+
+/**
+ * Writes the snapshot to the file at path, replacing it atomically: the
+ * .. snapshot is written to a temporary file next to it first, which is then
+ * .. renamed to path. Returns 0 on success, -1 on failure.
+ * */
+int saveVMSnapshot(VMSnapshot*, const char* path);
+
+#endif
@@ -0,0 +1,198 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "stack_trace.h"
+
+// Defined in vm.c
+void dumpStack(FILE*, int* stack, int sp, int bp);
+int getBasePointer(int *stack, int currentBP, int L);
+
+void initStackTrace(StackTrace* st)
+{
+    // Sign and 10 digits, the separator and the space, for each slot
+    st->capacity = 4 + MAX_STACK_HEIGHT * 15;
+    st->text = (char*)malloc(st->capacity);
+    st->length = 0;
+
+    st->slotOffsets = (size_t*)calloc(MAX_STACK_HEIGHT + 1, sizeof(size_t));
+    st->frames = (int*)malloc(MAX_STACK_HEIGHT * sizeof(int));
+    st->numberOfFrames = 0;
+    st->frameStart = (char*)calloc(MAX_STACK_HEIGHT + 1, 1);
+
+    st->end = 0;
+    st->valid = 0;
+}
+
+void deleteStackTrace(StackTrace* st)
+{
+    free(st->text);
+    free(st->slotOffsets);
+    free(st->frames);
+    free(st->frameStart);
+
+    st->text = NULL;
+    st->slotOffsets = NULL;
+    st->frames = NULL;
+    st->frameStart = NULL;
+}
+
+/**
+ * Finds the activation records again, following the dynamic links down from
+ * .. BP. Returns 0 if they do not form a chain down to the bottom one.
+ * */
+int rebuildFrames(StackTrace* st, VirtualMachine* vm)
+{
+    for(int i = 0; i < st->numberOfFrames; i++)
+        st->frameStart[st->frames[i]] = 0;
+    st->numberOfFrames = 0;
+
+    // From the top, reversed below
+    for(int bp = vm->BP; ; bp = vm->stack[bp + 2])
+    {
+        st->frames[st->numberOfFrames++] = bp;
+
+        if(bp == 1) break;
+
+        if(bp + 2 >= MAX_STACK_HEIGHT || vm->stack[bp + 2] < 1 || vm->stack[bp + 2] >= bp)
+        {
+            st->numberOfFrames = 0;
+            return 0;
+        }
+    }
+
+    for(int i = 0, j = st->numberOfFrames - 1; i < j; i++, j--)
+    {
+        int tmp = st->frames[i];
+        st->frames[i] = st->frames[j];
+        st->frames[j] = tmp;
+    }
+
+    for(int i = 0; i < st->numberOfFrames; i++)
+        st->frameStart[st->frames[i]] = 1;
+
+    return 1;
+}
+
+/**
+ * Renders the slot to buffer, returns the length of the text
+ * */
+int renderSlot(StackTrace* st, VirtualMachine* vm, int slot, char* buffer)
+{
+    return sprintf(buffer, "%s%3d ", st->frameStart[slot] ? "| " : "", vm->stack[slot]);
+}
+
+/**
+ * Removes the text of the slots from the given slot on
+ * */
+void truncateStackTrace(StackTrace* st, int slot)
+{
+    if(slot > st->end) return;
+
+    st->length = st->slotOffsets[slot];
+    st->end = slot - 1;
+}
+
+void printStackTrace(StackTrace* st, VirtualMachine* vm, Instruction ins, FILE* out)
+{
+    // dumpStack() prints nothing
+    if(vm->BP == 0)
+    {
+        st->valid = 0;
+        return;
+    }
+
+    int regular = vm->BP >= 1 && vm->BP < MAX_STACK_HEIGHT && vm->SP >= 0 && vm->SP < MAX_STACK_HEIGHT;
+
+    // The slots from this one on should be rendered again
+    int from = st->end + 1;
+
+    if(regular && !st->valid)
+    {
+        regular = rebuildFrames(st, vm);
+        from = 1;
+    }
+    else if(regular)
+    {
+        int top = st->frames[st->numberOfFrames - 1];
+
+        if(vm->BP == top && ins.op != 5)
+        {
+            // Same activation record
+        }
+        else if(vm->BP > top && vm->BP + 2 < MAX_STACK_HEIGHT && vm->stack[vm->BP + 2] == top)
+        {
+            // CAL
+            st->frames[st->numberOfFrames++] = vm->BP;
+            st->frameStart[vm->BP] = 1;
+            if(vm->BP < from) from = vm->BP;
+        }
+        else if(ins.op != 5 && st->numberOfFrames > 1 && vm->BP == st->frames[st->numberOfFrames - 2])
+        {
+            // RTN
+            st->numberOfFrames--;
+            st->frameStart[top] = 0;
+            if(top < from) from = top;
+        }
+        else
+        {
+            regular = rebuildFrames(st, vm);
+            from = 1;
+        }
+
+        // STO changes a slot, and possibly a dynamic link
+        if(regular && ins.op == 4)
+        {
+            int slot = getBasePointer(vm->stack, vm->BP, ins.l) + ins.m;
+
+            if(slot >= 3 && slot <= MAX_STACK_HEIGHT && st->frameStart[slot - 2] && slot - 2 != 1)
+            {
+                regular = rebuildFrames(st, vm);
+                from = 1;
+            }
+            else if(slot >= 1 && slot < from && slot <= st->end)
+            {
+                char buffer[32];
+                int length = renderSlot(st, vm, slot, buffer);
+
+                size_t next = slot < st->end ? st->slotOffsets[slot + 1] : st->length;
+
+                if(next - st->slotOffsets[slot] == (size_t)length)
+                    memcpy(st->text + st->slotOffsets[slot], buffer, length);
+                else
+                    from = slot;
+            }
+        }
+    }
+
+    if(!regular)
+    {
+        st->valid = 0;
+        dumpStack(out, vm->stack, vm->SP, vm->BP);
+        return;
+    }
+
+    if(!st->valid)
+    {
+        strcpy(st->text, "  0 ");
+        st->length = 4;
+        st->slotOffsets[1] = 4;
+        st->end = 0;
+        st->valid = 1;
+    }
+
+    // Slots 1 .. max(SP, BP - 1) are rendered
+    int end = vm->SP > vm->BP - 1 ? vm->SP : vm->BP - 1;
+
+    truncateStackTrace(st, from);
+    truncateStackTrace(st, end + 1);
+
+    for(int slot = st->end + 1; slot <= end; slot++)
+    {
+        st->slotOffsets[slot] = st->length;
+        st->length += renderSlot(st, vm, slot, st->text + st->length);
+    }
+
+    st->end = end;
+
+    fwrite(st->text, 1, st->length, out);
+}
@@ -0,0 +1,58 @@
+#ifndef __STACK_TRACE_H__
+#define __STACK_TRACE_H__
+
+#include <stdio.h>
+#include <stddef.h>
+#include "data.h"
+
+/**
+ * The stack of the virtual machine rendered as dumpStack() prints it, kept
+ * .. up to date from one instruction to the next instead of being rendered
+ * .. again for every line of the execution history.
+ *
+ * The rendered stack is "  0 " followed by the slots 1 .. max(SP, BP - 1),
+ * .. each printed as "%3d ", and preceded by "| " if an activation record
+ * .. starts at it. The activation records are tracked as CAL pushes and RTN
+ * .. pops them, and each STO changes a single slot. So only the slots whose
+ * .. value or activation record changed are rendered again.
+ * If the dynamic links do not form a chain of activation records, or the
+ * .. registers point out of the stack, the stack is printed by dumpStack().
+ * */
+typedef struct {
+    char* text;
+    size_t length;
+    size_t capacity;
+
+    /**
+     * Offset of the text of each slot, including the "| " preceding it.
+     * */
+    size_t* slotOffsets;
+
+    /**
+     * Base pointers of the activation records from the bottom one, and
+     * .. whether an activation record starts at each slot.
+     * */
+    int* frames;
+    int numberOfFrames;
+    char* frameStart;
+
+    /**
+     * The last rendered slot. valid is 0 if the text should be rendered from
+     * .. scratch on the next print.
+     * */
+    int end;
+    int valid;
+} StackTrace;
+
+void initStackTrace(StackTrace*);
+
+void deleteStackTrace(StackTrace*);
+
+/**
+ * Prints the stack of the virtual machine, the same as dumpStack() would,
+ * .. after the instruction ins is executed on it. The instructions executed
+ * .. on the virtual machine should be given one by one, in order.
+ * */
+void printStackTrace(StackTrace*, VirtualMachine*, Instruction ins, FILE*);
+
+#endif
@@ -0,0 +1,356 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "verifier.h"
+
+/**
+ * A procedure reached from the main block, which is the procedure 0
+ * */
+typedef struct {
+    int entry;
+    int level;     // lexical level, 0 for the main block
+    int parent;    // the procedure it is declared in, -1 for the main block
+    int maxHeight; // maximum number of slots of its activation record
+
+    /**
+     * Number of stack slots used by the procedure and the ones it calls,
+     * .. from its activation record up. One of the EXTENT_ values until
+     * .. it is known.
+     * */
+    int extent;
+} VerifierProc;
+
+enum {
+    EXTENT_UNKNOWN   = -1,
+    EXTENT_VISITING  = -2, // being computed, reaching it again is recursion
+    EXTENT_UNBOUNDED = -3  // the procedure recurses
+};
+
+typedef struct {
+    Instruction* code;
+    int numOfIns;
+
+    VerifierProc* procs;
+    int numberOfProcs;
+
+    /**
+     * The procedure each instruction is in, -1 if it is not reached, and
+     * .. the height of the activation record before it is executed.
+     * */
+    int* procOf;
+    int* heights;
+
+    // Instructions of the procedure being followed, left to visit
+    int* worklist;
+    int worklistSize;
+} Verifier;
+
+/**
+ * Prints why the i'th instruction is invalid to stderr. Returns -1.
+ * */
+int rejectInstruction(Verifier* v, int i, const char* reason)
+{
+    Instruction ins = v->code[i];
+    fprintf(stderr, "Invalid instruction %d %d %d %d at %d: %s\n", ins.op, ins.r, ins.l, ins.m, i, reason);
+
+    return -1;
+}
+
+/**
+ * Returns the number of the fields of op that are registers, from r: 1 for
+ * .. r, 2 for r and l and 3 for all of them.
+ * */
+int getRegisterFieldCount(int op)
+{
+    switch(op)
+    {
+        case 1: case 3: case 4: case 8: case 9: case 10: case 17:
+            return 1;
+        case 12: case 25: case 26: case 27: case 28: case 29: case 30: case 31:
+            return 2;
+        case 13: case 14: case 15: case 16: case 18: case 19: case 20: case 21: case 22: case 23: case 24:
+            return 3;
+        default:
+            return 0;
+    }
+}
+
+int isRegister(int reg)
+{
+    return reg >= 0 && reg < REGISTER_FILE_REG_COUNT;
+}
+
+/**
+ * Checks the fields of the i'th instruction on their own. Returns 0 if they
+ * .. are valid.
+ * */
+int checkInstructionFields(Verifier* v, int i)
+{
+    Instruction ins = v->code[i];
+    int regs = getRegisterFieldCount(ins.op);
+
+    if(ins.op < 1 || ins.op > 31)
+        return rejectInstruction(v, i, "illegal opcode");
+
+    if((regs >= 1 && !isRegister(ins.r)) || (regs >= 2 && !isRegister(ins.l)) || (regs >= 3 && !isRegister(ins.m)))
+        return rejectInstruction(v, i, "register out of the register file");
+
+    // CAL, JMP, JPC and the compare-and-branch instructions
+    int jumps = ins.op == 5 || ins.op == 7 || ins.op == 8 || (ins.op >= 25 && ins.op <= 30);
+    if(jumps && (ins.m < 0 || ins.m >= v->numOfIns))
+        return rejectInstruction(v, i, "target out of the code");
+
+    if(ins.op == 31 && (ins.m < -31 || ins.m > 31))
+        return rejectInstruction(v, i, "shift by more than 31 bits");
+
+    if((ins.op == 3 || ins.op == 4 || ins.op == 5) && ins.l < 0)
+        return rejectInstruction(v, i, "negative lexical level");
+
+    if(ins.op == 3 && ins.m < 0)
+        return rejectInstruction(v, i, "access out of the activation record");
+
+    if(ins.op == 4 && ins.m < AR_VARIABLE_OFFSET)
+        return rejectInstruction(v, i, "overwrites the links or the return address");
+
+    return 0;
+}
+
+/**
+ * Returns the procedure l levels up the static chain of the procedure p
+ * */
+int getAncestorProc(Verifier* v, int p, int l)
+{
+    while(l-- > 0) p = v->procs[p].parent;
+    return p;
+}
+
+/**
+ * Returns the procedure starting at entry, or -1 if it is not reached yet
+ * */
+int findProc(Verifier* v, int entry)
+{
+    for(int p = 0; p < v->numberOfProcs; p++)
+        if(v->procs[p].entry == entry) return p;
+
+    return -1;
+}
+
+int addProc(Verifier* v, int entry, int level, int parent)
+{
+    v->numberOfProcs++;
+    v->procs = (VerifierProc*)realloc(v->procs, v->numberOfProcs * sizeof(VerifierProc));
+
+    VerifierProc* proc = &v->procs[v->numberOfProcs - 1];
+    proc->entry = entry;
+    proc->level = level;
+    proc->parent = parent;
+    proc->maxHeight = 0;
+    proc->extent = EXTENT_UNKNOWN;
+
+    return v->numberOfProcs - 1;
+}
+
+/**
+ * Reaches the i'th instruction in the procedure p with the given height of
+ * .. its activation record, from the instruction from, or from the call to
+ * .. p if from is -1. Returns 0 if it is consistent with the paths reaching
+ * .. it before.
+ * */
+int reachInstruction(Verifier* v, int from, int i, int p, int height)
+{
+    if(v->procOf[i] < 0)
+    {
+        v->procOf[i] = p;
+        v->heights[i] = height;
+        v->worklist[v->worklistSize++] = i;
+        return 0;
+    }
+
+    if(v->procOf[i] != p)
+        return rejectInstruction(v, from < 0 ? i : from, "reaches the code of another procedure");
+
+    if(v->heights[i] != height)
+        return rejectInstruction(v, from < 0 ? i : from, "reaches an instruction with another height of the activation record");
+
+    return 0;
+}
+
+/**
+ * Follows the instructions of the procedure p from its entry, adding the
+ * .. procedures it calls. Returns 0 if they are valid.
+ * */
+int followProc(Verifier* v, int p)
+{
+    if(reachInstruction(v, -1, v->procs[p].entry, p, 0))
+        return -1;
+
+    while(v->worklistSize > 0)
+    {
+        int i = v->worklist[--v->worklistSize];
+        Instruction ins = v->code[i];
+        int height = v->heights[i];
+        int level = v->procs[p].level;
+        int fallsThrough = 1;
+
+        switch(ins.op)
+        {
+            case 2:
+                //RTN
+            case 11:
+                //SIO, halting
+                fallsThrough = 0;
+                break;
+            case 3:
+                //LOD
+            case 4:
+                //STO
+                if(ins.l > level)
+                    return rejectInstruction(v, i, "static chain past the main block");
+
+                // The accesses to the enclosing procedures are checked once
+                // .. all the procedures are followed
+                if(ins.l == 0 && ins.m >= height)
+                    return rejectInstruction(v, i, "access out of the activation record");
+                break;
+            case 5:
+            {
+                //CAL
+                if(ins.l > level)
+                    return rejectInstruction(v, i, "static chain past the main block");
+
+                int parent = getAncestorProc(v, p, ins.l);
+                int callee = findProc(v, ins.m);
+
+                if(callee < 0)
+                    addProc(v, ins.m, level - ins.l + 1, parent);
+                else if(v->procs[callee].parent != parent)
+                    return rejectInstruction(v, i, "calls a procedure from another scope");
+                break;
+            }
+            case 6:
+                //INC
+                height += ins.m;
+
+                if(height < 0)
+                    return rejectInstruction(v, i, "frees more than the activation record");
+
+                if(height > v->procs[p].maxHeight) v->procs[p].maxHeight = height;
+                break;
+            case 7:
+                //JMP
+                fallsThrough = 0;
+                if(reachInstruction(v, i, ins.m, p, height)) return -1;
+                break;
+            case 8: case 25: case 26: case 27: case 28: case 29: case 30:
+                //JPC and the compare-and-branch instructions
+                if(reachInstruction(v, i, ins.m, p, height)) return -1;
+                break;
+        }
+
+        if(fallsThrough && i + 1 == v->numOfIns)
+            return rejectInstruction(v, i, "falls through past the end of the code");
+
+        if(fallsThrough && reachInstruction(v, i, i + 1, p, height))
+            return -1;
+    }
+
+    return 0;
+}
+
+/**
+ * Returns the number of stack slots the procedure p and the procedures it
+ * .. calls use, from its activation record up, or -1 if they recurse.
+ * */
+int getStackExtent(Verifier* v, int p)
+{
+    VerifierProc* proc = &v->procs[p];
+
+    if(proc->extent == EXTENT_VISITING || proc->extent == EXTENT_UNBOUNDED)
+        return -1;
+
+    if(proc->extent != EXTENT_UNKNOWN)
+        return proc->extent;
+
+    proc->extent = EXTENT_VISITING;
+
+    // CAL writes the first slots of the activation record before the
+    // .. procedure allocates it
+    int extent = proc->maxHeight > AR_VARIABLE_OFFSET ? proc->maxHeight : AR_VARIABLE_OFFSET;
+
+    for(int i = 0; i < v->numOfIns; i++)
+    {
+        if(v->procOf[i] != p || v->code[i].op != 5) continue;
+
+        int calleeExtent = getStackExtent(v, findProc(v, v->code[i].m));
+
+        if(calleeExtent < 0)
+        {
+            v->procs[p].extent = EXTENT_UNBOUNDED;
+            return -1;
+        }
+
+        if(v->heights[i] + calleeExtent > extent)
+            extent = v->heights[i] + calleeExtent;
+    }
+
+    v->procs[p].extent = extent;
+    return extent;
+}
+
+int verifyCode(Instruction* code, int numOfIns)
+{
+    if(numOfIns <= 0)
+    {
+        fprintf(stderr, "Invalid code: no instructions\n");
+        return -1;
+    }
+
+    Verifier v;
+    v.code = code;
+    v.numOfIns = numOfIns;
+    v.procs = NULL;
+    v.numberOfProcs = 0;
+    v.procOf = (int*)malloc(numOfIns * sizeof(int));
+    v.heights = (int*)malloc(numOfIns * sizeof(int));
+    v.worklist = (int*)malloc(numOfIns * sizeof(int));
+    v.worklistSize = 0;
+
+    int ret = 0;
+
+    for(int i = 0; i < numOfIns && !ret; i++)
+    {
+        v.procOf[i] = -1;
+        ret = checkInstructionFields(&v, i);
+    }
+
+    // The main block starts at 0, and the procedures are added as they are
+    // .. called
+    if(!ret) addProc(&v, 0, 0, -1);
+
+    for(int p = 0; p < v.numberOfProcs && !ret; p++)
+        ret = followProc(&v, p);
+
+    // The accesses to the activation records of the enclosing procedures
+    for(int i = 0; i < numOfIns && !ret; i++)
+    {
+        Instruction ins = code[i];
+
+        if(v.procOf[i] < 0 || (ins.op != 3 && ins.op != 4) || ins.l == 0) continue;
+
+        if(ins.m >= v.procs[getAncestorProc(&v, v.procOf[i], ins.l)].maxHeight)
+            ret = rejectInstruction(&v, i, "access out of the activation record");
+    }
+
+    // The main block's activation record starts at 1
+    if(!ret && getStackExtent(&v, 0) >= MAX_STACK_HEIGHT)
+    {
+        fprintf(stderr, "Invalid code: the stack needs %d slots, more than MAX_STACK_HEIGHT(%d)\n", 1 + getStackExtent(&v, 0), MAX_STACK_HEIGHT);
+        ret = -1;
+    }
+
+    free(v.procs);
+    free(v.procOf);
+    free(v.heights);
+    free(v.worklist);
+
+    return ret;
+}
@@ -0,0 +1,35 @@
+#ifndef __VERIFIER_H__
+#define __VERIFIER_H__
+
+#include "data.h"
+
+/**
+ * Verifies the code loaded to the code memory, once before it is run, so
+ * .. that executeInstruction() and the dispatch loops can trust every field
+ * .. of the instructions. The only check left to run time is the growth of
+ * .. the stack by CAL and INC, which is not bounded for recursive code.
+ * Every instruction is checked to have a legal opcode, registers in the
+ * .. register file, a jump or call target in the code, a shift of at most
+ * .. 31 bits, and not to store into the first AR_VARIABLE_OFFSET slots of an
+ * .. activation record, which RTN restores the registers from.
+ * The instructions reachable from the main block, at address 0, are then
+ * .. followed procedure by procedure, the procedures being the targets of
+ * .. the CAL instructions, to check that:
+ *  - an instruction is in a single procedure, and the height of the
+ * ..   activation record before it is the same on every path to it, as INC
+ * ..   changes it.
+ *  - no path falls through past the end of the code.
+ *  - L of LOD, STO and CAL does not walk the static chain past the main
+ * ..   block, and a procedure is always called from the same scope.
+ *  - LOD and STO access the slots allocated in the activation record.
+ *  - the stack fits in MAX_STACK_HEIGHT slots, unless the procedures are
+ * ..   recursive, in which case the stack grows with the input, and the
+ * ..   virtual machine stops with VM_STACK_OVERFLOW if it does not fit.
+ * The values the program computes are not checked: the virtual machine
+ * .. stops with VM_DIVISION_ERROR on a division by zero.
+ * Returns 0 if the code is valid, -1 after printing the first invalid
+ * .. instruction and the reason to stderr.
+ * */
+int verifyCode(Instruction* code, int numOfIns);
+
+#endif
@@ -0,0 +1,926 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <time.h>
+#include <signal.h>
+#include "vm.h"
+#include "data.h"
+#include "jit.h"
+#include "profile.h"
+#include "vmio.h"
+#include "object_loader.h"
+#include "packed_code.h"
+#include "snapshot.h"
+#include "stack_trace.h"
+#include "verifier.h"
+
+/* ************************************************************************************ */
+/* Declarations                                                                         */
+/* ************************************************************************************ */
+
+/**
+ * Recommended design includes the following functions implemented.
+ * However, you are free to change them as you wish inside the vm.c file.
+ * */
+void initVM(VirtualMachine*);
+
+int readInstructions(FILE*, Instruction*);
+
+void dumpInstructions(FILE*, Instruction*, int numOfIns);
+
+int getBasePointer(int *stack, int currentBP, int L);
+
+void dumpStack(FILE*, int* stack, int sp, int bp);
+
+int executeInstruction(VirtualMachine* vm, Instruction ins, VMIO* io);
+
+int runNative(VirtualMachine* vm, Instruction* instr, int numInstr, VMIO* io);
+
+long long elapsedMillis(struct timespec* start);
+
+void dumpStopReport(FILE*, VirtualMachine* vm, int status, VMOptions* options);
+
+int checkSnapshotFrames(VirtualMachine* vm, int numInstr);
+
+int resumeSnapshot(VirtualMachine* vm, Instruction* instr, int numInstr, VMSnapshot* snapshot, const char* path);
+
+void takeSnapshot(VirtualMachine* vm, Instruction* instr, int numInstr, VMIO* io, const char* path);
+
+void requestSnapshot(int sig);
+
+/* ************************************************************************************ */
+/* Global Data and misc structs & enums                                                 */
+/* ************************************************************************************ */
+
+/**
+ * allows conversion from opcode to opcode string
+ * */
+const char *opcodes[] =
+{
+    "illegal", // opcode 0 is illegal
+    "lit", "rtn", "lod", "sto", "cal", // 1, 2, 3 ..
+    "inc", "jmp", "jpc", "sio", "sio",
+    "sio", "neg", "add", "sub", "mul",
+    "div", "odd", "mod", "eql", "neq",
+    "lss", "leq", "gtr", "geq", "jeq",
+    "jne", "jlt", "jle", "jgt", "jge",
+    "shf"
+};
+
+enum { CONT, HALT, STACK_OVERFLOW, DIVISION_ERROR };
+
+/**
+ * Set by the SIGUSR1 handler when snapshots are enabled, and cleared once
+ * .. the snapshot is taken.
+ * */
+volatile sig_atomic_t _snapshot_requested;
+
+/* ************************************************************************************ */
+/* Definitions                                                                          */
+/* ************************************************************************************ */
+
+/**
+ * Initialize Virtual Machine
+ * */
+void initVM(VirtualMachine* vm)
+{
+    if(vm)
+    {
+        // Go ahead and set all the registers to zero
+        vm->BP = 1;
+        vm->SP = 0;
+        vm->PC = 0;
+        vm->IR = 0;
+
+        // Clear the register file and the stack
+        for(int i = 0; i < REGISTER_FILE_REG_COUNT; i++) vm->RF[i] = 0;
+        for(int i = 0; i < MAX_STACK_HEIGHT; i++)        vm->stack[i] = 0;
+    }
+}
+
+/**
+ * Fill the (ins)tructions array by reading instructions from (in)put file
+ * Return the number of instructions read, or -1 if there are more than
+ * .. MAX_CODE_LENGTH of them
+ * */
+int readInstructions(FILE* in, Instruction* ins)
+{
+    // Temp variables that will hold the data when we read the file
+    int op, r, l, m, count = 0;
+
+    // Loop through the file and read in opcode, reg, L, and M values and store into array
+    while (1)
+    {
+        if (fscanf(in, "%d %d %d %d", &op, &r, &l, &m) == EOF)
+        {
+            break;
+        }
+
+        if (count == MAX_CODE_LENGTH)
+        {
+            fprintf(stderr, "The code is longer than MAX_CODE_LENGTH(%d) instructions\n", MAX_CODE_LENGTH);
+            return -1;
+        }
+
+        ins[count].op = op;
+        ins[count].r = r;
+        ins[count].l = l;
+        ins[count].m  = m;
+        count++;
+    }
+    return count;
+
+}
+
+/**
+ * Dump instructions to the output file
+ * */
+void dumpInstructions(FILE* out, Instruction* ins, int numOfIns)
+{
+    int counter;
+    // Header
+    fprintf(out,
+        "***Code Memory***\n%3s %3s %3s %3s %3s \n",
+        "#", "OP", "R", "L", "M");
+
+    for (counter = 0; counter < numOfIns; counter++)
+    {
+        fprintf(
+            out,
+            "%3d %3s %3d %3d %3d \n",
+            counter,
+            opcodes[ins[counter].op],
+            ins[counter].r,
+            ins[counter].l,
+            ins[counter].m);
+    }
+}
+
+/**
+ * Returns the base pointer for the lexiographic level L
+ * */
+int getBasePointer(int *stack, int currentBP, int L)
+{
+    int b1; //find base L levels down
+    b1 = currentBP;
+    while (L > 0)
+    {
+        b1 = stack[b1 + 1];
+        L--;
+    }
+    return b1;
+}
+
+// Function that dumps the whole stack into output file
+// Do not forget to use '|' character between stack frames
+void dumpStack(FILE* out, int* stack, int sp, int bp)
+{
+    // Check if the base pointer is zero
+    if(bp == 0)
+      return;
+
+    // bottom-most level, where a single zero value lies
+      if(bp == 1)
+      {
+          fprintf(out, "%3d ", 0);
+      }
+
+      // former levels - if exists
+      if(bp != 1)
+      {
+          dumpStack(out, stack, bp - 1, stack[bp + 2]);
+      }
+
+      // top level: current activation record
+      if(bp <= sp)
+      {
+          // indicate a new activation record
+          fprintf(out, "| ");
+
+          // print the activation record
+          int i;
+          for(i = bp; i <= sp; i++)
+          {
+              fprintf(out, "%3d ", stack[i]);
+          }
+      }
+
+}
+
+/**
+ * Executes the (ins)truction on the (v)irtual (m)achine.
+ * This changes the state of the virtual machine.
+ * Returns HALT if the executed instruction was meant to halt the VM.
+ * .. Returns STACK_OVERFLOW, leaving PC at the instruction, if CAL or INC
+ * .. would grow the stack past MAX_STACK_HEIGHT, which the verifier cannot
+ * .. rule out for recursive code, and DIVISION_ERROR if DIV or MOD would
+ * .. trap, dividing by zero or INT_MIN by -1. Otherwise, returns CONT
+ * */
+int executeInstruction(VirtualMachine* vm, Instruction ins, VMIO* io)
+{
+    switch(ins.op)
+    {
+        case 1:
+            //LIT
+            vm->RF[ins.r] = ins.m;
+            break;
+        case 2:
+            //RTN
+            vm->SP = vm->BP - 1;
+            vm->BP = vm->stack[vm->SP + 3];
+            vm->PC = vm->stack[vm->SP + 4];
+            break;
+        case 3:
+            //LOD
+            vm->RF[ins.r] = vm->stack[getBasePointer(vm->stack, vm->BP, ins.l) + ins.m];
+            break;
+        case 4:
+            //STO
+            vm->stack[getBasePointer(vm->stack, vm->BP, ins.l) + ins.m] = vm->RF[ins.r];
+            break;
+        case 5:
+            //CAL
+            if(vm->SP + AR_VARIABLE_OFFSET >= MAX_STACK_HEIGHT)
+            {
+                vm->PC = vm->IR;
+                return STACK_OVERFLOW;
+            }
+
+            vm->stack[vm->SP + 1] = 0;
+            vm->stack[vm->SP + 2] = getBasePointer(vm->stack, vm->BP, ins.l);
+            vm->stack[vm->SP + 3] = vm->BP;
+            vm->stack[vm->SP + 4] = vm->PC;
+            vm->BP = vm->SP + 1;
+            vm->PC = ins.m;
+            break;
+        case 6:
+            //INC
+            if(vm->SP + ins.m >= MAX_STACK_HEIGHT)
+            {
+                vm->PC = vm->IR;
+                return STACK_OVERFLOW;
+            }
+
+            vm->SP = vm->SP + ins.m;
+            break;
+        case 7:
+            //JMP
+            vm->PC = ins.m;
+            break;
+        case 8:
+            //JPC
+            if(vm->RF[ins.r] == 0)
+            {
+              vm->PC = ins.m;
+            }
+            break;
+        case 9:
+            //SIO
+            writeVMInt(io, vm->RF[ins.r]);
+            break;
+        case 10:
+            //SIO
+            readVMInt(io, &vm->RF[ins.r]);
+            break;
+        case 11:
+            //SIO
+            return HALT;
+        case 12:
+            //NEG, on unsigned ints to wrap around INT_MIN as the machine does
+            vm->RF[ins.r] = (int)(0u - (unsigned int)vm->RF[ins.l]);
+            break;
+        case 13:
+            //ADD
+            vm->RF[ins.r] = (int)((unsigned int)vm->RF[ins.l] + (unsigned int)vm->RF[ins.m]);
+            break;
+        case 14:
+            //SUB
+            vm->RF[ins.r] = (int)((unsigned int)vm->RF[ins.l] - (unsigned int)vm->RF[ins.m]);
+            break;
+        case 15:
+            //MUL
+            vm->RF[ins.r] = (int)((unsigned int)vm->RF[ins.l] * (unsigned int)vm->RF[ins.m]);
+            break;
+        case 16:
+            //DIV
+            if(vm->RF[ins.m] == 0 || (vm->RF[ins.m] == -1 && vm->RF[ins.l] == INT_MIN))
+            {
+                vm->PC = vm->IR;
+                return DIVISION_ERROR;
+            }
+
+            vm->RF[ins.r] = vm->RF[ins.l] / vm->RF[ins.m];
+            break;
+        case 17:
+            //ODD
+            vm->RF[ins.r] = vm->RF[ins.r] % 2;
+            break;
+        case 18:
+            //MOD
+            if(vm->RF[ins.m] == 0 || (vm->RF[ins.m] == -1 && vm->RF[ins.l] == INT_MIN))
+            {
+                vm->PC = vm->IR;
+                return DIVISION_ERROR;
+            }
+
+            vm->RF[ins.r] = vm->RF[ins.l] % vm->RF[ins.m];
+            break;
+        case 19:
+            //EQL
+            if(vm->RF[ins.l] == vm->RF[ins.m])
+            {
+              vm->RF[ins.r] = 1;
+            }
+            else{
+              vm->RF[ins.r] = 0;
+            }
+            break;
+        case 20:
+            //NEQ
+            if(vm->RF[ins.l] != vm->RF[ins.m])
+            {
+              vm->RF[ins.r] = 1;
+            }
+            else{
+              vm->RF[ins.r] = 0;
+            }
+            break;
+        case 21:
+            //LSS
+            if(vm->RF[ins.l] < vm->RF[ins.m])
+            {
+              vm->RF[ins.r] = 1;
+            }
+            else{
+              vm->RF[ins.r] = 0;
+            }
+            break;
+        case 22:
+            //LEQ
+            if(vm->RF[ins.l] <= vm->RF[ins.m])
+            {
+              vm->RF[ins.r] = 1;
+            }
+            else{
+              vm->RF[ins.r] = 0;
+            }
+            break;
+        case 23:
+            //GTR
+            if(vm->RF[ins.l]  > vm->RF[ins.m])
+            {
+              vm->RF[ins.r] = 1;
+            }
+            else{
+              vm->RF[ins.r] = 0;
+            }
+            break;
+        case 24:
+            //GEQ
+            if(vm->RF[ins.l] >= vm->RF[ins.m])
+            {
+              vm->RF[ins.r] = 1;
+            }
+            else{
+              vm->RF[ins.r] = 0;
+            }
+            break;
+        case 25:
+            //JEQ
+            if(vm->RF[ins.r] == vm->RF[ins.l]) vm->PC = ins.m;
+            break;
+        case 26:
+            //JNE
+            if(vm->RF[ins.r] != vm->RF[ins.l]) vm->PC = ins.m;
+            break;
+        case 27:
+            //JLT
+            if(vm->RF[ins.r] < vm->RF[ins.l]) vm->PC = ins.m;
+            break;
+        case 28:
+            //JLE
+            if(vm->RF[ins.r] <= vm->RF[ins.l]) vm->PC = ins.m;
+            break;
+        case 29:
+            //JGT
+            if(vm->RF[ins.r] > vm->RF[ins.l]) vm->PC = ins.m;
+            break;
+        case 30:
+            //JGE
+            if(vm->RF[ins.r] >= vm->RF[ins.l]) vm->PC = ins.m;
+            break;
+        case 31:
+            //SHF, rounding toward zero as DIV when shifting right
+            if(ins.m >= 0)
+                vm->RF[ins.r] = (int)((unsigned int)vm->RF[ins.l] << ins.m);
+            else
+                vm->RF[ins.r] = (vm->RF[ins.l] + (vm->RF[ins.l] < 0 ? (int)((1u << -ins.m) - 1) : 0)) >> -ins.m;
+            break;
+        default:
+            fprintf(stderr, "VM cannot execute illegal instruction with op code: %d\n", ins.op);
+            fprintf(stderr, "Terminating VM..\n");
+
+            // The output up to here is kept
+            flushVMIO(io);
+            exit(-1);
+    }
+    return CONT;
+}
+
+/**
+ * inp: The FILE pointer containing the list of instructions to
+ *         be loaded to code memory of the virtual machine.
+ *
+ * outp: The FILE pointer to write the simulation output, which
+ *       contains both code memory and execution history.
+ *
+ * vm_inp: The FILE pointer that is going to be attached as the input
+ *         stream to the virtual machine. Useful to feed input for SIO
+ *         instructions.
+ *
+ * vm_outp: The FILE pointer that is going to be attached as the output
+ *          stream to the virtual machine. Useful to save the output printed
+ *          by SIO instructions.
+ * */
+void simulateVM(
+    FILE* inp,
+    FILE* outp,
+    FILE* vm_inp,
+    FILE* vm_outp
+    )
+{
+    VMOptions options;
+    initVMOptions(&options);
+
+    simulateVMWithOptions(inp, outp, vm_inp, vm_outp, &options);
+}
+
+/**
+ * Initialize the options to their defaults
+ * */
+void initVMOptions(VMOptions* options)
+{
+    if(options)
+    {
+        options->jit = 0;
+        options->profileReport = NULL;
+        options->profileFolded = NULL;
+        options->maxInstructions = 0;
+        options->maxMillis = 0;
+        options->mapInput = 0;
+        options->packCode = 1;
+        options->snapshotPath = NULL;
+        options->snapshotInterval = 0;
+        options->resumePath = NULL;
+        options->stats = NULL;
+    }
+}
+
+/**
+ * Returns the status, see vm.h, of the simulation stopped by an instruction
+ * .. for which executeInstruction() returned halt
+ * */
+int getHaltStatus(int halt)
+{
+    if(halt == STACK_OVERFLOW) return VM_STACK_OVERFLOW;
+    if(halt == DIVISION_ERROR) return VM_DIVISION_ERROR;
+
+    return VM_HALTED;
+}
+
+/**
+ * Runs the instructions natively where possible, interpreting the ones the
+ * .. native code leaves to the interpreter. No execution history is written.
+ * Returns VM_HALTED, VM_STACK_OVERFLOW or VM_DIVISION_ERROR, or -1 if the
+ * .. instructions could not be compiled to native code.
+ * */
+int runNative(VirtualMachine* vm, Instruction* instr, int numInstr, VMIO* io)
+{
+    JitCode jit;
+
+    if(jitCompile(&jit, instr, numInstr))
+        return -1;
+
+    int halt = CONT;
+    while(halt == CONT && !(vm->PC == 0 && vm->BP == 0 && vm->SP == 0))
+    {
+        // Run natively until reaching an instruction left to the interpreter,
+        // .. which a CAL or INC growing the stack too much, and a DIV or MOD
+        // .. that would trap, are left to as well
+        if(vm->BP != 0)
+        {
+            jitRun(&jit, vm);
+
+            if(vm->PC == 0 && vm->BP == 0 && vm->SP == 0)
+                break;
+        }
+
+        //Fetch
+        vm->IR = vm->PC;
+        Instruction cur = instr[vm->PC];
+        vm->PC++;
+
+        //Execute
+        halt = executeInstruction(vm, cur, io);
+    }
+
+    jitDelete(&jit);
+
+    return getHaltStatus(halt);
+}
+
+/**
+ * Returns the wall-clock time passed since start, in milliseconds
+ * */
+long long elapsedMillis(struct timespec* start)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (now.tv_sec - start->tv_sec) * 1000LL + (now.tv_nsec - start->tv_nsec) / 1000000;
+}
+
+/**
+ * Reports why the simulation stopped before the program halted, together with
+ * .. the registers and the stack at that point
+ * */
+void dumpStopReport(FILE* out, VirtualMachine* vm, int status, VMOptions* options)
+{
+    if(status == VM_INSTRUCTION_BUDGET_EXCEEDED)
+        fprintf(out, "VM stopped: instruction budget of %lld exceeded\n", options->maxInstructions);
+    else if(status == VM_TIME_BUDGET_EXCEEDED)
+        fprintf(out, "VM stopped: time budget of %lld ms exceeded\n", options->maxMillis);
+    else if(status == VM_STACK_OVERFLOW)
+        fprintf(out, "VM stopped: stack overflow, more than MAX_STACK_HEIGHT(%d) slots needed\n", MAX_STACK_HEIGHT);
+    else
+        fprintf(out, "VM stopped: division by zero, or of INT_MIN by -1\n");
+
+    fprintf(out, "%3s %3s %3s %3s \n", "PC", "BP", "SP", "STK");
+    fprintf(out, "%3d %3d %3d ", vm->PC, vm->BP, vm->SP);
+    dumpStack(out, vm->stack, vm->SP, vm->BP);
+    fprintf(out, "\n");
+}
+
+/**
+ * Walks the activation records of the restored virtual machine, from BP down
+ * .. the dynamic links, to the one of the main block at 1. Returns 0 if each
+ * .. record lies in the stack, its dynamic and static links point to records
+ * .. below it, and its return address is in the code, -1 otherwise.
+ * */
+int checkSnapshotFrames(VirtualMachine* vm, int numInstr)
+{
+    // The bases of the records walked, to check the static links against
+    int* isBase = (int*)calloc(MAX_STACK_HEIGHT, sizeof(int));
+    int bp = vm->BP, ret = 0;
+
+    if(bp < 1 || vm->SP < bp - 1) ret = -1;
+
+    while(!ret)
+    {
+        if(bp + AR_VARIABLE_OFFSET > MAX_STACK_HEIGHT)
+        {
+            ret = -1;
+            break;
+        }
+
+        isBase[bp] = 1;
+
+        int dynamicLink = vm->stack[bp + 2];
+        int returnAddress = vm->stack[bp + 3];
+
+        // The main block returns to PC, BP and SP of zero, halting
+        if(bp == 1)
+        {
+            if(dynamicLink != 0 || returnAddress != 0 || vm->stack[bp + 1] != 0) ret = -1;
+            break;
+        }
+
+        if(dynamicLink < 1 || dynamicLink >= bp || returnAddress < 0 || returnAddress >= numInstr)
+            ret = -1;
+
+        bp = dynamicLink;
+    }
+
+    // A static link points to the record of an enclosing procedure, which
+    // .. is one of the records walked, below the one it is in
+    for(int b = 2; !ret && b < MAX_STACK_HEIGHT; b++)
+    {
+        if(!isBase[b]) continue;
+
+        int staticLink = vm->stack[b + 1];
+        if(staticLink < 1 || staticLink >= b || !isBase[staticLink]) ret = -1;
+    }
+
+    free(isBase);
+
+    return ret;
+}
+
+/**
+ * Reads the snapshot at path to snapshot, and restores the state of the
+ * .. virtual machine from it. Returns 0 on success, -1 if the snapshot
+ * .. cannot be read, was not taken on the given code, or its registers or
+ * .. activation records point out of the code or the stack.
+ * */
+int resumeSnapshot(VirtualMachine* vm, Instruction* instr, int numInstr, VMSnapshot* snapshot, const char* path)
+{
+    FILE* in = fopen(path, "r");
+    int ok = in && readVMSnapshot(snapshot, in);
+
+    if(in) fclose(in);
+
+    if(!ok)
+    {
+        fprintf(stderr, "Could not read the snapshot \"%s\"\n", path);
+        return -1;
+    }
+
+    if(snapshot->numOfIns != numInstr || snapshot->codeHash != hashVMCode(instr, numInstr))
+    {
+        fprintf(stderr, "The snapshot \"%s\" was taken on a different code\n", path);
+        return -1;
+    }
+
+    // The code is verified, but the registers of the snapshot are not
+    VirtualMachine* vmSnapshot = &snapshot->vm;
+    if(vmSnapshot->PC < 0 || vmSnapshot->PC >= numInstr || vmSnapshot->BP < 0 || vmSnapshot->BP >= MAX_STACK_HEIGHT ||
+       vmSnapshot->SP < 0 || vmSnapshot->SP >= MAX_STACK_HEIGHT)
+    {
+        fprintf(stderr, "The registers of the snapshot \"%s\" point out of the code or the stack\n", path);
+        return -1;
+    }
+
+    // The links and the return addresses RTN restores the registers from
+    if(checkSnapshotFrames(vmSnapshot, numInstr))
+    {
+        fprintf(stderr, "The activation records of the snapshot \"%s\" point out of the code or the stack\n", path);
+        return -1;
+    }
+
+    *vm = snapshot->vm;
+    return 0;
+}
+
+/**
+ * Writes a snapshot of the virtual machine and its I/O to path. The output
+ * .. is flushed first, so that it is not lost if the snapshot is resumed.
+ * */
+void takeSnapshot(VirtualMachine* vm, Instruction* instr, int numInstr, VMIO* io, const char* path)
+{
+    flushVMIO(io);
+
+    VMSnapshot snapshot;
+    snapshot.numOfIns = numInstr;
+    snapshot.codeHash = hashVMCode(instr, numInstr);
+    snapshot.inputPosition = getVMInputPosition(io);
+    snapshot.outputPosition = getVMOutputPosition(io);
+    snapshot.vm = *vm;
+
+    if(saveVMSnapshot(&snapshot, path))
+        fprintf(stderr, "Could not write the snapshot \"%s\"\n", path);
+}
+
+void requestSnapshot(int sig)
+{
+    (void)sig;
+    _snapshot_requested = 1;
+}
+
+/**
+ * Same as simulateVM(), with the given options
+ * */
+int simulateVMWithOptions(
+    FILE* inp,
+    FILE* outp,
+    FILE* vm_inp,
+    FILE* vm_outp,
+    VMOptions* options
+    )
+{
+    // Load the instructions from the object file, or read them from the
+    // .. text file
+    Instruction instr[MAX_CODE_LENGTH];
+    int numInstr = 0;
+
+    Stats* stats = options->stats;
+    startStatTimer(stats, "vm_load", "Time spent loading the code");
+
+    PM0Object object;
+    int notObject = mapObject(inp, &object);
+
+    if(notObject < 0)
+    {
+        stopStatTimer(stats, "vm_load");
+        return VM_INVALID_OBJECT;
+    }
+
+    if(notObject) numInstr = readInstructions(inp, instr);
+    else          numInstr = decodeObjectCode(&object, instr, MAX_CODE_LENGTH);
+
+    // Verified once here, the code is run checking only the growth of the
+    // .. stack, which is not bounded for recursive code
+    if(numInstr < 0 || verifyCode(instr, numInstr))
+    {
+        stopStatTimer(stats, "vm_load");
+        if(!notObject) unmapObject(&object);
+        return VM_INVALID_CODE;
+    }
+
+    stopStatTimer(stats, "vm_load");
+    addStatCount(stats, "vm_instructions_loaded_total", "Instructions loaded to the code memory", numInstr);
+    
+    // Dump instructions to the output file
+    dumpInstructions(outp, instr, numInstr);
+
+    // Create a virtual machine
+    VirtualMachine vm;
+
+    // Initialize the virtual machine, from the snapshot if resuming
+    initVM(&vm);
+
+    VMSnapshot snapshot;
+    if(options->resumePath && resumeSnapshot(&vm, instr, numInstr, &snapshot, options->resumePath))
+    {
+        if(!notObject) unmapObject(&object);
+        return VM_INVALID_SNAPSHOT;
+    }
+
+    // Profile only if requested, keeping the loop below as fast as possible
+    // .. otherwise
+    VMProfile profileData, *profile = NULL;
+    if(options->profileReport || options->profileFolded)
+    {
+        profile = &profileData;
+        initVMProfile(profile, numInstr);
+
+        // Name the procedures after the symbols of the object, if any
+        PM0Symbol sym;
+        for(int i = 0; !notObject && getObjectSymbol(&object, i, &sym); i++)
+            setVMProfileProcName(profile, sym.address, sym.name);
+    }
+
+    // The instructions are decoded, and the symbols are read
+    if(!notObject) unmapObject(&object);
+
+    // SIO instructions read and write through buffers
+    VMIO io;
+    initVMIO(&io, vm_inp, vm_outp, options->mapInput);
+
+    // Continue the I/O from where the snapshot was taken
+    if(options->resumePath && seekVMIO(&io, snapshot.inputPosition, snapshot.outputPosition))
+    {
+        fprintf(stderr, "The I/O of the snapshot \"%s\" cannot be resumed\n", options->resumePath);
+
+        deleteVMIO(&io);
+        deleteVMProfile(profile);
+        return VM_INVALID_SNAPSHOT;
+    }
+
+    // Native execution does not keep the execution history. If the JIT
+    // .. is not available, simulate as usual.
+    int budgeted = options->maxInstructions || options->maxMillis;
+    int snapshotting = options->snapshotPath != NULL;
+    int nativeStatus = -1;
+    if(options->jit && !profile && !budgeted && !snapshotting && !stats &&
+       (nativeStatus = runNative(&vm, instr, numInstr, &io)) >= 0)
+    {
+        deleteVMIO(&io);
+
+        if(nativeStatus != VM_HALTED)
+        {
+            dumpStopReport(outp, &vm, nativeStatus, options);
+            dumpStopReport(stderr, &vm, nativeStatus, options);
+        }
+
+        return nativeStatus;
+    }
+
+    // Before starting the code execution on the virtual machine,
+    // .. write the header for the simulation part (***Execution***)
+    fprintf(outp, "\n***Execution***\n");
+    fprintf(
+        outp,
+        "%3s %3s %3s %3s %3s %3s %3s %3s %3s \n", "#", "OP", "R", "L", "M", "PC", "BP", "SP", "STK");
+
+    // The interpreter fetches from the packed code memory, unless some
+    // .. instruction does not fit in it
+    PackedInstruction code[MAX_CODE_LENGTH];
+    int packed = options->packCode && packCode(instr, numInstr, code);
+
+    // Number of the instructions executed, the maximum stack depth, and the
+    // .. start time, for the budgets, the snapshots and the stats
+    int counting = budgeted || snapshotting || stats;
+    long long executed = 0;
+    int maxStackDepth = vm.SP;
+    struct timespec start;
+    if(options->maxMillis) clock_gettime(CLOCK_MONOTONIC, &start);
+
+    // A snapshot can be requested by SIGUSR1 as well
+    struct sigaction snapshotAction, prevAction;
+    if(snapshotting)
+    {
+        _snapshot_requested = 0;
+
+        memset(&snapshotAction, 0, sizeof(snapshotAction));
+        snapshotAction.sa_handler = requestSnapshot;
+        snapshotAction.sa_flags = SA_RESTART; // not to fail the SIO reads
+        sigemptyset(&snapshotAction.sa_mask);
+        sigaction(SIGUSR1, &snapshotAction, &prevAction);
+    }
+
+    // Fetch&Execute the instructions on the virtual machine until halting.
+    // .. Returning from the main block, which leaves PC, BP and SP at zero,
+    // .. halts the machine as well.
+    // The stack is printed after each instruction, rendering only what
+    // .. changed since the previous one
+    StackTrace stackTrace;
+    initStackTrace(&stackTrace);
+
+    startStatTimer(stats, "vm_execute", "Time spent executing the code");
+
+    int halt = CONT, status = VM_HALTED;
+    while(halt == CONT && !(vm.PC == 0 && vm.BP == 0 && vm.SP == 0))
+    {
+        // Stop if a budget runs out, and take the snapshot if it is due
+        if(counting)
+        {
+            if(options->maxInstructions && executed >= options->maxInstructions)
+                status = VM_INSTRUCTION_BUDGET_EXCEEDED;
+            else if(options->maxMillis && !(executed & (VM_TIME_CHECK_INTERVAL - 1)) && elapsedMillis(&start) >= options->maxMillis)
+                status = VM_TIME_BUDGET_EXCEEDED;
+
+            if(status != VM_HALTED) break;
+
+            if(snapshotting && (_snapshot_requested || (options->snapshotInterval && executed && executed % options->snapshotInterval == 0)))
+            {
+                _snapshot_requested = 0;
+                takeSnapshot(&vm, instr, numInstr, &io, options->snapshotPath);
+            }
+
+            if(vm.SP > maxStackDepth) maxStackDepth = vm.SP;
+            executed++;
+        }
+
+        //Fetch
+        vm.IR = vm.PC;
+        Instruction cur = packed ? unpackInstruction(code[vm.PC]) : instr[vm.PC];
+        vm.PC++;
+
+        //Execute
+        halt = executeInstruction(&vm, cur, &io);
+
+        status = getHaltStatus(halt);
+        if(status != VM_HALTED) break;
+
+        if(profile) profileInstruction(profile, &vm, cur, vm.IR);
+
+        fprintf(
+            outp,
+            "%3d %3s %3d %3d %3d %3d %3d %3d ", vm.IR, opcodes[cur.op], cur.r, cur.l, cur.m, vm.PC, vm.BP, vm.SP);
+        printStackTrace(&stackTrace, &vm, cur, outp);
+        fprintf(outp, "\n");
+    }
+
+    deleteStackTrace(&stackTrace);
+
+    stopStatTimer(stats, "vm_execute");
+
+    if(vm.SP > maxStackDepth) maxStackDepth = vm.SP;
+    addStatCount(stats, "vm_instructions_executed_total", "Instructions executed", executed);
+    setStatMax(stats, "vm_max_stack_depth", "Maximum stack pointer reached", maxStackDepth);
+    addStatCount(stats, "vm_sio_reads_total", "SIO instructions reading an integer", io.numberOfReads);
+    addStatCount(stats, "vm_sio_writes_total", "SIO instructions writing an integer", io.numberOfWrites);
+
+    // Stopped by a budget, the run can be continued from the last snapshot
+    if(snapshotting)
+    {
+        if(status == VM_INSTRUCTION_BUDGET_EXCEEDED || status == VM_TIME_BUDGET_EXCEEDED) takeSnapshot(&vm, instr, numInstr, &io, options->snapshotPath);
+        sigaction(SIGUSR1, &prevAction, NULL);
+    }
+
+    // Above loop ends when machine halts, unless a budget ran out, the
+    // .. stack overflowed or a division trapped. Therefore, dump halt message or the stop report.
+    deleteVMIO(&io);
+
+    if(status == VM_HALTED)
+    {
+        fprintf(outp, "HLT\n");
+    }
+    else
+    {
+        dumpStopReport(outp, &vm, status, options);
+        dumpStopReport(stderr, &vm, status, options);
+    }
+
+    if(profile)
+    {
+        printVMProfileReport(profile, instr, options->profileReport);
+        printVMProfileFolded(profile, options->profileFolded);
+        deleteVMProfile(profile);
+    }
+
+    return status;
+}
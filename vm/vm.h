@@ -2,10 +2,13 @@
 #define __VM_H__
 
 #include <stdio.h>
+#include "../stats.h"
 
 /**
  * inp: The FILE pointer containing the list of instructions to
- *         be loaded to code memory of the virtual machine.
+ *         be loaded to code memory of the virtual machine. Either the
+ *         PM/0 assembly text, or a file in the binary object format of
+ *         object_format.h, which is memory-mapped.
  * 
  * outp: The FILE pointer to write the simulation output, which
  *       contains both code memory and execution history.
@@ -26,4 +29,120 @@ void simulateVM(
     FILE* vm_outp
 );
 
+/**
+ * How a simulation ended.
+ * */
+enum {
+    VM_HALTED,                      // halted by the program
+    VM_INSTRUCTION_BUDGET_EXCEEDED, // stopped after maxInstructions instructions
+    VM_TIME_BUDGET_EXCEEDED,        // stopped after maxMillis milliseconds
+    VM_INVALID_OBJECT,              // inp is not a valid object file
+    VM_INVALID_SNAPSHOT,            // the snapshot to resume cannot be resumed
+    VM_INVALID_CODE,                // the code is rejected by verifyCode(), see verifier.h
+    VM_STACK_OVERFLOW,              // CAL or INC would grow the stack past MAX_STACK_HEIGHT
+    VM_DIVISION_ERROR               // DIV or MOD by zero, or of INT_MIN by -1
+};
+
+/**
+ * Options of the simulation. simulateVM() runs with the options set by
+ * .. initVMOptions().
+ * */
+typedef struct {
+    /**
+     * If nonzero, the instructions are compiled to native code and run
+     * .. natively where possible, see jit.h. The execution history is not
+     * .. written to outp in this mode, only the code memory is.
+     * */
+    int jit;
+
+    /**
+     * If not NULL, the execution is profiled, and the profile report and the
+     * .. folded call stacks are written to these files at exit, see
+     * .. profile.h. Profiling is done by the interpreter, so it disables the
+     * .. JIT.
+     * */
+    FILE* profileReport;
+    FILE* profileFolded;
+
+    /**
+     * Budgets of the simulation: the number of instructions to execute and
+     * .. the wall-clock time in milliseconds. 0 means no limit.
+     * When a budget runs out, the simulation stops and the state of the
+     * .. virtual machine is reported, to outp and stderr. The time is checked
+     * .. every VM_TIME_CHECK_INTERVAL instructions, and the time blocked in
+     * .. SIO reads counts but cannot be interrupted.
+     * The budgets are enforced by the interpreter, so they disable the JIT.
+     * */
+    long long maxInstructions;
+    long long maxMillis;
+
+    /**
+     * If nonzero and vm_inp is a regular file, vm_inp is memory-mapped
+     * .. instead of being read in chunks, see vmio.h.
+     * */
+    int mapInput;
+
+    /**
+     * If nonzero, which is the default, the interpreter runs the code from
+     * .. a code memory of instructions packed to 32 bits, see packed_code.h,
+     * .. if all of them fit in it. Otherwise, it runs the unpacked
+     * .. instructions.
+     * */
+    int packCode;
+
+    /**
+     * If snapshotPath is not NULL, snapshots of the simulation are written
+     * .. to it, see snapshot.h: every snapshotInterval instructions if it
+     * .. is positive, whenever the process receives SIGUSR1, and when a
+     * .. budget runs out. Each snapshot replaces the previous one.
+     * Snapshots are taken by the interpreter, so they disable the JIT.
+     * */
+    const char* snapshotPath;
+    long long snapshotInterval;
+
+    /**
+     * If not NULL, the simulation is resumed from the snapshot at
+     * .. resumePath instead of starting from the beginning. The code should
+     * .. be the same as the one the snapshot was taken on, and vm_inp and
+     * .. vm_outp should be the same streams, see seekVMIO() of vmio.h.
+     * vm_outp should not be truncated on opening, so that the output up to
+     * .. the snapshot is kept. Only the execution history after the snapshot
+     * .. is written to outp.
+     * */
+    const char* resumePath;
+
+    /**
+     * If not NULL, the metrics of the simulation are added to it, see
+     * .. stats.h: the time spent loading and executing the code, the number
+     * .. of instructions executed, the maximum stack depth and the number of
+     * .. SIO reads and writes.
+     * The instructions are counted by the interpreter, so it disables the
+     * .. JIT.
+     * */
+    Stats* stats;
+} VMOptions;
+
+/**
+ * Number of instructions executed between two checks of the time budget.
+ * Should be a power of 2.
+ * */
+#define VM_TIME_CHECK_INTERVAL 1024
+
+/**
+ * Initializes the options to their defaults.
+ * */
+void initVMOptions(VMOptions*);
+
+/**
+ * Same as simulateVM(), with the given options.
+ * Returns how the simulation ended, VM_HALTED if the program halted.
+ * */
+int simulateVMWithOptions(
+    FILE* inp,
+    FILE* outp,
+    FILE* vm_inp,
+    FILE* vm_outp,
+    VMOptions* options
+);
+
 #endif
\ No newline at end of file
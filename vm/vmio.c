@@ -0,0 +1,220 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "vmio.h"
+
+void initVMIO(VMIO* io, FILE* in, FILE* out, int mapInput)
+{
+    io->in = in;
+    io->out = out;
+
+    io->input = NULL;
+    io->inputLength = 0;
+    io->inputPos = 0;
+    io->inputOffset = 0;
+    io->inputMapped = 0;
+    io->inputEOF = in == NULL;
+
+    io->output = (char*)malloc(VMIO_BUFFER_SIZE);
+    io->outputLength = 0;
+    io->outputOffset = 0;
+
+    io->numberOfReads = 0;
+    io->numberOfWrites = 0;
+
+    // Map the whole input file, if it is a regular file not read from yet
+    struct stat st;
+    if(mapInput && in && ftell(in) == 0 && !fstat(fileno(in), &st) && S_ISREG(st.st_mode) && st.st_size > 0)
+    {
+        void* data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fileno(in), 0);
+
+        if(data != MAP_FAILED)
+        {
+            io->input = (char*)data;
+            io->inputLength = st.st_size;
+            io->inputMapped = 1;
+            io->inputEOF = 1;
+        }
+    }
+
+    if(!io->inputMapped)
+        io->input = (char*)malloc(VMIO_BUFFER_SIZE);
+}
+
+void deleteVMIO(VMIO* io)
+{
+    if(!io) return;
+
+    flushVMIO(io);
+
+    if(io->inputMapped) munmap(io->input, io->inputLength);
+    else                free(io->input);
+
+    free(io->output);
+
+    io->input = io->output = NULL;
+    io->inputLength = io->inputPos = io->outputLength = 0;
+}
+
+void flushVMIO(VMIO* io)
+{
+    if(io->outputLength && io->out)
+    {
+        fwrite(io->output, 1, io->outputLength, io->out);
+        fflush(io->out);
+    }
+
+    io->outputOffset += io->outputLength;
+
+    io->outputLength = 0;
+}
+
+int peekVMChar(VMIO* io);
+
+size_t getVMInputPosition(VMIO* io)
+{
+    return io->inputOffset + io->inputPos;
+}
+
+size_t getVMOutputPosition(VMIO* io)
+{
+    return io->outputOffset + io->outputLength;
+}
+
+int seekVMIO(VMIO* io, size_t inputPosition, size_t outputPosition)
+{
+    int ok = 1;
+
+    // Input
+    if(io->inputMapped)
+    {
+        ok = inputPosition <= io->inputLength;
+        io->inputPos = ok ? inputPosition : io->inputLength;
+    }
+    else if(io->in && lseek(fileno(io->in), inputPosition, SEEK_SET) == (off_t)inputPosition)
+    {
+        io->inputOffset = inputPosition;
+        io->inputLength = io->inputPos = 0;
+        io->inputEOF = 0;
+    }
+    else
+    {
+        // Not seekable, such as a pipe
+        while(getVMInputPosition(io) < inputPosition && peekVMChar(io) != EOF)
+            io->inputPos++;
+
+        ok = getVMInputPosition(io) == inputPosition;
+    }
+
+    // Output
+    flushVMIO(io);
+
+    struct stat st;
+    if(io->out && !fstat(fileno(io->out), &st) && S_ISREG(st.st_mode))
+    {
+        if((size_t)st.st_size < outputPosition || ftruncate(fileno(io->out), outputPosition) || fseek(io->out, outputPosition, SEEK_SET))
+            ok = 0;
+    }
+
+    io->outputOffset = outputPosition;
+
+    return ok ? 0 : -1;
+}
+
+void writeVMInt(VMIO* io, int value)
+{
+    io->numberOfWrites++;
+
+    // Sign, at most 10 digits and the space
+    if(io->outputLength + 12 > VMIO_BUFFER_SIZE)
+        flushVMIO(io);
+
+    char digits[10];
+    int numberOfDigits = 0;
+
+    // Through unsigned, so that INT_MIN can be negated
+    unsigned int v = value < 0 ? 0u - (unsigned int)value : (unsigned int)value;
+
+    do
+    {
+        digits[numberOfDigits++] = '0' + v % 10;
+        v /= 10;
+    } while(v);
+
+    char* p = io->output + io->outputLength;
+
+    if(value < 0) *p++ = '-';
+    while(numberOfDigits) *p++ = digits[--numberOfDigits];
+    *p++ = ' ';
+
+    io->outputLength = p - io->output;
+}
+
+/**
+ * Returns the next input character without consuming it, EOF if there is
+ * .. no more input. Reads the next chunk of the input if required.
+ * */
+int peekVMChar(VMIO* io)
+{
+    if(io->inputPos == io->inputLength)
+    {
+        if(io->inputEOF) return EOF;
+
+        // Reading might block, so the output up to now should be visible
+        flushVMIO(io);
+
+        ssize_t length = read(fileno(io->in), io->input, VMIO_BUFFER_SIZE);
+
+        if(length <= 0)
+        {
+            io->inputEOF = 1;
+            return EOF;
+        }
+
+        io->inputOffset += io->inputLength;
+        io->inputLength = length;
+        io->inputPos = 0;
+    }
+
+    return (unsigned char)io->input[io->inputPos];
+}
+
+int readVMInt(VMIO* io, int* value)
+{
+    int c;
+
+    io->numberOfReads++;
+
+    // Skip the white space
+    while((c = peekVMChar(io)) == ' ' || (c >= '\t' && c <= '\r'))
+        io->inputPos++;
+
+    int negative = 0;
+    if(c == '-' || c == '+')
+    {
+        negative = c == '-';
+        io->inputPos++;
+        c = peekVMChar(io);
+    }
+
+    if(c < '0' || c > '9')
+        return 0;
+
+    // Out of range values saturate, as strtol() does, before being narrowed
+    long long v = 0;
+    while((c = peekVMChar(io)) >= '0' && c <= '9')
+    {
+        if(v <= (LLONG_MAX - 9) / 10) v = v * 10 + (c - '0');
+        else                          v = LLONG_MAX;
+
+        io->inputPos++;
+    }
+
+    *value = (int)(negative ? -v : v);
+    return 1;
+}
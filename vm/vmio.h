@@ -0,0 +1,102 @@
+#ifndef __VMIO_H__
+#define __VMIO_H__
+
+#include <stdio.h>
+#include <stddef.h>
+
+/**
+ * Size of the output buffer, and of the input buffer if the input is not
+ * .. memory-mapped.
+ * */
+#define VMIO_BUFFER_SIZE (64 * 1024)
+
+/**
+ * Input and output streams of the SIO instructions.
+ *
+ * The output is collected in a buffer, formatted without stdio, and written
+ * .. to the output stream when the buffer is full, before the input is
+ * .. read and when flushed.
+ * The input is either the whole input file memory-mapped, or read to a
+ * .. buffer in chunks, as much as available at once. The integers are
+ * .. parsed from there without stdio, the same way fscanf("%d") would.
+ * */
+typedef struct {
+    FILE* in;
+    FILE* out;
+
+    /**
+     * Input not consumed yet is input[inputPos..inputLength).
+     * inputOffset is the offset of input[0] in the input stream.
+     * inputMapped is 1 if input is the mapping of the input file, which is
+     * .. then unmapped on deletion.
+     * */
+    char* input;
+    size_t inputLength;
+    size_t inputPos;
+    size_t inputOffset;
+    int inputMapped;
+    int inputEOF;
+
+    /**
+     * outputOffset is the number of bytes written to the output stream,
+     * .. not including the buffered output.
+     * */
+    char* output;
+    size_t outputLength;
+    size_t outputOffset;
+
+    /**
+     * Number of readVMInt() and writeVMInt() calls.
+     * */
+    long long numberOfReads;
+    long long numberOfWrites;
+} VMIO;
+
+/**
+ * Initializes the I/O on the given streams. If mapInput is nonzero and the
+ * .. input stream is a regular file, the file is memory-mapped.
+ * Nothing should be read from the input stream other than through the VMIO.
+ * */
+void initVMIO(VMIO*, FILE* in, FILE* out, int mapInput);
+
+/**
+ * Flushes the output and makes the necessary deallocations.
+ * */
+void deleteVMIO(VMIO*);
+
+/**
+ * Writes the buffered output to the output stream.
+ * */
+void flushVMIO(VMIO*);
+
+/**
+ * Returns the number of input bytes consumed, and the number of output bytes
+ * .. written including the buffered ones.
+ * */
+size_t getVMInputPosition(VMIO*);
+size_t getVMOutputPosition(VMIO*);
+
+/**
+ * Moves the I/O to the given positions, as returned by the functions above
+ * .. in an earlier run on the same streams, to resume that run.
+ * The input is seeked if possible, otherwise read and discarded up to
+ * .. inputPosition. If the output stream is a regular file, it is truncated
+ * .. to outputPosition, dropping what was written after it. Otherwise the
+ * .. output continues from where it is.
+ * Returns 0 on success, -1 if the input or the output is shorter than the
+ * .. given position.
+ * */
+int seekVMIO(VMIO*, size_t inputPosition, size_t outputPosition);
+
+/**
+ * Writes the integer followed by a space, as fprintf("%d ") would.
+ * */
+void writeVMInt(VMIO*, int value);
+
+/**
+ * Reads an integer to value, as fscanf("%d") would. Returns 1 on success,
+ * .. 0 if there is no integer to read, in which case value is not changed.
+ * */
+int readVMInt(VMIO*, int* value);
+
+#endif